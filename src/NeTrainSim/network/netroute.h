@@ -0,0 +1,57 @@
+/**
+ * @file NetRoute.h
+ * @brief This file contains the declaration of the NetRoute struct.
+ *        The NetRoute struct holds a node sequence through the network
+ *        and its compiled per segment data. A route is immutable once it
+ *        is built, so many trains can share the same route.
+ * @version 0.1
+ */
+
+#ifndef NeTrainSim_NetRoute_h
+#define NeTrainSim_NetRoute_h
+
+#include <memory>
+#include <unordered_map>
+#include "../util/vector.h"
+
+class NetNode; // Forward declaration of NetNode class
+class NetLink; // Forward declaration of NetLink class
+
+/**
+ * @struct NetRoute
+ * @brief A node sequence through the network with its compiled data.
+ *
+ * Segment i of the route starts at node i. The per segment arrays are
+ * filled by Network::compileRoute.
+ */
+struct NetRoute {
+    /** The simulator node IDs of the route */
+    Vector<int> nodeIDs;
+    /** The nodes of the route */
+    Vector<std::shared_ptr<NetNode>> nodes;
+    /** Maps each simulator node ID in the route to its first index in the route */
+    std::unordered_map<int, int> pathIndexByNodeID;
+    /** True if any segment of the route has parallel links. The links of such
+     * routes are selected when the train is loaded. */
+    bool hasParallelLinks = false;
+    /** True if the per segment arrays are filled */
+    bool isCompiled = false;
+
+    /** The cumulative distance from the start of the route to each node */
+    Vector<double> cumLengths;
+    /** The compiled link of each segment. It is null when the segment has
+     * parallel links, so the link is selected when the train reaches it. */
+    Vector<std::shared_ptr<NetLink>> links;
+    /** The grade of each segment in the route direction */
+    Vector<double> grades;
+    /** The curvature of each segment */
+    Vector<double> curvatures;
+    /** The free flow speed of each segment */
+    Vector<double> freeFlowSpeeds;
+    /** The route indices of the nodes where the free flow speed drops, sorted */
+    Vector<int> speedDropPathIndices;
+    /** The lower free flow speed starting at each node in speedDropPathIndices */
+    Vector<double> speedDropSpeeds;
+};
+
+#endif // NeTrainSim_NetRoute_h
@@ -0,0 +1,99 @@
+#include "netroutinggraph.h"
+#include "netnode.h"
+#include "netlink.h"
+#include "../util/error.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+
+NetRoutingGraph::NetRoutingGraph(
+    const std::map<int, std::shared_ptr<NetNode>>& networkNodes) {
+    this->nodes.reserve(networkNodes.size());
+    for (auto& n : networkNodes) {
+        this->indexByNodeID[n.second->id] = this->nodes.size();
+        this->nodes.push_back(n.second);
+    }
+
+    this->offsets.reserve(this->nodes.size() + 1);
+    this->offsets.push_back(0);
+    for (auto& node : this->nodes) {
+        for (auto& connectedNode : node->getNeighbors()) {
+            auto it = this->indexByNodeID.find(connectedNode->id);
+            if (it == this->indexByNodeID.end()) { continue; }
+            this->targets.push_back(it->second);
+            this->weights.push_back(
+                node->linkTo.at(connectedNode).at(0)->length);
+        }
+        this->offsets.push_back(this->targets.size());
+    }
+}
+
+int NetRoutingGraph::getNodeIndex(int nodeID) const {
+    auto it = this->indexByNodeID.find(nodeID);
+    if (it != this->indexByNodeID.end()) {
+        return it->second;
+    }
+    throw std::runtime_error(std::string("Error: ") +
+                             std::to_string(static_cast<int>(
+                                 Error::cannotFindNode)) +
+                             "\nCould not find the simulator node ID: " +
+                             std::to_string(nodeID) + "\n");
+}
+
+std::pair<Vector<std::shared_ptr<NetNode>>, double>
+NetRoutingGraph::shortestPath(int startNodeID, int targetNodeID) const {
+    int startIndex = this->getNodeIndex(startNodeID);
+    int targetIndex = this->getNodeIndex(targetNodeID);
+
+    // the search state of this query only
+    Vector<double> distanceFromStart(this->nodes.size(), INFINITY);
+    Vector<int> previousNode(this->nodes.size(), -1);
+    Vector<bool> visited(this->nodes.size(), false);
+
+    // the heap pops the lowest distance first, and the lowest node
+    // index (simulator ID order) when the distances are equal
+    typedef std::pair<double, int> HeapEntry;
+    std::priority_queue<HeapEntry, std::vector<HeapEntry>,
+                        std::greater<HeapEntry>> heap;
+
+    distanceFromStart[startIndex] = 0.0;
+    heap.push(std::make_pair(0.0, startIndex));
+
+    // keep looping until the target node is reached
+    while (!heap.empty() && !visited[targetIndex]) {
+        HeapEntry current = heap.top();
+        heap.pop();
+        int currentIndex = current.second;
+        // skip the stale entries of the already settled nodes
+        if (visited[currentIndex] ||
+            current.first > distanceFromStart[currentIndex]) { continue; }
+        visited[currentIndex] = true;
+
+        // check all the connected nodes
+        int nextOffset = currentIndex + 1;
+        for (int e = this->offsets[currentIndex];
+             e < this->offsets[nextOffset]; e++) {
+            int connectedIndex = this->targets[e];
+            double newDistance = distanceFromStart[currentIndex] +
+                                 this->weights[e];
+            if (newDistance < distanceFromStart[connectedIndex]) {
+                distanceFromStart[connectedIndex] = newDistance;
+                previousNode[connectedIndex] = currentIndex;
+                heap.push(std::make_pair(newDistance, connectedIndex));
+            }
+        }
+    }
+
+    Vector<std::shared_ptr<NetNode>> path;
+    for (int i = targetIndex; i != -1; i = previousNode[i]) {
+        path.push_back(this->nodes[i]);
+    }
+    std::reverse(path.begin(), path.end());
+    return std::make_pair(path, distanceFromStart[targetIndex]);
+}
+
+int NetRoutingGraph::getNumberOfNodes() const {
+    return this->nodes.size();
+}
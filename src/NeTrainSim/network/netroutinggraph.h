@@ -0,0 +1,84 @@
+/**
+ * @file NetRoutingGraph.h
+ * @brief This file contains the declaration of the NetRoutingGraph class.
+ *        The NetRoutingGraph class holds a compact (CSR) adjacency array of
+ *        the network nodes and answers shortest path queries over it.
+ *        The search state is local to every query, so many queries can
+ *        run at the same time on the same graph.
+ * @version 0.1
+ */
+
+#ifndef NeTrainSim_NetRoutingGraph_h
+#define NeTrainSim_NetRoutingGraph_h
+
+#include "../export.h"
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include "../util/vector.h"
+
+class NetNode; // Forward declaration of NetNode class
+
+/**
+ * @class NetRoutingGraph
+ * @brief The NetRoutingGraph class is a read only routing view of the
+ *        network nodes and their links.
+ */
+class NETRAINSIMCORE_EXPORT NetRoutingGraph {
+private:
+    /** The nodes of the graph, ordered by their simulator ID */
+    Vector<std::shared_ptr<NetNode>> nodes;
+    /** Maps the simulator node ID to its index in the graph */
+    std::unordered_map<int, int> indexByNodeID;
+    /** The start of each node's neighbors in the targets and weights arrays */
+    Vector<int> offsets;
+    /** The graph index of the neighbor at the end of each edge */
+    Vector<int> targets;
+    /** The length of each edge */
+    Vector<double> weights;
+
+    /**
+     * @brief Gets the graph index of a node.
+     * @param nodeID    the simulator node ID.
+     * @return the graph index of the node.
+     * @throws std::runtime_error if the node is not in the graph.
+     */
+    int getNodeIndex(int nodeID) const;
+
+public:
+    /**
+     * @brief Constructs the routing graph of the network nodes.
+     *
+     * Every neighbor of a node becomes one edge weighted by the length of
+     * the first link to that neighbor. The edges of a node keep the order
+     * of the node's neighbors.
+     *
+     * @param networkNodes  the network nodes mapped by their simulator ID.
+     */
+    NetRoutingGraph(const std::map<int, std::shared_ptr<NetNode>>& networkNodes);
+
+    /**
+     * @brief Performs a shortest path search between two nodes.
+     *
+     * The search is a Dijkstra search with a binary heap. Nodes at the
+     * same distance are settled in the order of their simulator IDs.
+     *
+     * @param startNodeID   the simulator ID of the start node.
+     * @param targetNodeID  the simulator ID of the target node.
+     * @return a pair of the nodes forming the shortest path (in order from
+     *         start to target) and the total length of the path. If the
+     *         target cannot be reached, the path holds the target only and
+     *         the length is infinity.
+     */
+    std::pair<Vector<std::shared_ptr<NetNode>>, double> shortestPath(
+        int startNodeID, int targetNodeID) const;
+
+    /**
+     * @brief Gets the number of nodes in the graph.
+     * @return the number of nodes.
+     */
+    int getNumberOfNodes() const;
+};
+
+#endif // NeTrainSim_NetRoutingGraph_h
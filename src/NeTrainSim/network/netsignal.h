@@ -26,6 +26,7 @@
 
 class NetLink; // Forward declaration of NetLink class
 class NetNode; // Forward declaration of NetNode class
+class NetSignalGroupControllerWithQueuing; // Forward declaration of the signal controller class
 
 using namespace std;
 
@@ -46,6 +47,8 @@ public:
     std::weak_ptr<NetLink> link; /**< The link associated with the signal. */
     std::weak_ptr<NetNode> previousNode; /**< The previous node connected to the signal. */
     std::weak_ptr<NetNode> currentNode; /**< The current node connected to the signal. */
+    /** The controller of the signal node, owned by the simulator. nullptr if the node is not controlled. */
+    NetSignalGroupControllerWithQueuing* controller = nullptr;
 
     /**
      * @brief Constructor
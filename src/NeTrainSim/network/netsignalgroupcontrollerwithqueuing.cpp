@@ -4,6 +4,7 @@
 #include "netsignal.h"
 #include "../traindefinition/train.h"
 #include "../util/vector.h"
+#include <algorithm>
 
 // Constructor for the signal controller
 NetSignalGroupControllerWithQueuing::NetSignalGroupControllerWithQueuing(
@@ -16,16 +17,12 @@ NetSignalGroupControllerWithQueuing::NetSignalGroupControllerWithQueuing(
     for (const std::shared_ptr<NetNode> &node : nodes) {
         this->atNodes.push_back(node);
         for (int i = 0; i < node->networkSignals.size(); i++) {
-            if (!this->networkSignalsGroup.exist(
-                    std::shared_ptr<NetSignal>(node->networkSignals.at(i))))
-            {
-                this->networkSignalsGroup.push_back(
-                    std::shared_ptr<NetSignal>(node->networkSignals.at(i)));
-            }
-            this->movements[node->networkSignals.at(i)] = false;
+            this->addSignal(node->networkSignals.at(i));
         }
     }
     timeStamp = -10.0;
+    syncedAt = -10.0;
+    isTimeOrdered = true;
 
     // Setting the timeout to be 5 times the provided time step
     timeout = 5 * timeStep;
@@ -43,18 +40,29 @@ void NetSignalGroupControllerWithQueuing::addNode(
         if (! this->atNodes.exist(node)) {
             this->atNodes.push_back(node);
             for (int i = 0; i < node->networkSignals.size(); i++) {
-                if (! this->networkSignalsGroup.exist(
-                        std::shared_ptr<NetSignal> (
-                            node->networkSignals.at(i)))) {
-                    this->networkSignalsGroup.push_back(
-                        std::shared_ptr<NetSignal>(
-                            node->networkSignals.at(i)));
-                }
+                this->addSignal(node->networkSignals.at(i));
             }
         }
     }
 }
 
+// Method to add a signal to the controller signals
+void NetSignalGroupControllerWithQueuing::addSignal(
+    const std::shared_ptr<NetSignal>& networkSignal) {
+    if (this->signalsIndices.count(networkSignal.get())) { return; }
+    this->signalsIndices[networkSignal.get()] =
+        this->networkSignalsGroup.size();
+    this->networkSignalsGroup.push_back(networkSignal);
+    this->movements.push_back(false);
+}
+
+// Method to get the time a train waits in the queue since
+double NetSignalGroupControllerWithQueuing::getWaitingSince(
+    const std::pair<std::shared_ptr<Train>, double>& waitingTrain) const {
+    // the trains that joined before the last sync wait since the sync
+    return std::max(waitingTrain.second, this->syncedAt);
+}
+
 // Method to update the time step for a specific train
 void NetSignalGroupControllerWithQueuing::updateTimeStep(
     std::shared_ptr<Train> train,
@@ -77,29 +85,28 @@ void NetSignalGroupControllerWithQueuing::updateTimeStep(
 void NetSignalGroupControllerWithQueuing::clearMovements()
 {
     // Set all movements in the network to false
-    for (std::shared_ptr<NetSignal>& netSignal : this->movements.get_keys())
-    {
-        this->movements[netSignal] = false;
-    }
+    std::fill(this->movements.begin(), this->movements.end(), false);
 }
 
 void NetSignalGroupControllerWithQueuing::addTrain(
-    std::shared_ptr<Train> train, double simulatorTime)
+    const std::shared_ptr<Train>& train, double simulatorTime)
 {
     // Add the current train to the queue only if it's not already present
-    if (std::find_if(waitingTrains.begin(),
-                     waitingTrains.end(),
-                     [&](const auto& pair)
-                     { return pair.first == train; }) == waitingTrains.end())
+    if (waitingTrainsIDs.insert(train->id).second)
     {
+        if (!waitingTrains.empty() &&
+            simulatorTime < getWaitingSince(waitingTrains.back()))
+        {
+            isTimeOrdered = false;
+        }
         waitingTrains.push_back(std::make_pair(train, simulatorTime));
     }
 }
 
 // Method to add a train to the queue
 void NetSignalGroupControllerWithQueuing::sendPassRequestToControlTo(
-    std::shared_ptr<Train> train,
-    std::shared_ptr<NetSignal> networkSignal,
+    const std::shared_ptr<Train>& train,
+    const std::shared_ptr<NetSignal>& networkSignal,
     double& simulatorTime,
     Vector<std::shared_ptr<NetSignal>>& sameDirectionSignals)
 {
@@ -107,10 +114,7 @@ void NetSignalGroupControllerWithQueuing::sendPassRequestToControlTo(
     if (waitingTrains.empty()) { return; }
 
     // If the train is not in the queue, ignore the request
-    if (std::find_if(waitingTrains.begin(),
-                     waitingTrains.end(),
-                     [&](const auto& pair)
-                     { return pair.first == train; }) == waitingTrains.end())
+    if (!waitingTrainsIDs.count(train->id))
     {
         return;
     }
@@ -123,9 +127,13 @@ void NetSignalGroupControllerWithQueuing::sendPassRequestToControlTo(
     if ( waitingTrains.front().first->id == train->id ) {
         this->timeStamp = simulatorTime;
         // update that all controlled trains are synced
-        for (auto& pair : waitingTrains) {
-            pair.second = simulatorTime;
+        if (!isTimeOrdered) {
+            for (auto& pair : waitingTrains) {
+                pair.second = simulatorTime;
+            }
+            isTimeOrdered = true;
         }
+        this->syncedAt = simulatorTime;
         this->clearMovements();
         this->setOpenSignals(sameDirectionSignals);
     }
@@ -154,22 +162,48 @@ void NetSignalGroupControllerWithQueuing::clearTimeoutTrains(
     double simulatorTime) {
     if (clearTrainsAt != simulatorTime)
     {
-        // remove all timeout trains
-        std::erase_if(waitingTrains, [this, simulatorTime](const auto& pair) {
-            return simulatorTime - pair.second > timeout;
-        });
+        auto isTimeout = [this, simulatorTime](const auto& pair) {
+            return simulatorTime - getWaitingSince(pair) > timeout;
+        };
+
+        if (isTimeOrdered) {
+            // the trains wait in the queue order, so the timeout trains
+            // are at the front and the queue is only checked until the
+            // first train that has not timed out
+            while (!waitingTrains.empty() && isTimeout(waitingTrains.front())) {
+                waitingTrainsIDs.erase(waitingTrains.front().first->id);
+                waitingTrains.pop_front();
+            }
+        }
+        else {
+            // remove all timeout trains
+            std::erase_if(waitingTrains, [&](const auto& pair) {
+                if (!isTimeout(pair)) { return false; }
+                waitingTrainsIDs.erase(pair.first->id);
+                return true;
+            });
+            if (waitingTrains.empty()) { isTimeOrdered = true; }
+        }
 
         clearTrainsAt = simulatorTime;
     }
 }
 
+// Method to check if any train is waiting to pass
+bool NetSignalGroupControllerWithQueuing::hasWaitingTrains() const {
+    return !waitingTrains.empty();
+}
+
 
 // Method to set open signals
 void NetSignalGroupControllerWithQueuing::setOpenSignals(
     Vector<std::shared_ptr<NetSignal>>& sameDirectionSignals) {
     // Mark all signals in the same direction as true
     for (std::shared_ptr<NetSignal>& netSignal : sameDirectionSignals) {
-        this->movements[netSignal] = true;
+        // the same direction signals are of this controller
+        auto it = this->signalsIndices.find(netSignal.get());
+        if (it == this->signalsIndices.end()) { continue; }
+        this->movements[it->second] = true;
     }
 }
 
@@ -184,19 +218,19 @@ std::pair<Vector<std::shared_ptr<NetSignal> >,
     // check if there is any waiting trains first
     // if non, return all signals are green
     if (waitingTrains.size() == 0) {
-        return std::make_pair(this->movements.get_keys(), otherDirection);
+        return std::make_pair(this->networkSignalsGroup, otherDirection);
     }
 
     // For each signal, if it's moving in the same direction,
     // add it to the sameDirection vector.
     // If it's moving in the other direction, add it to the
     // otherDirection vector.
-    for (std::shared_ptr<NetSignal>& netSignal : this->movements.get_keys()) {
-        if (this->movements[netSignal] == true) {
-            sameDirection.push_back(netSignal);
+    for (int i = 0; i < this->networkSignalsGroup.size(); i++) {
+        if (this->movements[i]) {
+            sameDirection.push_back(this->networkSignalsGroup.at(i));
         }
         else {
-            otherDirection.push_back(netSignal);
+            otherDirection.push_back(this->networkSignalsGroup.at(i));
         }
     }
     // Return a pair of vectors: one with signals moving in the
@@ -216,6 +250,19 @@ void NetSignalGroupControllerWithQueuing::turnOffSignals(
     }
 }
 
+// Method to turn off the signals that are not open without
+// building the feedback vectors
+void NetSignalGroupControllerWithQueuing::turnOffOtherDirectionSignals(
+    Vector<std::shared_ptr<NetSignal>>& turnedOffSignals) {
+    if (waitingTrains.empty()) { return; }
+    for (int i = 0; i < this->networkSignalsGroup.size(); i++) {
+        std::shared_ptr<NetSignal>& netSignal = this->networkSignalsGroup.at(i);
+        if (this->movements[i] || !netSignal->isGreen) { continue; }
+        netSignal->isGreen = false;
+        turnedOffSignals.push_back(netSignal);
+    }
+}
+
 // Method to get all signals controlled by the controller
 Vector<std::shared_ptr<NetSignal>> NetSignalGroupControllerWithQueuing::
                                                         getControllerSignals() {
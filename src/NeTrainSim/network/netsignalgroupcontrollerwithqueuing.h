@@ -29,6 +29,9 @@
 #include <deque>
 #include <memory>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 class NetLink; // Forward declaration of NetLink class
 class NetNode; // Forward declaration of NetNode class
@@ -46,17 +49,34 @@ private:
     // Timeout for network signal in seconds.
     double timeout;
 
-    // Queue of waiting trains along with their associated timestamps.
+    // Queue of waiting trains in their arrival order along with the time
+    // they joined the queue. The trains synced at syncedAt are waiting
+    // since then.
     std::deque<std::pair<std::shared_ptr<Train>, double>> waitingTrains;
 
+    // The IDs of the waiting trains, for constant time membership checks.
+    std::unordered_set<int> waitingTrainsIDs;
+
+    // The time all the waiting trains were last synced at.
+    double syncedAt;
+
+    // True while the waiting times do not decrease along the queue, so
+    // the timed out trains are at its front. It only turns false if the
+    // simulation time goes back (the simulation restarted).
+    bool isTimeOrdered;
+
     // Collection of network signals associated with this controller.
     Vector<std::shared_ptr<NetSignal>> networkSignalsGroup;
 
+    // The index of each signal in networkSignalsGroup.
+    std::unordered_map<const NetSignal*, int> signalsIndices;
+
     // Collection of nodes that this controller is associated with.
     Vector<std::shared_ptr<NetNode>> atNodes;
 
-    // Map tracking the movement status of different network signals.
-    Map<std::shared_ptr<NetSignal>, bool> movements;
+    // Bitset of the movement status of the signals in networkSignalsGroup,
+    // true if the signal is open.
+    std::vector<bool> movements;
 
     // The timestamp at which the controller last updated.
     double timeStamp;
@@ -104,7 +124,7 @@ public:
      * @param train Shared pointer to a Train.
      * @param simulatorTime Simulation time.
      */
-    void addTrain(std::shared_ptr<Train> train, double simulatorTime);
+    void addTrain(const std::shared_ptr<Train>& train, double simulatorTime);
 
     /**
      * Send Pass Request to Control
@@ -117,12 +137,22 @@ public:
      * @param simulatorTime Reference to simulation time.
      * @param sameDirectionSignals Vector of shared pointers to NetSignal.
      */
-    void sendPassRequestToControlTo(std::shared_ptr<Train> train,
-                                    std::shared_ptr<NetSignal> networkSignal,
+    void sendPassRequestToControlTo(const std::shared_ptr<Train>& train,
+                                    const std::shared_ptr<NetSignal>& networkSignal,
                                     double& simulatorTime,
                                     Vector<std::shared_ptr<NetSignal>> &sameDirectionSignals);
 
     void clearTimeoutTrains(double simulatorTime);
+
+    /**
+     * Checks if any train is waiting in the controller queue. A controller
+     * with no waiting trains ignores the pass requests and keeps all its
+     * signals on.
+     *
+     * @return true if the queue is not empty.
+     */
+    bool hasWaitingTrains() const;
+
     /**
      * Update Time Step
      *
@@ -160,6 +190,16 @@ public:
      */
     void turnOffSignals(Vector<std::shared_ptr<NetSignal>> turnOffSignals);
 
+    /**
+     * Turns off the signals that are not open for the highest priority
+     * train, the same signals getFeedback() returns in the other direction.
+     * Nothing is turned off if no train is waiting.
+     *
+     * @param turnedOffSignals Holds the signals that were green and are
+     *                         turned off, the signals are appended.
+     */
+    void turnOffOtherDirectionSignals(Vector<std::shared_ptr<NetSignal>>& turnedOffSignals);
+
 
 private:
     /**
@@ -179,6 +219,21 @@ private:
      * @date 7/5/2023
      */
     void clearMovements();
+
+    /**
+     * Adds a signal to the controller signals if it is not added yet.
+     *
+     * @param networkSignal Shared pointer to a NetSignal.
+     */
+    void addSignal(const std::shared_ptr<NetSignal>& networkSignal);
+
+    /**
+     * Gets the time a train waits in the queue since.
+     *
+     * @param waitingTrain The queue entry of the train.
+     * @return the time the train joined or was last synced at.
+     */
+    double getWaitingSince(const std::pair<std::shared_ptr<Train>, double>& waitingTrain) const;
 };
 
 #endif // NETSIGNALGROUPCONTROLLERWITHQUEUING_H
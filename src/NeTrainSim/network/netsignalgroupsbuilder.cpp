@@ -0,0 +1,177 @@
+#include "netsignalgroupsbuilder.h"
+
+#include "netlink.h"
+#include "netnode.h"
+#include "network.h"
+#include "../traindefinition/train.h"
+#include <algorithm>
+
+namespace {
+
+// Checks if all the nodes of a train path are in another train path
+bool isPathSubsetOf(const std::shared_ptr<Train>& train,
+                    const std::shared_ptr<Train>& otherTrain) {
+    for (int nodeID : train->trainPath) {
+        if (otherTrain->getPathIndex(nodeID) < 0) { return false; }
+    }
+    return true;
+}
+
+}
+
+int NetSignalGroupsBuilder::getTrainsCount() const {
+    return this->trainsCount;
+}
+
+int NetSignalGroupsBuilder::getPathID(const std::shared_ptr<Train>& train) {
+    auto [it, isNew] = this->pathIDs.emplace(train->trainPath,
+                                             this->pathTrains.size());
+    if (isNew) {
+        this->pathTrains.push_back(train);
+        this->isPathCompared.push_back(false);
+    }
+    return it->second;
+}
+
+NetSignalGroupsBuilder::PathSegments& NetSignalGroupsBuilder::getPathSegments(
+    Network* network, int pathID) {
+    auto it = this->pathsSegments.find(pathID);
+    if (it != this->pathsSegments.end()) { return it->second; }
+
+    // the parallel links are measured for the first train on the path
+    std::shared_ptr<Train>& t = this->pathTrains.at(pathID);
+    PathSegments segments;
+    for (int i = 0; i + 1 < t->trainPathNodes.size(); i++) {
+        int nextI = i + 1;
+        std::shared_ptr<NetNode>& node = t->trainPathNodes.at(i);
+        std::shared_ptr<NetNode>& nextNode = t->trainPathNodes.at(nextI);
+        segments.lengths.push_back(network->getLinkByStartandEndNodeID(
+            t, node->id, nextNode->id, true)->length);
+        std::set<std::shared_ptr<NetLink>> links;
+        links.insert(node->linkTo[nextNode].begin(),
+                     node->linkTo[nextNode].end());
+        links.insert(nextNode->linkTo[node].begin(),
+                     nextNode->linkTo[node].end());
+        segments.conflicts.push_back(links.size() <= 1);
+    }
+    return this->pathsSegments.emplace(pathID, segments).first->second;
+}
+
+void NetSignalGroupsBuilder::intersectPaths(Network* network, int pathID,
+                                            int otherPathID,
+                                            std::set<int>& changedNodes) {
+    if (!this->intersectedPaths.insert({pathID, otherPathID}).second) {
+        return;
+    }
+    std::shared_ptr<Train>& t1 = this->pathTrains.at(pathID);
+    std::shared_ptr<Train>& t2 = this->pathTrains.at(otherPathID);
+
+    // the nodes with signals on both paths, in the first path order
+    Vector<std::shared_ptr<NetNode>> intersections;
+    for (std::shared_ptr<NetNode>& node : t1->trainPathNodes) {
+        if (node->networkSignals.size() > 0 &&
+            t2->getPathIndex(node->id) >= 0) {
+            intersections.push_back(node);
+        }
+    }
+    if (intersections.size() < 2) { return; }
+
+    // if the distance between two intersections is short or the section
+    // has only 1 link, it is a conflict and should be controlled by one
+    // controller
+    PathSegments& segments = this->getPathSegments(network, pathID);
+    for (int i = 0; i + 1 < intersections.size(); i++) {
+        int nextI = i + 1;
+        std::shared_ptr<NetNode>& node = intersections.at(i);
+        std::shared_ptr<NetNode>& nextNode = intersections.at(nextI);
+        int i1 = t1->getPathIndex(node->id);
+        int i2 = t1->getPathIndex(nextNode->id);
+        if (i1 > i2) { std::swap(i1, i2); }
+        double d = 0.0;
+        bool isConflictZone = false;
+        for (int j = i1; j < i2; j++) {
+            d += segments.lengths.at(j);
+            isConflictZone = isConflictZone || segments.conflicts.at(j);
+        }
+        this->nodesByID[node->id] = node;
+        this->nodesByID[nextNode->id] = nextNode;
+        bool isChanged = false;
+        if (d < this->groupsMinSafeDistance || isConflictZone) {
+            isChanged = this->nodesGroups.unite(node->id, nextNode->id);
+        }
+        else {
+            isChanged = this->nodesGroups.insert(node->id);
+            isChanged = this->nodesGroups.insert(nextNode->id) || isChanged;
+        }
+        if (isChanged) {
+            changedNodes.insert(node->id);
+            changedNodes.insert(nextNode->id);
+        }
+    }
+}
+
+Vector<std::set<std::shared_ptr<NetNode>>> NetSignalGroupsBuilder::update(
+    Network* network,
+    const QVector<std::shared_ptr<Train>>& trains,
+    double minSafeDistance) {
+
+    // the sections are measured against the longer distance, so all the
+    // trains are compared again
+    if (minSafeDistance > this->groupsMinSafeDistance) {
+        this->groupsMinSafeDistance = minSafeDistance;
+        this->trainsCount = 0;
+        this->comparedPaths.clear();
+        this->intersectedPaths.clear();
+        std::fill(this->isPathCompared.begin(), this->isPathCompared.end(),
+                  false);
+    }
+
+    std::set<int> changedNodes;
+    for (int k = this->trainsCount; k < trains.size(); k++) {
+        const std::shared_ptr<Train>& t = trains.at(k);
+        int pathID = this->getPathID(t);
+
+        // the train is intersected with the compared trains before it
+        for (int comparedPathID : this->comparedPaths) {
+            this->intersectPaths(network, comparedPathID, pathID,
+                                 changedNodes);
+        }
+
+        // a train is compared to all the trains after it, unless it reached
+        // its destination or its path is a subset or a superset of the
+        // previous train path. only the first compared train of a path
+        // matters, the trains after it include the trains after the other
+        // trains of the path
+        if (t->reachedDestination || this->isPathCompared[pathID]) {
+            continue;
+        }
+        if (k > 0) {
+            const std::shared_ptr<Train>& prevT = trains.at(k - 1);
+            if (isPathSubsetOf(t, prevT) || isPathSubsetOf(prevT, t)) {
+                continue;
+            }
+        }
+        this->isPathCompared[pathID] = true;
+        this->comparedPaths.push_back(pathID);
+    }
+    this->trainsCount = trains.size();
+
+    // the groups holding the changed nodes
+    Vector<std::set<std::shared_ptr<NetNode>>> changedGroups;
+    if (changedNodes.empty()) { return changedGroups; }
+    std::set<int> changedRoots;
+    for (int nodeID : changedNodes) {
+        changedRoots.insert(this->nodesGroups.find(nodeID));
+    }
+    for (const std::vector<int>& group : this->nodesGroups.getSets()) {
+        if (!changedRoots.count(this->nodesGroups.find(group.front()))) {
+            continue;
+        }
+        std::set<std::shared_ptr<NetNode>> nodes;
+        for (int nodeID : group) {
+            nodes.insert(this->nodesByID.at(nodeID));
+        }
+        changedGroups.push_back(nodes);
+    }
+    return changedGroups;
+}
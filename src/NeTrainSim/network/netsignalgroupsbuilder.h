@@ -0,0 +1,118 @@
+/**
+ * @file NetSignalGroupsBuilder.h
+ * @brief This file contains the declaration of the NetSignalGroupsBuilder
+ *        class.
+ *        The builder groups the network nodes with signals that should be
+ *        controlled by one signals group controller. The nodes with signals
+ *        two trains paths share are grouped with the next shared node along
+ *        the path if it is closer than the minimum safe distance or if the
+ *        section between them has a single link. The groups sharing nodes
+ *        are merged.
+ *        The trains are grouped incrementally: the trains added to the
+ *        simulator after an update only intersect their paths with the
+ *        paths grouped before, and only the groups they change are
+ *        returned.
+ * @version 0.1
+ */
+
+#ifndef NeTrainSim_NetSignalGroupsBuilder_h
+#define NeTrainSim_NetSignalGroupsBuilder_h
+
+#include "../util/disjointset.h"
+#include "../util/vector.h"
+#include <QVector>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Network; // Forward declaration of Network class
+class NetNode; // Forward declaration of NetNode class
+class Train;   // Forward declaration of a train
+
+/**
+ * @class NetSignalGroupsBuilder
+ * @brief Groups the signal nodes of the simulator trains paths.
+ */
+class NetSignalGroupsBuilder
+{
+public:
+    /**
+     * @brief Groups the signal nodes of the trains added since the last
+     * update. A train is intersected with the trains before it, the trains
+     * on the same path are intersected once.
+     * If the minimum safe distance grows, all the trains are intersected
+     * again. The groups never split.
+     *
+     * @param network           The network the trains run on.
+     * @param trains            The simulator trains, the trains of the
+     *                          previous updates first and in the same order.
+     * @param minSafeDistance   The minimum safe distance between two
+     *                          separately controlled nodes.
+     * @return The groups this update created or changed, each with all
+     *         its nodes.
+     */
+    Vector<std::set<std::shared_ptr<NetNode>>> update(
+        Network* network,
+        const QVector<std::shared_ptr<Train>>& trains,
+        double minSafeDistance);
+
+    /**
+     * @brief Gets the number of simulator trains grouped so far.
+     * @return The number of trains.
+     */
+    int getTrainsCount() const;
+
+private:
+    /** The segments of a path */
+    struct PathSegments {
+        /** The length of each segment */
+        Vector<double> lengths;
+        /** True if the segment has a single link, it is a conflict zone */
+        Vector<bool> conflicts;
+    };
+
+    /** The ID of each distinct path */
+    std::map<std::vector<int>, int> pathIDs;
+    /** The first train of each distinct path */
+    Vector<std::shared_ptr<Train>> pathTrains;
+    /** True for the paths of the compared trains */
+    Vector<bool> isPathCompared;
+    /** The paths of the compared trains, a compared train is
+     * intersected with all the trains after it */
+    Vector<int> comparedPaths;
+    /** The pairs of paths intersected already */
+    std::set<std::pair<int, int>> intersectedPaths;
+    /** The segments of the compared paths */
+    std::unordered_map<int, PathSegments> pathsSegments;
+    /** The groups of the signal nodes over the node IDs */
+    DisjointSet nodesGroups;
+    /** The grouped nodes by their IDs */
+    std::unordered_map<int, std::shared_ptr<NetNode>> nodesByID;
+    /** The number of simulator trains grouped so far */
+    int trainsCount = 0;
+    /** The minimum safe distance the trains were grouped with */
+    double groupsMinSafeDistance = -1.0;
+
+    /**
+     * @brief Gets the ID of a train path, the path is added if it is new.
+     */
+    int getPathID(const std::shared_ptr<Train>& train);
+
+    /**
+     * @brief Gets the segments of a path, they are measured once.
+     */
+    PathSegments& getPathSegments(Network* network, int pathID);
+
+    /**
+     * @brief Groups the signal nodes two paths share, in the first path
+     * order.
+     * @param changedNodes  Holds the IDs of the nodes added or merged.
+     */
+    void intersectPaths(Network* network, int pathID, int otherPathID,
+                        std::set<int>& changedNodes);
+};
+
+#endif // NeTrainSim_NetSignalGroupsBuilder_h
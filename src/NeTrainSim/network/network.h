@@ -7,13 +7,18 @@
 #include <cmath>
 #include "../util/vector.h"
 #include <set>
+#include <mutex>
+#include <unordered_map>
 #include "netnode.h"
 #include "netlink.h"
 #include "netsignal.h"
+#include "netroutinggraph.h"
+#include "netroute.h"
 #include "../traindefinition/train.h"
 #include "../util/utils.h"
 #include "../util/error.h"
 #include "readwritenetwork.h"
+#include "networksnapshot.h"
 
 /**
  * This class defined a network for trains.
@@ -24,6 +29,16 @@ class NETRAINSIMCORE_EXPORT Network {
 private:
     /** The file nodes */
     Vector<std::shared_ptr<NetNode>> theFileNodes;
+    /** The file nodes mapped by their user id */
+    std::unordered_map<int, std::shared_ptr<NetNode>> nodesByUserID;
+    /** The routing graph, built on the first shortest path search */
+    std::shared_ptr<NetRoutingGraph> routingGraph;
+    /** Guards building the routing graph */
+    std::mutex routingGraphMutex;
+    /** The shortest routes mapped by their start and end simulator node IDs */
+    std::map<std::pair<int, int>, std::shared_ptr<const NetRoute>> routesCache;
+    /** Guards the routes cache */
+    std::mutex routesCacheMutex;
 public:
     /** Holds the name of the network. */
     std::string networkName;
@@ -63,14 +78,31 @@ public:
         else {
             this->networkName = netName;
         }
-        auto nodesRecords = ReadWriteNetwork::readNodesFile(nodesFile);
-        this->theFileNodes = ReadWriteNetwork::generateNodes(nodesRecords);
-        auto linksRecords = ReadWriteNetwork::readLinksFile(linksFile);
-        this->links = ReadWriteNetwork::generateLinks(this->theFileNodes,
-                                                      linksRecords);
+        // read the binary snapshot if it was built from the same text
+        // files, otherwise parse the text files and refresh the snapshot
+        std::string snapshotFile =
+            NetworkSnapshot::getSnapshotFilename(linksFile);
+        bool isSnapshotRead =
+            NetworkSnapshot::isSnapshotUpToDate(snapshotFile, nodesFile,
+                                                linksFile) &&
+            NetworkSnapshot::readSnapshot(snapshotFile, this->theFileNodes,
+                                          this->links);
+        if (!isSnapshotRead) {
+            auto nodesRecords = ReadWriteNetwork::readNodesFile(nodesFile);
+            this->theFileNodes =
+                ReadWriteNetwork::generateNodes(nodesRecords);
+            auto linksRecords = ReadWriteNetwork::readLinksFile(linksFile);
+            this->links = ReadWriteNetwork::generateLinks(this->theFileNodes,
+                                                          linksRecords);
+        }
         updateLinksLength();
+        if (!isSnapshotRead) {
+            NetworkSnapshot::writeSnapshot(snapshotFile, nodesFile, linksFile,
+                                           this->theFileNodes, this->links);
+        }
         defineNodesLinks();
         this->nodes = defineNodes();
+        defineUserIDIndex();
         //this->AdjMatrix = defineAdjMatrix();
         this->networkSignals = generateSignals();
 
@@ -103,6 +135,7 @@ public:
         updateLinksLength();
         defineNodesLinks();
         this->nodes = defineNodes();
+        defineUserIDIndex();
         //this->AdjMatrix = defineAdjMatrix();
         this->networkSignals = generateSignals();
     }
@@ -132,6 +165,7 @@ public:
         updateLinksLength();
         defineNodesLinks();
         this->nodes = defineNodes();
+        defineUserIDIndex();
         //this->AdjMatrix = defineAdjMatrix();
         this->networkSignals = generateSignals();
     }
@@ -151,6 +185,17 @@ public:
         return nodesMap;
     }
 
+    /**
+     * @brief Maps the nodes by their user ids, so the loading paths
+     * translate the user ids in constant time.
+     *
+     * If two nodes share a user id, the first one is kept.
+     */
+    void defineUserIDIndex() {
+        this->nodesByUserID =
+            ReadWriteNetwork::indexNodesByUserID(this->theFileNodes);
+    }
+
     /**
      * Gets simulator train path
      * @author	Ahmed
@@ -381,9 +426,9 @@ public:
         for (unsigned long long i = 0; i < train->trainPath.size() - 1; i++) {
             // Check if travelled distance is between the cumulative
             // lengths of consecutive links
-            if (travelledDistance > train->linksCumLengths[i] &&
+            if (travelledDistance > train->route->cumLengths[i] &&
                 (i == train->trainPath.size() - 2 ||
-                      travelledDistance <= train->linksCumLengths[i+1])) {
+                      travelledDistance <= train->route->cumLengths[i+1])) {
                 unsigned long long nextI = i + 1;
 
                 // Get the start node and the link on which the train is
@@ -395,7 +440,7 @@ public:
 
                 // Calculate the distance travelled on the current link
                 double travelledDistanceOnLink =
-                    travelledDistance - train->linksCumLengths[i];
+                    travelledDistance - train->route->cumLengths[i];
 
                 // Calculate and return the position on the current vector
                 // based on the distance travelled on the link
@@ -580,8 +625,8 @@ public:
     std::shared_ptr <NetLink> getLinkByStartNodeID(
                 const std::shared_ptr <Train> train,
                 int startNodeID) {
-        unsigned long long i = train->trainPath.index(startNodeID);
-        if (i < train->trainPath.size() - 1) {
+        int i = train->getPathIndex(startNodeID);
+        if (i >= 0 && i < train->trainPath.size() - 1) {
             unsigned long long indx = i + 1;
             unsigned long long EndNodeID = train->trainPath.at(indx);
             return getLinkByStartandEndNodeID(train, startNodeID, EndNodeID);
@@ -618,26 +663,166 @@ public:
     }
 
     /**
-     * @brief Generates a vector containing the cumulative lengths of the
-     * train's path.
+     * @brief Builds the route of a node sequence.
      *
-     * The function iterates over the train's path and for each node,
-     * calculates the cumulative distance from the start node to this node.
-     * The result is stored in a vector which is then returned.
+     * The function resolves the nodes and the path index table of the
+     * route. If no segment of the route has parallel links, the route is
+     * compiled as well, since its links do not depend on the trains.
      *
-     * @param train A shared pointer to the train object.
-     * @returns A vector of doubles containing the cumulative lengths of the
-     *          links in the train's path.
+     * @param nodeIDs The simulator node IDs of the route.
+     * @returns A shared pointer to the immutable route.
+     */
+    std::shared_ptr<const NetRoute> buildRoute(const Vector<int>& nodeIDs) {
+        auto route = std::make_shared<NetRoute>();
+        route->nodeIDs = nodeIDs;
+        route->nodes.reserve(nodeIDs.size());
+        route->pathIndexByNodeID.reserve(nodeIDs.size());
+        for (int i = 0; i < nodeIDs.size(); i++) {
+            int nodeID = nodeIDs[i];
+            route->nodes.push_back(this->getNodeByID(nodeID));
+            // keep the first occurrence to match Vector::index()
+            route->pathIndexByNodeID.emplace(nodeID, i);
+        }
+        for (int i = 1; i < route->nodes.size(); i++) {
+            int prevI = i - 1;
+            if (route->nodes[prevI]->linkTo.at(route->nodes[i]).size() > 1) {
+                route->hasParallelLinks = true;
+                break;
+            }
+        }
+        if (!route->hasParallelLinks) {
+            this->compileRoute(*route, nullptr);
+        }
+        return route;
+    }
+
+    /**
+     * @brief Gets the shortest route between two nodes.
+     *
+     * The routes are cached by their start and end nodes, so trains that
+     * travel between the same nodes share one route and one search.
+     *
+     * @param startNodeID The simulator ID of the start node.
+     * @param targetNodeID The simulator ID of the target node.
+     * @returns A shared pointer to the immutable route.
+     */
+    std::shared_ptr<const NetRoute> getShortestRoute(int startNodeID,
+                                                     int targetNodeID) {
+        std::pair<int, int> key = std::make_pair(startNodeID, targetNodeID);
+        {
+            std::lock_guard<std::mutex> lock(this->routesCacheMutex);
+            auto it = this->routesCache.find(key);
+            if (it != this->routesCache.end()) { return it->second; }
+        }
+
+        Vector<int> nodeIDs;
+        for (auto &n : this->shortestPathSearch(startNodeID,
+                                                targetNodeID).first) {
+            nodeIDs.push_back(n->id);
+        }
+        std::shared_ptr<const NetRoute> route = this->buildRoute(nodeIDs);
+
+        // keep the route that was cached first if another search won
+        std::lock_guard<std::mutex> lock(this->routesCacheMutex);
+        return this->routesCache.emplace(key, route).first->second;
+    }
+
+    /**
+     * @brief Drops the routing graph and the cached routes.
+     *
+     * Call it after changing the links attributes (length, speed, grade),
+     * so the next searches use the new values. The trains keep the routes
+     * they already hold.
+     */
+    void invalidateRoutes() {
+        {
+            std::lock_guard<std::mutex> lock(this->routingGraphMutex);
+            this->routingGraph.reset();
+        }
+        std::lock_guard<std::mutex> lock(this->routesCacheMutex);
+        this->routesCache.clear();
+    }
+
+    /**
+     * @brief Compiles a route into flat per segment arrays.
+     *
+     * The function walks the route once, resolves the link of each
+     * segment and fills the cumulative lengths, directional grades,
+     * curvatures and free flow speeds of the route, and the sorted list of
+     * the nodes where the free flow speed drops. Segments that have
+     * parallel links keep a null link so the simulator still selects the
+     * link when the train reaches them.
+     *
+     * @param route The route to compile.
+     * @param train The train the links of the parallel segments are
+     *              selected for. It can be null if the route has no
+     *              parallel links.
      */
-    Vector<double> generateCumLinksLengths(std::shared_ptr<Train> train) {
-        auto n = train->trainPath.size();
-        Vector<double> linksCumLengths(n, 0);
+    void compileRoute(NetRoute& route, std::shared_ptr<Train> train) {
+        auto n = route.nodeIDs.size();
+        route.cumLengths = Vector<double>(n, 0);
+        route.links.clear();
+        route.grades.clear();
+        route.curvatures.clear();
+        route.freeFlowSpeeds.clear();
+        route.speedDropPathIndices.clear();
+        route.speedDropSpeeds.clear();
+        route.isCompiled = true;
+        if (n < 2) { return; }
+        route.links.reserve(n - 1);
+        route.grades.reserve(n - 1);
+        route.curvatures.reserve(n - 1);
+        route.freeFlowSpeeds.reserve(n - 1);
+
+        double l = 0.0;
         for (unsigned long long i = 1; i < n; i++) {
-            linksCumLengths[i] =
-                getDistanceToSpecificNodeFromStart(train,
-                                                   train->trainPath.at(i));
+            int prevI = i - 1;
+            int startID = route.nodeIDs.at(prevI);
+            int endID = route.nodeIDs.at(i);
+            std::shared_ptr<NetLink> link =
+                getLinkByStartandEndNodeID(train, startID, endID, true);
+            l += link->length;
+            route.cumLengths[i] = l;
+
+            // the grade is defined from the link end the train reaches first
+            int gradeNodeID = (route.pathIndexByNodeID.at(link->fromLoc->id) <
+                               route.pathIndexByNodeID.at(link->toLoc->id)) ?
+                                  link->fromLoc->id : link->toLoc->id;
+            bool isSingleLink = route.nodes.at(prevI)->linkTo.at(
+                                    route.nodes.at(i)).size() == 1;
+
+            route.links.push_back(isSingleLink ? link : nullptr);
+            route.grades.push_back(link->grade.at(gradeNodeID));
+            route.curvatures.push_back(link->curvature);
+            route.freeFlowSpeeds.push_back(link->freeFlowSpeed);
+        }
+
+        // the nodes where the free flow speed drops from the previous segment
+        for (unsigned long long i = 1; i < route.freeFlowSpeeds.size(); i++) {
+            int prevI = i - 1;
+            if (route.freeFlowSpeeds[i] < route.freeFlowSpeeds[prevI]) {
+                route.speedDropPathIndices.push_back(i);
+                route.speedDropSpeeds.push_back(route.freeFlowSpeeds[i]);
+            }
         }
-        return linksCumLengths;
+    }
+
+    /**
+     * @brief Compiles the train's route when the train is loaded.
+     *
+     * Routes without parallel links are compiled once when they are built
+     * and stay shared. The links of a route with parallel links depend on
+     * the trains on the network, so the train gets its own compiled copy.
+     *
+     * @param train A shared pointer to the train object.
+     */
+    void compileTrainRoute(std::shared_ptr<Train> train) {
+        if (train->route->isCompiled && !train->route->hasParallelLinks) {
+            return;
+        }
+        auto compiled = std::make_shared<NetRoute>(*train->route);
+        this->compileRoute(*compiled, train);
+        train->route = compiled;
     }
 
     /**
@@ -660,9 +845,9 @@ public:
                                     double travelledDistance,
                                     int &previousNodeID) {
         int nextI = -1;
-        for (int i = train->trainPath.index(previousNodeID);
-                                    train->trainPath.size(); i++) {
-            if (train->linksCumLengths.at(i) > travelledDistance) {
+        for (int i = train->getPathIndex(previousNodeID);
+                                    i < train->trainPath.size(); i++) {
+            if (train->route->cumLengths.at(i) > travelledDistance) {
                 nextI = i;
                 break;
             }
@@ -673,46 +858,83 @@ public:
     }
 
     /**
-     * @brief Retrieves the link in the train's path that includes a specified
-     * travelled distance.
+     * @brief Retrieves the segment of the train's path that includes a
+     * specified travelled distance.
      *
      * This function iterates over the train's path until it finds the node
      * whose cumulative distance is greater than the travelled distance.
-     * The function then retrieves the link from the previous node to this one.
+     * The segment starts at the node prior to this one.
      *
      * @param train The train object.
      * @param travelledDistance The distance that has been travelled.
-     * @param previousNodeID An input/output parameter that will store the ID
-     *                       of the previous node.
-     * @returns A shared pointer to the NetLink object that includes the
-     *          travelled distance.
+     * @param previousNodeID The ID of a node the train already passed, the
+     *                       search starts from it.
+     * @returns The path index of the start node of the segment.
      */
-    std::shared_ptr <NetLink> getLinkFromDistance(std::shared_ptr <Train> train,
-                                                 double &travelledDistance,
-                                                 int &previousNodeID) {
+    int getPathSegmentFromDistance(std::shared_ptr <Train> train,
+                                   double &travelledDistance,
+                                   int &previousNodeID) {
         int nextI = -1;
-        for (unsigned long long i = train->trainPath.index(previousNodeID);
+        for (int i = train->getPathIndex(previousNodeID);
              i < train->trainPath.size(); i++) {
-            if (train->linksCumLengths.at(i) > travelledDistance) {
+            if (train->route->cumLengths.at(i) > travelledDistance) {
                 nextI = i;
                 break;
             }
         }
         if (nextI == -1) { nextI = train->trainPath.size() - 1; }
-        int prevI = nextI - 1;
+        return nextI - 1;
+    }
+
+    /**
+     * @brief Retrieves the link of a segment of the train's path.
+     *
+     * The compiled link is returned if the segment has a single link,
+     * otherwise the link is selected between the segment nodes.
+     *
+     * @param train The train object.
+     * @param segment The path index of the start node of the segment.
+     * @returns A shared pointer to the NetLink object of the segment.
+     */
+    std::shared_ptr <NetLink> getLinkByPathSegment(std::shared_ptr <Train> train,
+                                                   int segment) {
+        if (segment < train->route->links.size() &&
+            train->route->links[segment] != nullptr) {
+            return train->route->links[segment];
+        }
+        int nextI = segment + 1;
         return this->getLinkByStartandEndNodeID(train,
-                                                train->trainPath.at(prevI),
+                                                train->trainPath.at(segment),
                                                 train->trainPath.at(nextI),
                                                 true);
     }
 
+    /**
+     * @brief Retrieves the link in the train's path that includes a specified
+     * travelled distance.
+     *
+     * @param train The train object.
+     * @param travelledDistance The distance that has been travelled.
+     * @param previousNodeID The ID of a node the train already passed, the
+     *                       search starts from it.
+     * @returns A shared pointer to the NetLink object that includes the
+     *          travelled distance.
+     */
+    std::shared_ptr <NetLink> getLinkFromDistance(std::shared_ptr <Train> train,
+                                                 double &travelledDistance,
+                                                 int &previousNodeID) {
+        return this->getLinkByPathSegment(
+            train, this->getPathSegmentFromDistance(train, travelledDistance,
+                                                    previousNodeID));
+    }
+
     /**
      * @brief Translates a user-provided node identifier to a simulator-specific
      *  node identifier.
      *
-     * This function iterates over the network nodes until it finds a node with
-     * a user ID that matches the provided oldID. The function then returns
-     * the simulator-specific ID of this node.
+     * This function looks the node up in the user ID index of the network
+     * nodes. The function then returns the simulator-specific ID of this
+     * node.
      *
      * @param oldID The user-provided identifier.
      * @returns The simulator-specific identifier for the node.
@@ -720,10 +942,9 @@ public:
      *         found.
      */
     int getSimulatorNodeIDByUserID(int oldID) {
-        for (const std::shared_ptr<NetNode>& n : this->theFileNodes) {
-            if (n->userID == oldID) {
-                return n->id;
-            }
+        auto it = this->nodesByUserID.find(oldID);
+        if (it != this->nodesByUserID.end()) {
+            return it->second->id;
         }
         throw std::runtime_error(std::string("Error: ") +
                                      std::to_string(static_cast<int>(
@@ -750,8 +971,8 @@ public:
                     std::shared_ptr<Train> train,
                     double& travelledDistance,
                     int& nodeID) {
-        int endNodeIndex = train->trainPath.index(nodeID);
-        return train->linksCumLengths[endNodeIndex] - travelledDistance;
+        int endNodeIndex = train->getPathIndex(nodeID);
+        return train->route->cumLengths[endNodeIndex] - travelledDistance;
     }
 
     /**
@@ -799,13 +1020,14 @@ public:
     /**
      * @brief Performs a shortest path search between two nodes.
      *
-     * This function implements a Dijkstra-like shortest path algorithm.
-     * It takes the start node and
+     * This function runs a Dijkstra search with a binary heap over the
+     * routing graph of the network. It takes the start node and
      * target node IDs, then calculates the shortest path between them by
      * traversing the connected nodes and minimizing the overall path length.
      * It returns a pair, where the first element is a vector of nodes
      * representing the shortest path, and the second element is the total
-     * length of this path.
+     * length of this path. The search state is kept per query, so the
+     * function can be called from many threads at the same time.
      *
      * @param startNodeID The identifier for the start node.
      * @param targetNodeID The identifier for the target node.
@@ -815,49 +1037,24 @@ public:
      */
     std::pair<Vector<std::shared_ptr<NetNode>>, double> shortestPathSearch(
                     int startNodeID, int targetNodeID) {
-        // clear all the nodes for the new sheart path
-        for (auto& n : this->nodes) {
-            n.second->clearGraphSearchParams();
-        }
-        // get the nodes by their user id's
-        std::shared_ptr<NetNode> startNode = this->getNodeByID(startNodeID);
-        std::shared_ptr<NetNode> targetNode = this->getNodeByID(targetNodeID);
-        // override the inf value of the start node
-        startNode->graphSearchDistanceFromStart = 0.0;
-
-        // keep looping until the target node is reached
-        while (! targetNode->graphSearchVisited) {
-            // get the min-distance-unvisited node
-            std::shared_ptr<NetNode> currentNode = minimumDistance();
-            // if nothing was found, break
-            if (currentNode == nullptr) { break; }
-            // set the node as visited
-            currentNode->graphSearchVisited = true;
-            // check all the connected links/nodes
-            for (auto& connectedNode : currentNode->getNeighbors()) {
-                // check if a new node has a lower value
-                if ((currentNode->graphSearchDistanceFromStart +
-                    currentNode->linkTo.at(connectedNode).at(0)->length) <
-                            connectedNode->graphSearchDistanceFromStart) {
-                    // set the value
-                    connectedNode->graphSearchDistanceFromStart =
-                        currentNode->graphSearchDistanceFromStart +
-                            currentNode->linkTo.at(connectedNode).at(0)->length;
-                    connectedNode->graphSearchPreviousNode = currentNode;
-                }
-            }
-        }
+        return this->getRoutingGraph()->shortestPath(startNodeID,
+                                                     targetNodeID);
+    }
 
-        Vector<std::shared_ptr<NetNode>> path;
-        path.push_back(targetNode);
-        while (true) {
-            std::shared_ptr<NetNode> node = path.back();
-            if (node->graphSearchPreviousNode == nullptr) { break; }
-            //if (path.exist(node->graphSearchPreviousNode)) { break; }
-            path.push_back(node->graphSearchPreviousNode);
+    /**
+     * @brief Gets the routing graph of the network.
+     *
+     * The graph is built from the nodes links once, on the first call.
+     *
+     * @returns A shared pointer to the routing graph.
+     */
+    std::shared_ptr<NetRoutingGraph> getRoutingGraph() {
+        std::lock_guard<std::mutex> lock(this->routingGraphMutex);
+        if (this->routingGraph == nullptr) {
+            this->routingGraph =
+                std::make_shared<NetRoutingGraph>(this->nodes);
         }
-        std::reverse(path.begin(), path.end());
-        return std::make_pair(path, targetNode->graphSearchDistanceFromStart);
+        return this->routingGraph;
     }
 
 
@@ -867,24 +1064,6 @@ public:
     // ***********************************************************************
 private:
 
-    /**
-     * Node with minimum distance
-     * @author	Ahmed
-     * @date	2/14/2023
-     * @returns	A std::shared_ptr&lt;NetNode&gt;
-     */
-    std::shared_ptr<NetNode> minimumDistance() {
-        std::shared_ptr<NetNode> nextNode = std::shared_ptr<NetNode>();
-        double minValue = INFINITY;
-        for (auto& node : this->nodes) {
-            if (node.second->graphSearchDistanceFromStart < minValue &&
-                node.second->graphSearchVisited == false) {
-                minValue = node.second->graphSearchDistanceFromStart;
-                nextNode = node.second;
-            }
-        }
-        return nextNode;
-    }
 // ##################################################################
 // #               start: read data and organize it                 #
 // ##################################################################
@@ -1006,6 +1185,8 @@ private:
             }
             l->length = lLength;
         }
+        // the routes were built over the old lengths
+        this->invalidateRoutes();
     }
 
 // ##################################################################
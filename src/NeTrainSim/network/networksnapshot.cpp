@@ -0,0 +1,388 @@
+#include "networksnapshot.h"
+#include "netnode.h"
+#include "netlink.h"
+#include <cstring>
+#include <unordered_map>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QSaveFile>
+#include <QDateTime>
+#include <QByteArray>
+
+namespace {
+
+/** The fixed size header at the start of the snapshot */
+struct SnapshotHeader {
+    char magic[4];
+    quint32 version;
+    quint32 nodesCount;
+    quint32 linksCount;
+    quint32 signalNodesCount;
+    quint32 gradesCount;
+    quint64 stringsSize;
+    quint64 nodesFileSize;
+    qint64 nodesFileModified;
+    quint64 linksFileSize;
+    qint64 linksFileModified;
+    quint32 nodesPathSize;
+    quint32 linksPathSize;
+};
+
+/** The built state of a network node */
+struct NodeRecord {
+    qint32 id;
+    qint32 userID;
+    double x;
+    double y;
+    double xScale;
+    double yScale;
+    double dwellTimeIfTerminal;
+    quint32 descOffset;
+    quint32 descSize;
+    quint8 isTerminal;
+    quint8 refillTanksAndBatteries;
+    quint8 padding[6];
+};
+
+/** The built state of a network link, the nodes are referenced by their
+ * simulator IDs */
+struct LinkRecord {
+    qint32 id;
+    qint32 userID;
+    qint32 fromNodeID;
+    qint32 toNodeID;
+    qint32 trafficSignalNo;
+    qint32 direction;
+    double length;
+    double simulatorLength;
+    double freeFlowSpeed;
+    double curvature;
+    double speedVariation;
+    double linksScaleLength;
+    double linksScaleFreeSpeed;
+    double cost;
+    quint32 regionOffset;
+    quint32 regionSize;
+    quint32 signalNodesOffset;
+    quint32 signalNodesCount;
+    quint32 gradesOffset;
+    quint32 gradesCount;
+    quint8 hasCatenary;
+    quint8 padding[7];
+};
+
+/** One directional grade of a link */
+struct GradeRecord {
+    qint32 nodeID;
+    qint32 padding;
+    double grade;
+};
+
+/** The absolute path, size and modification time of a network file */
+struct SourceFile {
+    QByteArray path;
+    quint64 size;
+    qint64 modified;
+};
+
+const char SnapshotMagic[4] = {'N', 'T', 'S', 'B'};
+
+SourceFile getSourceFile(const std::string& fileName) {
+    QFileInfo info(QString::fromStdString(fileName));
+    return {info.absoluteFilePath().toUtf8(), quint64(info.size()),
+            info.lastModified().toMSecsSinceEpoch()};
+}
+
+template <typename T>
+void appendRecord(QByteArray& buffer, const T& record) {
+    buffer.append(reinterpret_cast<const char*>(&record), sizeof(T));
+}
+
+template <typename T>
+T readRecord(const uchar* data, quint64 offset) {
+    T record;
+    std::memcpy(&record, data + offset, sizeof(T));
+    return record;
+}
+
+bool readHeader(const uchar* data, quint64 size, SnapshotHeader& header) {
+    if (size < sizeof(SnapshotHeader)) { return false; }
+    header = readRecord<SnapshotHeader>(data, 0);
+    if (std::memcmp(header.magic, SnapshotMagic, sizeof(SnapshotMagic)) != 0 ||
+        header.version != NetworkSnapshot::SnapshotVersion) {
+        return false;
+    }
+    quint64 expectedSize =
+        sizeof(SnapshotHeader) +
+        quint64(header.nodesCount) * sizeof(NodeRecord) +
+        quint64(header.linksCount) * sizeof(LinkRecord) +
+        quint64(header.signalNodesCount) * sizeof(qint32) +
+        quint64(header.gradesCount) * sizeof(GradeRecord) +
+        header.stringsSize + header.nodesPathSize + header.linksPathSize;
+    return expectedSize == size;
+}
+
+} // namespace
+
+std::string NetworkSnapshot::getSnapshotFilename(const std::string& linksFile) {
+    QFileInfo info(QString::fromStdString(linksFile));
+    return info.dir().filePath(info.completeBaseName() + ".ntsb").toStdString();
+}
+
+bool NetworkSnapshot::isSnapshotUpToDate(const std::string& snapshotFile,
+                                         const std::string& nodesFile,
+                                         const std::string& linksFile) {
+    QFileInfo snapshotInfo(QString::fromStdString(snapshotFile));
+    QFileInfo nodesInfo(QString::fromStdString(nodesFile));
+    QFileInfo linksInfo(QString::fromStdString(linksFile));
+    if (!snapshotInfo.exists() || !nodesInfo.exists() || !linksInfo.exists()) {
+        return false;
+    }
+
+    QFile file(snapshotInfo.filePath());
+    if (!file.open(QIODevice::ReadOnly)) { return false; }
+    QByteArray headerBytes = file.read(sizeof(SnapshotHeader));
+    if (headerBytes.size() != sizeof(SnapshotHeader)) { return false; }
+    SnapshotHeader header;
+    if (!readHeader(reinterpret_cast<const uchar*>(headerBytes.constData()),
+                    file.size(), header)) {
+        return false;
+    }
+
+    // the snapshot is built from the same files only if their paths, sizes
+    // and modification times did not change
+    SourceFile nodesSource = getSourceFile(nodesFile);
+    SourceFile linksSource = getSourceFile(linksFile);
+    if (header.nodesFileSize != nodesSource.size ||
+        header.nodesFileModified != nodesSource.modified ||
+        header.linksFileSize != linksSource.size ||
+        header.linksFileModified != linksSource.modified) {
+        return false;
+    }
+    if (!file.seek(file.size() - header.nodesPathSize -
+                   header.linksPathSize)) {
+        return false;
+    }
+    return file.read(header.nodesPathSize) == nodesSource.path &&
+           file.read(header.linksPathSize) == linksSource.path;
+}
+
+bool NetworkSnapshot::writeSnapshot(
+    const std::string& snapshotFile,
+    const std::string& nodesFile,
+    const std::string& linksFile,
+    const Vector<std::shared_ptr<NetNode>>& nodes,
+    const Vector<std::shared_ptr<NetLink>>& links) {
+
+    QByteArray nodesBytes;
+    QByteArray linksBytes;
+    QByteArray signalNodesBytes;
+    QByteArray gradesBytes;
+    QByteArray strings;
+    nodesBytes.reserve(nodes.size() * sizeof(NodeRecord));
+    linksBytes.reserve(links.size() * sizeof(LinkRecord));
+    quint32 signalNodesCount = 0;
+    quint32 gradesCount = 0;
+
+    for (const std::shared_ptr<NetNode>& n : nodes) {
+        NodeRecord record{};
+        record.id = n->id;
+        record.userID = n->userID;
+        record.x = n->x;
+        record.y = n->y;
+        record.xScale = n->xScale;
+        record.yScale = n->yScale;
+        record.dwellTimeIfTerminal = n->dwellTimeIfTerminal;
+        record.descOffset = strings.size();
+        record.descSize = n->alphaDesc.size();
+        record.isTerminal = n->isTerminal;
+        record.refillTanksAndBatteries = n->refillTanksAndBatteries;
+        strings.append(n->alphaDesc.data(), n->alphaDesc.size());
+        appendRecord(nodesBytes, record);
+    }
+
+    for (const std::shared_ptr<NetLink>& l : links) {
+        LinkRecord record{};
+        record.id = l->id;
+        record.userID = l->userID;
+        record.fromNodeID = l->fromLoc->id;
+        record.toNodeID = l->toLoc->id;
+        record.trafficSignalNo = l->trafficSignalNo;
+        record.direction = l->direction;
+        record.length = l->length;
+        record.simulatorLength = l->simulatorLength;
+        record.freeFlowSpeed = l->freeFlowSpeed;
+        record.curvature = l->curvature;
+        record.speedVariation = l->speedVariation;
+        record.linksScaleLength = l->linksScaleLength;
+        record.linksScaleFreeSpeed = l->linksScaleFreeSpeed;
+        record.cost = l->cost;
+        record.regionOffset = strings.size();
+        record.regionSize = l->region.size();
+        record.signalNodesOffset = signalNodesCount;
+        record.signalNodesCount = l->trafficSignalAtEnd.size();
+        record.gradesOffset = gradesCount;
+        record.gradesCount = l->grade.size();
+        record.hasCatenary = l->hasCatenary;
+        strings.append(l->region.data(), l->region.size());
+
+        for (int nodeUserID : l->trafficSignalAtEnd) {
+            qint32 value = nodeUserID;
+            appendRecord(signalNodesBytes, value);
+            signalNodesCount++;
+        }
+        for (auto& g : l->grade) {
+            GradeRecord grade{};
+            grade.nodeID = g.first;
+            grade.grade = g.second;
+            appendRecord(gradesBytes, grade);
+            gradesCount++;
+        }
+        appendRecord(linksBytes, record);
+    }
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SnapshotMagic, sizeof(SnapshotMagic));
+    header.version = SnapshotVersion;
+    header.nodesCount = nodes.size();
+    header.linksCount = links.size();
+    header.signalNodesCount = signalNodesCount;
+    header.gradesCount = gradesCount;
+    header.stringsSize = strings.size();
+    SourceFile nodesSource = getSourceFile(nodesFile);
+    SourceFile linksSource = getSourceFile(linksFile);
+    header.nodesFileSize = nodesSource.size;
+    header.nodesFileModified = nodesSource.modified;
+    header.linksFileSize = linksSource.size;
+    header.linksFileModified = linksSource.modified;
+    header.nodesPathSize = nodesSource.path.size();
+    header.linksPathSize = linksSource.path.size();
+
+    QSaveFile file(QString::fromStdString(snapshotFile));
+    if (!file.open(QIODevice::WriteOnly)) { return false; }
+    QByteArray headerBytes;
+    appendRecord(headerBytes, header);
+    for (const QByteArray* part : {&headerBytes, &nodesBytes, &linksBytes,
+                                   &signalNodesBytes, &gradesBytes,
+                                   &strings, &nodesSource.path,
+                                   &linksSource.path}) {
+        if (file.write(*part) != part->size()) {
+            file.cancelWriting();
+            return false;
+        }
+    }
+    return file.commit();
+}
+
+bool NetworkSnapshot::readSnapshot(
+    const std::string& snapshotFile,
+    Vector<std::shared_ptr<NetNode>>& nodes,
+    Vector<std::shared_ptr<NetLink>>& links) {
+
+    QFile file(QString::fromStdString(snapshotFile));
+    if (!file.open(QIODevice::ReadOnly)) { return false; }
+    quint64 size = file.size();
+    uchar* data = file.map(0, size);
+    if (data == nullptr) { return false; }
+
+    SnapshotHeader header;
+    if (!readHeader(data, size, header)) {
+        file.unmap(data);
+        return false;
+    }
+
+    quint64 nodesOffset = sizeof(SnapshotHeader);
+    quint64 linksOffset = nodesOffset +
+                          quint64(header.nodesCount) * sizeof(NodeRecord);
+    quint64 signalNodesOffset = linksOffset +
+                                quint64(header.linksCount) * sizeof(LinkRecord);
+    quint64 gradesOffset = signalNodesOffset +
+                           quint64(header.signalNodesCount) * sizeof(qint32);
+    quint64 stringsOffset = gradesOffset +
+                            quint64(header.gradesCount) * sizeof(GradeRecord);
+    const char* strings = reinterpret_cast<const char*>(data + stringsOffset);
+
+    Vector<std::shared_ptr<NetNode>> readNodes;
+    Vector<std::shared_ptr<NetLink>> readLinks;
+    readNodes.reserve(header.nodesCount);
+    readLinks.reserve(header.linksCount);
+    std::unordered_map<int, std::shared_ptr<NetNode>> nodesByID;
+    nodesByID.reserve(header.nodesCount);
+    bool isValid = true;
+
+    for (quint32 i = 0; i < header.nodesCount && isValid; i++) {
+        NodeRecord record = readRecord<NodeRecord>(
+            data, nodesOffset + quint64(i) * sizeof(NodeRecord));
+        if (quint64(record.descOffset) + record.descSize > header.stringsSize) {
+            isValid = false;
+            break;
+        }
+        // the coordinates are already scaled, so they are passed unscaled
+        auto node = std::make_shared<NetNode>(
+            record.id, record.userID, record.x, record.y,
+            std::string(strings + record.descOffset, record.descSize),
+            1.0, 1.0);
+        node->xScale = record.xScale;
+        node->yScale = record.yScale;
+        node->isTerminal = record.isTerminal;
+        node->dwellTimeIfTerminal = record.dwellTimeIfTerminal;
+        node->refillTanksAndBatteries = record.refillTanksAndBatteries;
+        nodesByID[node->id] = node;
+        readNodes.push_back(node);
+    }
+
+    for (quint32 i = 0; i < header.linksCount && isValid; i++) {
+        LinkRecord record = readRecord<LinkRecord>(
+            data, linksOffset + quint64(i) * sizeof(LinkRecord));
+        auto fromNode = nodesByID.find(record.fromNodeID);
+        auto toNode = nodesByID.find(record.toNodeID);
+        if (fromNode == nodesByID.end() || toNode == nodesByID.end() ||
+            quint64(record.regionOffset) + record.regionSize >
+                header.stringsSize ||
+            quint64(record.signalNodesOffset) + record.signalNodesCount >
+                header.signalNodesCount ||
+            quint64(record.gradesOffset) + record.gradesCount >
+                header.gradesCount) {
+            isValid = false;
+            break;
+        }
+
+        auto link = std::make_shared<NetLink>(
+            record.id, record.userID, fromNode->second, toNode->second,
+            record.length, record.freeFlowSpeed, record.trafficSignalNo,
+            "", 0.0, record.curvature, record.direction,
+            record.speedVariation, record.hasCatenary != 0,
+            std::string(strings + record.regionOffset, record.regionSize),
+            1.0, 1.0);
+        // restore the built values over the ones the constructor derived
+        link->length = record.length;
+        link->simulatorLength = record.simulatorLength;
+        link->freeFlowSpeed = record.freeFlowSpeed;
+        link->linksScaleLength = record.linksScaleLength;
+        link->linksScaleFreeSpeed = record.linksScaleFreeSpeed;
+        link->cost = record.cost;
+        link->trafficSignalAtEnd.clear();
+        for (quint32 k = 0; k < record.signalNodesCount; k++) {
+            link->trafficSignalAtEnd.push_back(readRecord<qint32>(
+                data, signalNodesOffset +
+                          quint64(record.signalNodesOffset + k) *
+                              sizeof(qint32)));
+        }
+        link->grade.clear();
+        for (quint32 k = 0; k < record.gradesCount; k++) {
+            GradeRecord grade = readRecord<GradeRecord>(
+                data, gradesOffset +
+                          quint64(record.gradesOffset + k) *
+                              sizeof(GradeRecord));
+            link->grade[grade.nodeID] = grade.grade;
+        }
+        readLinks.push_back(link);
+    }
+
+    file.unmap(data);
+    if (!isValid) { return false; }
+    nodes = readNodes;
+    links = readLinks;
+    return true;
+}
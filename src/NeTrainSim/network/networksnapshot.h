@@ -0,0 +1,90 @@
+/**
+ * @file NetworkSnapshot.h
+ * @brief This file contains the declaration of the NetworkSnapshot
+ *        namespace.
+ *        The NetworkSnapshot namespace reads and writes the binary network
+ *        snapshot (.ntsb) files. A snapshot holds the built nodes and links
+ *        of a network (topology, geometry, signals placement and the
+ *        derived lengths) in fixed size records, so it is read through a
+ *        memory map instead of parsing the nodes and links text files.
+ *        The snapshot is written next to the links file and records the
+ *        absolute paths, sizes and modification times of the nodes and
+ *        links files it was built from. It is used only while all of them
+ *        still match.
+ * @version 0.1
+ */
+
+#ifndef NeTrainSim_NetworkSnapshot_h
+#define NeTrainSim_NetworkSnapshot_h
+
+#include "../export.h"
+#include <memory>
+#include <string>
+#include "../util/vector.h"
+
+class NetNode; // Forward declaration of NetNode class
+class NetLink; // Forward declaration of NetLink class
+
+namespace NetworkSnapshot {
+
+/** The version of the snapshot format, bump it when the records change */
+static const unsigned int SnapshotVersion = 2;
+
+/**
+ * @brief Gets the snapshot filename of a network.
+ * @param linksFile The links file of the network.
+ * @return The links file path with the .ntsb extension.
+ */
+std::string NETRAINSIMCORE_EXPORT
+getSnapshotFilename(const std::string& linksFile);
+
+/**
+ * @brief Checks if a snapshot can replace the network text files.
+ * @param snapshotFile The snapshot file.
+ * @param nodesFile The nodes file of the network.
+ * @param linksFile The links file of the network.
+ * @return true if the snapshot exists, has a valid header, and was
+ *         built from the same nodes and links files, compared by their
+ *         absolute paths, sizes and modification times.
+ */
+bool NETRAINSIMCORE_EXPORT
+isSnapshotUpToDate(const std::string& snapshotFile,
+                   const std::string& nodesFile,
+                   const std::string& linksFile);
+
+/**
+ * @brief Writes the built nodes and links of a network to a snapshot.
+ *
+ * The file is replaced atomically, so a reader never sees a partial
+ * snapshot.
+ *
+ * @param snapshotFile The snapshot file.
+ * @param nodesFile The nodes file the network was built from.
+ * @param linksFile The links file the network was built from.
+ * @param nodes The network nodes ordered by their simulator ID.
+ * @param links The network links ordered by their simulator ID.
+ * @return true if the snapshot was written, false otherwise.
+ */
+bool NETRAINSIMCORE_EXPORT
+writeSnapshot(const std::string& snapshotFile,
+              const std::string& nodesFile,
+              const std::string& linksFile,
+              const Vector<std::shared_ptr<NetNode>>& nodes,
+              const Vector<std::shared_ptr<NetLink>>& links);
+
+/**
+ * @brief Reads the nodes and links of a network from a snapshot.
+ * @param snapshotFile The snapshot file.
+ * @param nodes Filled with the network nodes.
+ * @param links Filled with the network links.
+ * @return true if the snapshot was read, false if the file cannot be
+ *         mapped or is not a valid snapshot.
+ */
+bool NETRAINSIMCORE_EXPORT
+readSnapshot(const std::string& snapshotFile,
+             Vector<std::shared_ptr<NetNode>>& nodes,
+             Vector<std::shared_ptr<NetLink>>& links);
+
+} // namespace NetworkSnapshot
+
+#endif // NeTrainSim_NetworkSnapshot_h
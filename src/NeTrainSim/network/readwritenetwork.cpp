@@ -580,6 +580,10 @@ Vector<std::shared_ptr<NetLink>> ReadWriteNetwork::generateLinks(
     Vector<Map<std::string, std::string>> linksRecords)
 {
     Vector<std::shared_ptr<NetLink>> links;
+    // look the link ends up by their user IDs in constant time
+    std::unordered_map<int, std::shared_ptr<NetNode>> nodesByUserID =
+        indexNodesByUserID(theFileNodes);
+    links.reserve(linksRecords.size());
     try {
         int simulatorlinkID = 0;
         for (auto &record : linksRecords) {
@@ -607,9 +611,9 @@ Vector<std::shared_ptr<NetLink>> ReadWriteNetwork::generateLinks(
             }
 
             std::shared_ptr<NetNode> fromNodeNode =
-                getSimulatorNodeByUserID(theFileNodes, fromNode);
+                getSimulatorNodeByUserID(nodesByUserID, fromNode);
             std::shared_ptr<NetNode> toNodeNode   =
-                getSimulatorNodeByUserID(theFileNodes, toNode);
+                getSimulatorNodeByUserID(nodesByUserID, toNode);
 
             NetLink link = NetLink(simulatorlinkID, linkID, fromNodeNode,
                                    toNodeNode, length, maxSpeed,
@@ -644,10 +648,10 @@ Vector<std::shared_ptr<NetLink>> ReadWriteNetwork::generateLinks(
          * @returns	The simulator node by user identifier.
          */
 std::shared_ptr<NetNode> ReadWriteNetwork::getSimulatorNodeByUserID(
-    Vector<std::shared_ptr<NetNode>> theFileNodes,
+    const Vector<std::shared_ptr<NetNode>>& theFileNodes,
     int oldID)
 {
-    for (std::shared_ptr<NetNode>& n : theFileNodes) {
+    for (const std::shared_ptr<NetNode>& n : theFileNodes) {
         if (n->userID == oldID) {
             return n;
         }
@@ -660,6 +664,35 @@ std::shared_ptr<NetNode> ReadWriteNetwork::getSimulatorNodeByUserID(
                              std::to_string(oldID) + "\n");
 }
 
+std::unordered_map<int, std::shared_ptr<NetNode>>
+ReadWriteNetwork::indexNodesByUserID(
+    const Vector<std::shared_ptr<NetNode>>& theFileNodes)
+{
+    std::unordered_map<int, std::shared_ptr<NetNode>> nodesByUserID;
+    nodesByUserID.reserve(theFileNodes.size());
+    for (const std::shared_ptr<NetNode>& n : theFileNodes) {
+        // keep the first node like the linear search does
+        nodesByUserID.emplace(n->userID, n);
+    }
+    return nodesByUserID;
+}
+
+std::shared_ptr<NetNode> ReadWriteNetwork::getSimulatorNodeByUserID(
+    const std::unordered_map<int, std::shared_ptr<NetNode>>& nodesByUserID,
+    int oldID)
+{
+    auto it = nodesByUserID.find(oldID);
+    if (it != nodesByUserID.end()) {
+        return it->second;
+    }
+    throw std::runtime_error(std::string("Error: ") +
+                             std::to_string(
+                                 static_cast<int>(
+                                 Error::cannotFindNode)) +
+                             "\nCould not find the node ID: " +
+                             std::to_string(oldID) + "\n");
+}
+
 
 
 bool ReadWriteNetwork::writeLinksFile(
@@ -26,6 +26,7 @@
 #include "netnode.h"
 #include "../util/vector.h"
 #include <exception>
+#include <unordered_map>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QJsonValue>
@@ -156,7 +157,29 @@ generateLinks(Vector<std::shared_ptr<NetNode>> theFileNodes,
      */
 std::shared_ptr<NetNode> NETRAINSIMCORE_EXPORT
 getSimulatorNodeByUserID(
-    Vector<std::shared_ptr<NetNode>> theFileNodes, int oldID);
+    const Vector<std::shared_ptr<NetNode>>& theFileNodes, int oldID);
+
+/**
+     * @brief Maps the NetNode objects by their user identifiers.
+     * @param theFileNodes The NetNode objects generated from the nodes records.
+     * @return The NetNode objects mapped by their user identifiers. If two
+     *         nodes share a user identifier, the first one is kept.
+     */
+std::unordered_map<int, std::shared_ptr<NetNode>> NETRAINSIMCORE_EXPORT
+indexNodesByUserID(const Vector<std::shared_ptr<NetNode>>& theFileNodes);
+
+/**
+     * @brief Gets the NetNode object with the given user identifier.
+     * @param nodesByUserID The NetNode objects mapped by their user
+     *                      identifiers.
+     * @param oldID The user identifier of the NetNode to retrieve.
+     * @return The NetNode object with the specified user identifier.
+     * @throw std::runtime_error if the node cannot be found.
+     */
+std::shared_ptr<NetNode> NETRAINSIMCORE_EXPORT
+getSimulatorNodeByUserID(
+    const std::unordered_map<int, std::shared_ptr<NetNode>>& nodesByUserID,
+    int oldID);
 
 } // namespace ReadWriteNetwork
 
@@ -18,11 +18,16 @@
 #include <cmath>
 #include <memory>    // Include for smart pointers
 #include "util/error.h" // Include for error handling utilities
+#include "util/sqliteresultsstore.h"
+#include "util/tracerecorder.h"
 #include <QStandardPaths>
 #include "VersionConfig.h"
 #include <QCoreApplication>
 #include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
 #include <atomic>
+#include <algorithm>
+#include <unordered_map>
 
 // Function to get the path to the home directory.
 // If the path is not empty, it is returned, otherwise a runtime exception is thrown with an error message.
@@ -91,6 +96,7 @@ Simulator::Simulator(Network* theNetwork, QVector<std::shared_ptr<Train> > netwo
 	// Define default names for trajectory and summary files with current time
 	this->trajectoryFilename = DefaultInstantaneousTrajectoryFilename + std::to_string(serial_number) + ".csv";
 	this->summaryFileName = DefaultSummaryFilename + std::to_string(serial_number) + ".txt";
+	this->stepProfileFilename = DefaultStepProfileFilename + std::to_string(serial_number) + ".json";
 
 	this->exportTrajectory = false;
 
@@ -146,6 +152,81 @@ void Simulator::setPlotFrequency(int newPlotFrequency) {
     this->plotFrequency = newPlotFrequency;
 }
 
+// Setter for the number of threads stepping the trains
+void Simulator::setThreadsCount(int newThreadsCount) {
+    if (newThreadsCount < 1) {
+        newThreadsCount = QThread::idealThreadCount();
+    }
+    this->threadsCount = newThreadsCount;
+    this->stepThreadPool.setMaxThreadCount(newThreadsCount);
+}
+
+// Getter for the number of threads stepping the trains
+int Simulator::getThreadsCount() const {
+    return this->threadsCount;
+}
+
+// Setter for the number of trajectory records queued for the writer
+void Simulator::setTrajectoryBufferSize(int newBufferSize) {
+    this->trajectoryWriter.setBufferSize(newBufferSize);
+}
+
+// Getter for the number of trajectory records queued for the writer
+int Simulator::getTrajectoryBufferSize() const {
+    return this->trajectoryWriter.getBufferSize();
+}
+
+// Setter for the trajectory file format
+void Simulator::setTrajectoryFormat(TrajectoryWriter::Format newFormat) {
+    this->trajectoryWriter.setFormat(newFormat);
+}
+
+// Getter for the trajectory file format
+TrajectoryWriter::Format Simulator::getTrajectoryFormat() const {
+    return this->trajectoryWriter.getFormat();
+}
+
+// Setter for the output files compression
+void Simulator::setCompressOutput(bool newCompressOutput) {
+    this->compressOutput = newCompressOutput;
+    this->trajectoryWriter.setCompression(newCompressOutput);
+}
+
+// Getter for the output files compression
+bool Simulator::getCompressOutput() const {
+    return this->compressOutput;
+}
+
+// Setter for the step profiling flag and filename
+void Simulator::setProfileSteps(bool profileSteps, string newProfileFilename) {
+	this->profiler.setEnabled(profileSteps);
+	if (newProfileFilename != "") {
+		QFileInfo fileInfo(QString::fromStdString(newProfileFilename));
+		// Check if the file name has an extension
+		if (!fileInfo.completeSuffix().isEmpty()) {
+			this->stepProfileFilename = newProfileFilename;
+		}
+		else {
+			this->stepProfileFilename = newProfileFilename + ".json";
+		}
+	}
+	else {
+		auto now = std::chrono::high_resolution_clock::now();
+		auto serial_number = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+		this->stepProfileFilename = DefaultStepProfileFilename + std::to_string(serial_number) + ".json";
+	}
+}
+
+// Getter for the step profiling flag
+bool Simulator::getProfileSteps() const {
+	return this->profiler.isEnabled();
+}
+
+// Getter for the step profiler
+const StepProfiler& Simulator::getStepProfiler() const {
+	return this->profiler;
+}
+
 // Setter for the output folder location
 void Simulator::setOutputFolderLocation(string newOutputFolderLocation) {
 	this->outputLocation = QString::fromStdString(newOutputFolderLocation);
@@ -170,7 +251,7 @@ void Simulator::addTrainsToSimulation(QVector< std::shared_ptr<Train> > trainsLi
     QMutexLocker locker(&mutex);
 
     QVector<QString> trainsIDs;
-    for (auto &train: trains) {
+    for (auto &train: trainsList) {
         trainsIDs.push_back(QString::fromStdString(train->trainUserID));
         trains.push_back(train);
     }
@@ -199,7 +280,9 @@ void Simulator::setSummaryFilename(string newfilename) {
 }
 
 // Setter for the instantaneous trajectory export flag and filename
-void Simulator::setExportInstantaneousTrajectory(bool exportInstaTraject, string newInstaTrajectFilename) {
+void Simulator::setExportInstantaneousTrajectory(bool exportInstaTraject, string newInstaTrajectFilename,
+												 const TrajectoryWriter::ExportConfig &exportConfig) {
+	this->trajectoryWriter.setExportConfig(exportConfig);
 	this->exportTrajectory = exportInstaTraject;
 	if (newInstaTrajectFilename != ""){
 		QString filename = QString::fromStdString(newInstaTrajectFilename);
@@ -231,27 +314,48 @@ void Simulator::setExportInstantaneousTrajectory(bool exportInstaTraject, string
 // The openTrajectoryFile function tries to open a file to store the trajectory of trains.
 // If it fails to open the file, it throws an exception.
 void Simulator::openTrajectoryFile() {
-	try {
-		// Open the trajectory file to write the step trajectory data
-		this->trajectoryFile.open(QDir(this->outputLocation).
-								  filePath(QString::fromStdString(this->trajectoryFilename)).
-								  toStdString(),
-								  std::ios::out | std::ios::trunc);
-
-		// if couldnt open, throw error
-		if (!this->trajectoryFile.is_open()) {
-			throw std::ios_base::failure(std::string("Error: ") +
-										 std::to_string(static_cast<int>(Error::cannotOpenTrajectoryFile)) +
-										 "\nError opening file: " + this->trajectoryFilename + "!\n");
-		}
+	// every run gets its own rows in the results database
+	if (this->trajectoryWriter.getFormat() == TrajectoryWriter::Format::SQLite) {
+		auto now = std::chrono::system_clock::now();
+		auto serial_number = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+		this->resultsRunName = QFileInfo(QString::fromStdString(this->trajectoryFilename)).completeBaseName() +
+							   "_" + QString::number(serial_number);
+		this->trajectoryWriter.setRunName(this->resultsRunName.toStdString());
 	}
-	catch (const std::ios_base::failure& e) {
+	// Open the trajectory file to write the step trajectory data
+	if (!this->trajectoryWriter.open(this->getTrajectoryFilePath().toStdString())) {
 		throw std::ios_base::failure(std::string("Error: ") +
 									 std::to_string(static_cast<int>(Error::cannotOpenTrajectoryFile)) +
 									 "\nCould not create/open the trajectory file!\n");
 	}
 }
 
+// The trajectory file path follows the trajectory format extension
+QString Simulator::getTrajectoryFilePath() const {
+	QString filename = QString::fromStdString(this->trajectoryFilename);
+	QString extension = QString::fromStdString(
+		TrajectoryWriter::getFileExtension(this->trajectoryWriter.getFormat()));
+	QFileInfo fileInfo(filename);
+	if (fileInfo.suffix() == "csv" && extension != "csv") {
+		filename.chop(3);
+		filename += extension;
+	}
+	else if (this->compressOutput &&
+			 this->trajectoryWriter.getFormat() == TrajectoryWriter::Format::CSV) {
+		filename += "." + QString::fromStdString(CompressedFile::Extension);
+	}
+	return QDir(this->outputLocation).filePath(filename);
+}
+
+// The summary file path gets the compressed extension when compressed
+QString Simulator::getSummaryFilePath() const {
+	QString filename = QString::fromStdString(this->summaryFileName);
+	if (this->compressOutput) {
+		filename += "." + QString::fromStdString(CompressedFile::Extension);
+	}
+	return QDir(this->outputLocation).filePath(filename);
+}
+
 // The getOutputFolder function returns the path to the directory where the output files are stored.
 std::string Simulator::getOutputFolder() {
 	return this->outputLocation.toStdString();
@@ -262,12 +366,19 @@ std::string Simulator::getOutputFolder() {
 void Simulator::openSummaryFile() {
 	try {
 		// open the summary file to write the summary data
-		this->summaryFile.open(QDir(this->outputLocation).
-							   filePath(QString::fromStdString(this->summaryFileName)).toStdString(),
-							   std::ios::out | std::ios::trunc);
+		bool isOpen;
+		if (this->compressOutput) {
+			this->compressedSummaryFile.open(this->getSummaryFilePath().toStdString());
+			isOpen = this->compressedSummaryFile.is_open();
+		}
+		else {
+			this->summaryFile.open(this->getSummaryFilePath().toStdString(),
+								   std::ios::out | std::ios::trunc);
+			isOpen = this->summaryFile.is_open();
+		}
 
 		// throw error if couldnt open
-        if (!this->summaryFile.is_open()) {
+        if (!isOpen) {
 			throw std::ios_base::failure(std::string("Error: ") +
 										 std::to_string(static_cast<int>(Error::cannotOpenSummaryFile)) +
 										 "\nError opening file: " + this->summaryFileName + "!\n");
@@ -327,7 +438,8 @@ void Simulator::loadTrain(std::shared_ptr <Train> train) {
 	train->loaded = true;
 	train->currentCoordinates = train->trainPathNodes.at(0)->coordinates();
 	train->setTrainsCurrentLinks(Vector<std::shared_ptr<NetLink>>(1, this->network->getFirstTrainLink(train)));
-	train->linksCumLengths = this->network->generateCumLinksLengths(train);
+	// resolve the route links, lengths, and track data once for the whole trip
+	this->network->compileTrainRoute(train);
 	train->previousNodeID = train->trainPath.at(0);
 	train->LastTrainPointpreviousNodeID = train->trainPath.at(0);
 }
@@ -359,12 +471,21 @@ tuple<Vector<double>, Vector<double>, Vector<double>,
 		if (distance < 0.0) { distance = 0.0; }
 		if (distance > train->trainTotalPathLength) { distance = train->trainTotalPathLength; }
 		// get the vehicle-spanning link
-		std::shared_ptr<NetLink>  link = this->network->getLinkFromDistance(train, distance, train->previousNodeID);
+		int segment = this->network->getPathSegmentFromDistance(train, distance, train->previousNodeID);
+		std::shared_ptr<NetLink>  link = this->network->getLinkByPathSegment(train, segment);
+		// read the compiled track data if the segment has a single link
+		if (train->route->links.at(segment) != nullptr) {
+			curvatures.push_back(train->route->curvatures[segment]);
+			grades.push_back(train->route->grades[segment]);
+			freeFlowSpeeds.push_back(train->route->freeFlowSpeeds[segment]);
+			links.push_back(link);
+			continue;
+		}
 		// push link geometric data to their corresponding vectors
 		curvatures.push_back(link->curvature);
 		if (train->LinkGradeDirection.count(link->id) == 0) {
 			int indx;
-			if (train->trainPath.index(link->fromLoc->id) < train->trainPath.index(link->toLoc->id)) {
+			if (train->getPathIndex(link->fromLoc->id) < train->getPathIndex(link->toLoc->id)) {
 				indx = link->fromLoc->id;
 			}
 			else {
@@ -410,7 +531,7 @@ int Simulator::getSignalFromLink(Vector<std::shared_ptr<NetSignal>> networkSigna
 // indicating whether the train will have to stop due to a red signal.
 pair<pair<int, std::shared_ptr<NetNode>>, bool> Simulator::getNextStoppingNodeID(std::shared_ptr<Train> train, int &previousNodeID) {
 	// Fetch the index of the previous node in the train's path
-	int previousNodeIndex = train->trainPath.index(previousNodeID);
+	int previousNodeIndex = train->getPathIndex(previousNodeID);
 	// Iterate over the train's path
 	for (int i = previousNodeIndex + 1; i < train->trainPath.size(); i++) {
 		// If index exceeds the path size, return last node ID and false
@@ -461,50 +582,71 @@ pair<pair<int, std::shared_ptr<NetNode>>, bool> Simulator::getNextStoppingNodeID
  *                              a double value of its corresponding lower speed
  */
 Map<int, double> Simulator::getAllLowerSpeedsIDs(std::shared_ptr<Train> train, int& previousNodeID, int& nextStoppingNodeID) {
-	int prevI = train->trainPath.index(previousNodeID);
-	int nextSI = train->trainPath.index(nextStoppingNodeID);
-
-	// check if the values have been already memorized
-	// if not, get them
-	if (train->LowerSpeedNodeIDs[prevI][nextSI].empty()) {
-		Map<int, double> lowerSpeedMapping;
-		for (int i = prevI + 1; i < train->trainPath.size(); i++) {
-			if (nextStoppingNodeID == train->trainPath[i]) { break; }
-			else {
-				int prevIndx = i - 1;
-				std::shared_ptr<NetLink> l1 = this->network->getLinkByStartNodeID(train, train->trainPath[prevIndx]);
-				std::shared_ptr<NetLink> l2 = this->network->getLinkByStartNodeID(train, train->trainPath[i]);
-				if (l2 == nullptr) { continue; }
-				if (l2->freeFlowSpeed < l1->freeFlowSpeed) { lowerSpeedMapping[train->trainPath[i]] = l2->freeFlowSpeed; }
-			}
-		}
-		train->LowerSpeedNodeIDs[prevI][nextSI] = lowerSpeedMapping;
-		return lowerSpeedMapping;
-	}
-	// else, return the memorized value
-	else {
-		return train->LowerSpeedNodeIDs[prevI][nextSI];
+	int prevI = train->getPathIndex(previousNodeID);
+	int nextSI = train->getPathIndex(nextStoppingNodeID);
+	if (nextSI < 0) { nextSI = train->trainPath.size(); }
+
+	// the speed drops are sorted by their path index, so the drops between
+	// the previous node and the next stop are a contiguous range
+	const Vector<int> &dropIndices = train->route->speedDropPathIndices;
+	auto first = std::upper_bound(dropIndices.begin(), dropIndices.end(), prevI);
+	auto last = std::lower_bound(first, dropIndices.end(), nextSI);
+
+	Map<int, double> lowerSpeedMapping;
+	for (auto it = first; it != last; ++it) {
+		int k = it - dropIndices.begin();
+		lowerSpeedMapping[train->trainPath[*it]] = train->route->speedDropSpeeds[k];
 	}
+	return lowerSpeedMapping;
 }
 
-std::pair<std::shared_ptr<Train>, double> Simulator::getAheadTrainAndGap(std::shared_ptr <Train> train) {
+// This function walks forward over the links of the remaining train path and returns the closest
+// train ahead that travels in the same direction, with the along-track gap to its rear end.
+std::pair<std::shared_ptr<Train>, double> Simulator::getAheadTrainAndGap(std::shared_ptr <Train> train,
+																		 double lookAheadDistance) {
 	std::pair<std::shared_ptr<Train>, double> toTrainsDistance = { nullptr, 0.0 };
-	for (std::shared_ptr<Train>& otherTrain : this->trains) {
-		// check if the train is loaded and not reached destination
-        if (otherTrain.get() == train.get() || !otherTrain->loaded || otherTrain->reachedDestination) { continue; }
-        double d1 = Utils::getDistanceByTwoCoordinates(train->currentCoordinates, otherTrain->startEndPoints[0]);
-        double d2 = Utils::getDistanceByTwoCoordinates(train->currentCoordinates, otherTrain->startEndPoints[1]);
-		double d = (d1 < d2) ? d1 : d2;
-
-		if (toTrainsDistance.first == nullptr) {
-			if (toTrainsDistance.second > d) {
-				toTrainsDistance = { train, d };
+	int startIndex = train->routeCursor;
+	if (startIndex < 0) { return toTrainsDistance; }
+	double headDistance = train->travelledDistance;
+
+	for (int k = startIndex; k < static_cast<int>(train->trainPath.size()) - 1; k++) {
+		double linkStartDistance = train->route->cumLengths[k];
+		// stop scanning once the look ahead horizon is exceeded
+		if (linkStartDistance - headDistance > lookAheadDistance) { break; }
+
+		int startNodeID = train->trainPath[k];
+		int endNodeID = train->trainPath[k + 1];
+		std::shared_ptr<NetLink> link = this->network->getLinkByStartandEndNodeID(train, startNodeID, endNodeID, true);
+
+		for (std::shared_ptr<Train>& otherTrain : link->currentTrains) {
+			if (otherTrain == train) { continue; }
+			// trains that are not committed yet are observed at the start of the step
+			Train::StepSnapshot other = otherTrain->getObservedState();
+			if (!other.loaded || other.reachedDestination) { continue; }
+
+			// only trains taking the link in the same direction are followed,
+			// opposing movements are resolved by the signals
+			int otherStartIndex = otherTrain->getPathIndex(startNodeID);
+			if (otherStartIndex < 0 || otherStartIndex + 1 >= otherTrain->trainPath.size() ||
+				otherTrain->trainPath[otherStartIndex + 1] != endNodeID) { continue; }
+
+			// the rear end of the other train measured from the start of the link
+			double otherLinkStartDistance = otherTrain->route->cumLengths[otherStartIndex];
+			double otherRearDistance = std::max(other.travelledDistance - otherTrain->totalLength,
+												otherLinkStartDistance);
+			double rearDistance = linkStartDistance + (otherRearDistance - otherLinkStartDistance);
+			double frontDistance = linkStartDistance + (other.travelledDistance - otherLinkStartDistance);
+
+			// skip the trains that are completely behind the head of the train
+			if (frontDistance <= headDistance) { continue; }
+			double gap = std::max(0.0, rearDistance - headDistance);
+			if (gap > lookAheadDistance) { continue; }
+			if (toTrainsDistance.first == nullptr || gap < toTrainsDistance.second) {
+				toTrainsDistance = { otherTrain, gap };
 			}
 		}
-		else {
-			
-			toTrainsDistance = { train, d };
-		}
+		// any train on a farther link is behind the one already found
+		if (toTrainsDistance.first != nullptr) { break; }
 	}
 	return toTrainsDistance;
 }
@@ -527,268 +669,342 @@ void Simulator::setOccupiedLinksByTrains(std::shared_ptr <Train> train) {
 // This function simulates one time step for a given train in the simulation environment
 void Simulator::playTrainOneTimeStep(std::shared_ptr <Train> train)
 {
-	// Indicator to skip loading the train
-	bool skipTrainMove = false;
-
+	TraceRecorder::Span span("playTrainStep", "train", "trainID", train->id);
 	// Check if the train start time is passed
 	// if such, load train first and then run the simulation
-	if (this->simulationTime >= train->trainStartTime && !train->loaded) {
-		bool skipLoadingTrain = false;
-
-		// check if there is a train that is already loaded in the same node and still on the same starting node
-		for (std::shared_ptr <Train>& otherTrain : this->trains) {
-			// check if the train is loaded and not reached destination
-			if (otherTrain == train || !otherTrain->loaded || otherTrain->reachedDestination) { continue; }
-			// check if the train has the same starting node and the otherTrain still on the same starting node
-			if (otherTrain->trainPath.at(0) == train->trainPath.at(0) && 
-				otherTrain->travelledDistance <= otherTrain->totalLength) {
-				skipLoadingTrain = true;
-				break;
-			}
+	StepProfiler::Timer timer(this->profiler, train->id);
+	this->loadTrainIfReady(train);
+	timer.lap(StepProfiler::Phase::Loading);
+
+	// Continue if the train is loaded and its start time is past the current simulation time
+	if ((train->trainStartTime <= this->simulationTime) && train->loaded) {
+		TrainStepResult result;
+		result.train = train;
+		this->computeTrainOneTimeStep(train, result);
+		this->commitTrainOneTimeStep(result);
+	}
+
+	// Minimize waiting when no trains are on network
+	this->skipTimeIfNoTrainIsOnNetwork();
+}
+
+// Loads the train if its start time is passed and no other train is still on its starting node
+void Simulator::loadTrainIfReady(std::shared_ptr<Train> train)
+{
+	if (this->simulationTime < train->trainStartTime || train->loaded) { return; }
+
+	// check if there is a train that is already loaded in the same node and still on the same starting node
+	for (std::shared_ptr <Train>& otherTrain : this->trains) {
+		if (otherTrain == train) { continue; }
+		// trains that are not committed yet are observed at the start of the step
+		Train::StepSnapshot other = otherTrain->getObservedState();
+		// check if the train is loaded and not reached destination
+		if (!other.loaded || other.reachedDestination) { continue; }
+		// check if the train has the same starting node and the otherTrain still on the same starting node
+		if (otherTrain->trainPath.at(0) == train->trainPath.at(0) &&
+			other.travelledDistance <= otherTrain->totalLength) {
+			// skip loading the train if there is any train at the same point
+			return;
 		}
-		// skip loading the train if there is any train at the same point
-		if (!skipLoadingTrain) {
-			// load train
-			this->loadTrain(train);
+	}
+	// load train
+	this->loadTrain(train);
+}
+
+// Computes the next state of a loaded train without touching any state shared with other trains
+void Simulator::computeTrainOneTimeStep(std::shared_ptr<Train> train, TrainStepResult &result)
+{
+	// Indicator to skip moving the train
+	bool skipTrainMove = false;
+	// times the phases of the train step when profiling
+	StepProfiler::Timer timer(this->profiler, train->id);
+
+	// holds track data and speed
+    tuple<Vector<double>, Vector<double>, Vector<double>, Vector<std::shared_ptr<NetLink>>> linksdata;
+	// Load path geometric data for each vehicle in the train (at mass centroid of each)
+	linksdata = this->loadTrainLinksData(train, false);
+	// train spanned links curvatures
+	Vector<double> curvatures = std::get<0>(linksdata);
+	// train spanned links grades
+	Vector<double> grades = std::get<1>(linksdata);
+	// train spanned links free flow speed
+	Vector<double> freeFlowSpeed = std::get<2>(linksdata);
+	// train spanned links
+	Vector<std::shared_ptr<NetLink>> links = std::get<3>(linksdata);
+
+	// the free flow speed of the tip of the train
+	double currentLinkFreeSpeed = this->loadTrainFreeSpeed(train);
+	// the spanned links of the train
+	train->setTrainsCurrentLinks(links);
+	// all previous links the train passed on
+	for (const std::shared_ptr<NetLink> &link : train->currentLinks) {
+		if (!train->previousLinks.exist(link)) {
+			train->previousLinks.push_back(link);
 		}
 	}
+	// the max speed the train cannot go higher than
+	double currentFreeFlowSpeed = std::min(currentLinkFreeSpeed, freeFlowSpeed.min());
+
+	// set the train memorization parameters to speed up the calculations later
+	train->previousNodeID = this->network->getPreviousNodeByDistance(train, train->travelledDistance, train->previousNodeID)->id;
+	train->advanceRouteCursor(train->previousNodeID);
+	double lastTrainTipTravelledDistance = train->travelledDistance - train->totalLength;
+	if (lastTrainTipTravelledDistance < 0.0) { lastTrainTipTravelledDistance = 0.0; }
+	int LastTrainTipPreviousNodeID;
+	LastTrainTipPreviousNodeID = (train->LastTrainPointpreviousNodeID <= 0.0) ? train->trainPath[0] : train->LastTrainPointpreviousNodeID;
+	train->LastTrainPointpreviousNodeID = this->network->getPreviousNodeByDistance(train, 
+		lastTrainTipTravelledDistance, LastTrainTipPreviousNodeID)->id;
+	timer.lap(StepProfiler::Phase::LinksData);
+// ##################################################################
+// #                      start: critical points                    #
+// ##################################################################
+    auto nextStop = this->getNextStoppingNodeID(train, train->previousNodeID);
+    int nextStoppingNodeID = nextStop.first.first;
+    auto nextStopNode = nextStop.first.second;
+	bool isSignal = nextStop.second;
+
+	// the map defines all lower nodes/points in its path.
+	// the map has the train point ids as keys and its speed as its values
+	Map<int, double> lowerSpeedsNs = this->getAllLowerSpeedsIDs(train, train->previousNodeID, nextStoppingNodeID);
+
+	// this tuple defines the critical points in the train path. the critical points include 
+	// 1. lower speed links (critical point is the start of the link),
+	// 2. leading trains (critical point is the end of the train),
+	// 3. stopping station or depot.
+	// The tuple takes 3 vectors: 
+	// 1. vector 0 is for distances to critical point, 
+	// 2. vector 1 is a bool indicating the critical point is a train,
+	// 3. vector 2 is for speed of the critical point.
+    tuple<Vector<double>, Vector<bool>, Vector<double>> criticalPointsDefinition;
+
+	// add all lower speed points to their corresponding lists
+	for (pair<int, double> lwrSpeedNS: lowerSpeedsNs) {
+		std::get<0>(criticalPointsDefinition).push_back(this->network->getDistanceToSpecificNodeByTravelledDistance(
+		train, train->travelledDistance, lwrSpeedNS.first));
+		std::get<1>(criticalPointsDefinition).push_back(false);
+		std::get<2>(criticalPointsDefinition).push_back(lwrSpeedNS.second);
+	}
+	// the distance to the stopping station, the train stops there regardless of any train beyond it
+	double distanceToStop = this->network->getDistanceToSpecificNodeByTravelledDistance(train, 
+		train->travelledDistance, nextStoppingNodeID);
+	// add the leading train to the list
+	std::pair<std::shared_ptr<Train>, double> trainAheadWithDistance =
+		this->getAheadTrainAndGap(train, std::min(distanceToStop, DefaultLeaderLookAheadDistance));
+	if (trainAheadWithDistance.first != nullptr) {
+		std::get<0>(criticalPointsDefinition).push_back(trainAheadWithDistance.second);
+		std::get<1>(criticalPointsDefinition).push_back(true);
+		std::get<2>(criticalPointsDefinition).push_back(trainAheadWithDistance.first->getObservedState().currentSpeed);
+	}
+	// add the stopping station to the list
+	std::get<0>(criticalPointsDefinition).push_back(distanceToStop);
+	std::get<1>(criticalPointsDefinition).push_back(false);
+	std::get<2>(criticalPointsDefinition).push_back(0.0);
+// ##################################################################
+// #                      end: critical points                    #
+// ##################################################################
 
-	// Continue if the train is loaded and its start time is past the current simulation time
-	if ((train->trainStartTime <= this->simulationTime) && train->loaded) {
+	// check if the next stop is a network signal, if yes and distance is very small, stop the train
+    if (isSignal || nextStopNode->isTerminal) {
+
+        // check if decelerating and there is almost no distance between
+        // the head of the train and the station/signal
+        if ((train->currentAcceleration < 0 &&
+             std::get<0>(criticalPointsDefinition).back() <= train->currentSpeed * this->timeStep) ||
+            (train->currentSpeed == 0.0 && std::get<0>(criticalPointsDefinition).back() <= 1.0)) {
+            train->immediateStop(this->timeStep); // immediate stop at the signal line/ station
+
+            // for terminal case only
+            if (nextStopNode->isTerminal) {
+                // Check if the train hasn't started its terminal dwell time yet
+                if (!train->isCurrentlyDwelling()) {
+                    train->forceTrainToStopFor(nextStopNode->dwellTimeIfTerminal,
+                                               this->simulationTime);
+
+                    // the listeners are notified when the step is committed
+                    result.reachedTerminal = true;
+                    result.terminalNode = nextStopNode;
+                }
+                // Skip movement if we're still within the dwell time
+                if (train->getRemainingDwellTime(this->simulationTime) > 0) {
+                    skipTrainMove = true;
+                }
+            }
+            else {
+                skipTrainMove = true;
+            }
+        }
+    }
+	else {
+		if ((std::get<0>(criticalPointsDefinition).size() == 1) && (train->currentAcceleration < 0.0) &&
+			((std::round(train->previousSpeed * 1000.0) / 1000.0) == 0.0) &&
+			((std::round(train->currentSpeed * 1000.0) / 1000.0) == 0.0)) {
+			train->kickForwardADistance(std::get<0>(criticalPointsDefinition).back());
+		}
+	}
+
+	// set memorization parameters for the train
+	train->nextNodeID = train->trainPath.at(train->routeCursor + 1);
+	timer.lap(StepProfiler::Phase::CriticalPoints);
+
+	if (!skipTrainMove) {
+        train->resetDwellState();
+        train->updateGradesCurvatures(grades, curvatures);
+        // calculate the reduction factor if the power source cannot supply the demand of energy
+        // reset the restrictions every time step
+        train->resetPowerRestriction();
+        // check if a notch reduction is required
+        // calculate the accelerations and speed
+        double stepAcc = train->getStepAcceleration(this->timeStep, currentFreeFlowSpeed, std::get<0>(criticalPointsDefinition),
+                                         std::get<1>(criticalPointsDefinition), std::get<2>(criticalPointsDefinition));
+        double stepSpd = train->speedUpDown(train->previousSpeed, stepAcc, this->timeStep, currentFreeFlowSpeed);
+        // calculate approximate power required
+        pair<Vector<double>, double> out = train->getTractivePower(stepSpd, stepAcc, train->currentResistanceForces);
+        double averageSpd = (stepSpd + train->previousSpeed) / ((double)2.0);
+        // calculate approximate energy required
+        double stepEC = train->getTotalEnergyConsumption(this->timeStep, averageSpd, stepAcc, out.first);
+        // calculate approximate max energy supplied at this time step
+        double maxEC = train->getMaxProvidedEnergy(this->timeStep).first;
+        // If the stepEC is larger than what the train can consume in a time step,
+        // reduce the locomotives power
+        if (stepEC > maxEC) {
+            double reductionFactor = maxEC / stepEC;
+            train->reducePower(reductionFactor);
+        }
+        timer.lap(StepProfiler::Phase::Dynamics);
+		// move the train forward
+        train->moveTrain(this->simulationTime, this->timeStep, currentFreeFlowSpeed, std::get<0>(criticalPointsDefinition),
+			std::get<1>(criticalPointsDefinition), std::get<2>(criticalPointsDefinition));
+	}
+	// handle when the train reaches its destinations
+    if (train->reachedDestination) {
+		train->calcTrainStats(freeFlowSpeed, currentFreeFlowSpeed, this->timeStep, train->currentFirstLink->region);
+		timer.lap(StepProfiler::Phase::Movement);
+	}
+	// handles when the train still has distance to travel
+	else {
+		train->currentCoordinates = this->network->getPositionbyTravelledDistance(train, train->travelledDistance);
+		// other trains may still read the old points, they are replaced when the step is committed
+		result.startEndPoints = this->getStartEndPoints(train, train->currentCoordinates);
+		train->calcTrainStats(freeFlowSpeed, currentFreeFlowSpeed, this->timeStep, train->currentFirstLink->region);
+		timer.lap(StepProfiler::Phase::Movement);
 
 		// holds track data and speed
         tuple<Vector<double>, Vector<double>, Vector<double>, Vector<std::shared_ptr<NetLink>>> linksdata;
 		// Load path geometric data for each vehicle in the train (at mass centroid of each)
 		linksdata = this->loadTrainLinksData(train, false);
-		// train spanned links curvatures
-		Vector<double> curvatures = std::get<0>(linksdata);
-		// train spanned links grades
-		Vector<double> grades = std::get<1>(linksdata);
-		// train spanned links free flow speed
-		Vector<double> freeFlowSpeed = std::get<2>(linksdata);
-		// train spanned links
-		Vector<std::shared_ptr<NetLink>> links = std::get<3>(linksdata);
-
-		// the free flow speed of the tip of the train
-		double currentLinkFreeSpeed = this->loadTrainFreeSpeed(train);
+		links = std::get<3>(linksdata);
 		// the spanned links of the train
 		train->setTrainsCurrentLinks(links);
+		// the first link the train is on
+		train->currentFirstLink = links.at(0);
 		// all previous links the train passed on
 		for (const std::shared_ptr<NetLink> &link : train->currentLinks) {
 			if (!train->previousLinks.exist(link)) {
 				train->previousLinks.push_back(link);
 			}
 		}
-		// the max speed the train cannot go higher than
-		double currentFreeFlowSpeed = std::min(currentLinkFreeSpeed, freeFlowSpeed.min());
-
-		// set the train memorization parameters to speed up the calculations later
-		train->previousNodeID = this->network->getPreviousNodeByDistance(train, train->travelledDistance, train->previousNodeID)->id;
-		double lastTrainTipTravelledDistance = train->travelledDistance - train->totalLength;
-		if (lastTrainTipTravelledDistance < 0.0) { lastTrainTipTravelledDistance = 0.0; }
-		int LastTrainTipPreviousNodeID;
-		LastTrainTipPreviousNodeID = (train->LastTrainPointpreviousNodeID <= 0.0) ? train->trainPath[0] : train->LastTrainPointpreviousNodeID;
-		train->LastTrainPointpreviousNodeID = this->network->getPreviousNodeByDistance(train, 
-			lastTrainTipTravelledDistance, LastTrainTipPreviousNodeID)->id;
-// ##################################################################
-// #                      start: critical points                    #
-// ##################################################################
-        auto nextStop = this->getNextStoppingNodeID(train, train->previousNodeID);
-        int nextStoppingNodeID = nextStop.first.first;
-        auto nextStopNode = nextStop.first.second;
-		bool isSignal = nextStop.second;
-
-		// the map defines all lower nodes/points in its path.
-		// the map has the train point ids as keys and its speed as its values
-		Map<int, double> lowerSpeedsNs = this->getAllLowerSpeedsIDs(train, train->previousNodeID, nextStoppingNodeID);
-
-		// this tuple defines the critical points in the train path. the critical points include 
-		// 1. lower speed links (critical point is the start of the link),
-		// 2. leading trains (critical point is the end of the train),
-		// 3. stopping station or depot.
-		// The tuple takes 3 vectors: 
-		// 1. vector 0 is for distances to critical point, 
-		// 2. vector 1 is a bool indicating the critical point is a train,
-		// 3. vector 2 is for speed of the critical point.
-        tuple<Vector<double>, Vector<bool>, Vector<double>> criticalPointsDefinition;
-
-		// add all lower speed points to their corresponding lists
-		for (pair<int, double> lwrSpeedNS: lowerSpeedsNs) {
-			std::get<0>(criticalPointsDefinition).push_back(this->network->getDistanceToSpecificNodeByTravelledDistance(
-			train, train->travelledDistance, lwrSpeedNS.first));
-			std::get<1>(criticalPointsDefinition).push_back(false);
-			std::get<2>(criticalPointsDefinition).push_back(lwrSpeedNS.second);
-		}
-		// add the leading train to the list
-		std::pair<std::shared_ptr<Train>, double> trainAheadWithDistance = this->getAheadTrainAndGap(train);
-		if (trainAheadWithDistance.first != nullptr) {
-			std::get<0>(criticalPointsDefinition).push_back(trainAheadWithDistance.second);
-			std::get<1>(criticalPointsDefinition).push_back(true);
-			std::get<2>(criticalPointsDefinition).push_back(trainAheadWithDistance.first->currentSpeed);
-		}
-		// add the stopping station to the list
-		double distanceToStop = this->network->getDistanceToSpecificNodeByTravelledDistance(train, 
-			train->travelledDistance, nextStoppingNodeID);
-		std::get<0>(criticalPointsDefinition).push_back(distanceToStop);
-		std::get<1>(criticalPointsDefinition).push_back(false);
-		std::get<2>(criticalPointsDefinition).push_back(0.0);
-// ##################################################################
-// #                      end: critical points                    #
-// ##################################################################
 
-		// check if the next stop is a network signal, if yes and distance is very small, stop the train
-        if (isSignal || nextStopNode->isTerminal) {
+		// the links that the train is spanning are updated when the step is committed
+		result.onNetwork = true;
+		timer.lap(StepProfiler::Phase::LinksData);
+	}
+	// the links are shared by the trains, the catenary energy is added to
+	// them when the step is committed
+	result.catenaryEnergy = train->takeCatenaryEnergy();
+
+	// write the trajectory step data
+	if (this->exportTrajectory) {
+		TrajectoryWriter::Record &record = result.trajectoryRecord;
+		record.simulationTime = this->simulationTime;
+		record.travelledDistance = train->travelledDistance;
+		record.acceleration = train->currentAcceleration;
+		record.speed = train->currentSpeed;
+		record.linkMaxSpeed = currentFreeFlowSpeed;
+		record.energyConsumption = train->energyStat;
+		record.delayTimeToEach = train->maxDelayTimeStat;
+		record.delayTime = train->delayTimeStat;
+		record.stoppings = train->stoppedStat;
+		record.tractiveForce = train->currentTractiveForce;
+		record.resistanceForces = train->currentResistanceForces;
+		record.usedTractivePower = train->currentUsedTractivePower;
+		record.grade = grades[0];
+		record.curvature = curvatures[0];
+		record.firstLocoNotch = train->locomotives[0]->currentLocNotch;
+		record.optimizationEnabled = train->optimize;
+
+		// the step trajectory data is queued for the file when the step is committed
+		result.hasTrajectoryRecord = true;
+		timer.lap(StepProfiler::Phase::Output);
+	}
+}
 
-            // check if decelerating and there is almost no distance between
-            // the head of the train and the station/signal
-            if ((train->currentAcceleration < 0 &&
-                 std::get<0>(criticalPointsDefinition).back() <= train->currentSpeed * this->timeStep) ||
-                (train->currentSpeed == 0.0 && std::get<0>(criticalPointsDefinition).back() <= 1.0)) {
-                train->immediateStop(this->timeStep); // immediate stop at the signal line/ station
+// Commits a computed train step in the trains order
+void Simulator::commitTrainOneTimeStep(TrainStepResult &result)
+{
+	std::shared_ptr<Train> &train = result.train;
+	TraceRecorder::Span span("commitTrainStep", "train", "trainID", train->id);
+	train->stepSnapshot.pending = false;
 
-                // for terminal case only
-                if (nextStopNode->isTerminal) {
-                    // Check if the train hasn't started its terminal dwell time yet
-                    if (!train->isCurrentlyDwelling()) {
-                        train->forceTrainToStopFor(nextStopNode->dwellTimeIfTerminal,
-                                                   this->simulationTime);
+	// report the failure of the train step where the serial stepping would have
+	if (result.error) { std::rethrow_exception(result.error); }
 
 #ifdef BUILD_SERVER_ENABLED
-                        /// handle when the port is saved by
-                        /// either the port number of the port desc
-                        QString portName =
-                            QString::number(nextStopNode->userID);
-                        QString portDesc =
-                            QString::fromStdString(nextStopNode->alphaDesc);
-
-                        auto containerCount =
-                            train->countContainersLeavingAtPort({portName,
-                                                                 portDesc});
-                        emit trainReachedTerminal(
-                            QString::fromStdString(train->trainUserID),
-                            containerCount.first,
-                            containerCount.second);
+	if (result.reachedTerminal) {
+		/// handle when the port is saved by
+		/// either the port number of the port desc
+		QString portName =
+			QString::number(result.terminalNode->userID);
+		QString portDesc =
+			QString::fromStdString(result.terminalNode->alphaDesc);
+
+		auto containerCount =
+			train->countContainersLeavingAtPort({portName,
+												 portDesc});
+		emit trainReachedTerminal(
+			QString::fromStdString(train->trainUserID),
+			containerCount.first,
+			containerCount.second);
+	}
 #endif
-                    }
-                    // Skip movement if we're still within the dwell time
-                    if (train->getRemainingDwellTime(this->simulationTime) > 0) {
-                        skipTrainMove = true;
-                    }
-                }
-                else {
-                    skipTrainMove = true;
-                }
-            }
-        }
-		else {
-			if ((std::get<0>(criticalPointsDefinition).size() == 1) && (train->currentAcceleration < 0.0) &&
-				((std::round(train->previousSpeed * 1000.0) / 1000.0) == 0.0) &&
-				((std::round(train->currentSpeed * 1000.0) / 1000.0) == 0.0)) {
-				train->kickForwardADistance(std::get<0>(criticalPointsDefinition).back());
-			}
-		}
 
-		// set memorization parameters for the train
-		train->nextNodeID = train->trainPath.at(train->trainPath.index(train->previousNodeID) + 1);
-
-		if (!skipTrainMove) {
-            train->resetDwellState();
-            train->updateGradesCurvatures(grades, curvatures);
-            // calculate the reduction factor if the power source cannot supply the demand of energy
-            // reset the restrictions every time step
-            train->resetPowerRestriction();
-            // check if a notch reduction is required
-            // calculate the accelerations and speed
-            double stepAcc = train->getStepAcceleration(this->timeStep, currentFreeFlowSpeed, std::get<0>(criticalPointsDefinition),
-                                             std::get<1>(criticalPointsDefinition), std::get<2>(criticalPointsDefinition));
-            double stepSpd = train->speedUpDown(train->previousSpeed, stepAcc, this->timeStep, currentFreeFlowSpeed);
-            // calculate approximate power required
-            pair<Vector<double>, double> out = train->getTractivePower(stepSpd, stepAcc, train->currentResistanceForces);
-            double averageSpd = (stepSpd + train->previousSpeed) / ((double)2.0);
-            // calculate approximate energy required
-            double stepEC = train->getTotalEnergyConsumption(this->timeStep, averageSpd, stepAcc, out.first);
-            // calculate approximate max energy supplied at this time step
-            double maxEC = train->getMaxProvidedEnergy(this->timeStep).first;
-            // If the stepEC is larger than what the train can consume in a time step,
-            // reduce the locomotives power
-            if (stepEC > maxEC) {
-                double reductionFactor = maxEC / stepEC;
-                train->reducePower(reductionFactor);
-            }
-			// move the train forward
-            train->moveTrain(this->simulationTime, this->timeStep, currentFreeFlowSpeed, std::get<0>(criticalPointsDefinition),
-				std::get<1>(criticalPointsDefinition), std::get<2>(criticalPointsDefinition));
-		}
-		// handle when the train reaches its destinations
-        if (train->reachedDestination) {
-			train->calcTrainStats(freeFlowSpeed, currentFreeFlowSpeed, this->timeStep, train->currentFirstLink->region);
-		}
-		// handles when the train still has distance to travel
-		else {
-			train->currentCoordinates = this->network->getPositionbyTravelledDistance(train, train->travelledDistance);
-			train->startEndPoints = this->getStartEndPoints(train, train->currentCoordinates);
-			train->calcTrainStats(freeFlowSpeed, currentFreeFlowSpeed, this->timeStep, train->currentFirstLink->region);
-
-			// holds track data and speed
-            tuple<Vector<double>, Vector<double>, Vector<double>, Vector<std::shared_ptr<NetLink>>> linksdata;
-			// Load path geometric data for each vehicle in the train (at mass centroid of each)
-			linksdata = this->loadTrainLinksData(train, false);
-			links = std::get<3>(linksdata);
-			// the spanned links of the train
-			train->setTrainsCurrentLinks(links);
-			// the first link the train is on
-			train->currentFirstLink = links.at(0);
-			// all previous links the train passed on
-			for (const std::shared_ptr<NetLink> &link : train->currentLinks) {
-				if (!train->previousLinks.exist(link)) {
-					train->previousLinks.push_back(link);
-				}
-			}
+	// add the catenary energy in the trains order, so the sums do not
+	// depend on the threads
+	for (const TrainComponent::CatenaryEnergy &energy : result.catenaryEnergy) {
+		energy.link->catenaryCumConsumedEnergy += energy.consumed;
+		energy.link->catenaryCumRegeneratedEnergy += energy.regenerated;
+	}
 
-			// Update the links that the train is spanning
-			this->setOccupiedLinksByTrains(train);
-		}
+	if (result.onNetwork) {
+		train->startEndPoints = result.startEndPoints;
+		// Update the links that the train is spanning
+		this->setOccupiedLinksByTrains(train);
+	}
 
-		// write the trajectory step data
-		if (this->exportTrajectory) {
-            std::stringstream exportLine;
-            exportLine << train->trainUserID << ","
-                       << this->simulationTime << ","
-                       << train->travelledDistance << ","
-                       << train->currentAcceleration << ","
-                       << train->currentSpeed << ","
-                       << currentFreeFlowSpeed << ","
-                       << train->energyStat << ","
-                       << train->maxDelayTimeStat << ","
-                       << train->delayTimeStat << ","
-                       << train->stoppedStat << ","
-                       << train->currentTractiveForce << ","
-                       << train->currentResistanceForces << ","
-                       << train->currentUsedTractivePower << ","
-                       << grades[0] << ","
-                       << curvatures[0] << ","
-                       << train->locomotives[0]->currentLocNotch << ","
-                       << train->optimize
-                       << std::endl;
-
-			// write the step trajectory data to the file
-			this->trajectoryFile << exportLine.str();
+	// queue the step trajectory data for the file
+	if (result.hasTrajectoryRecord) {
+		StepProfiler::Timer timer(this->profiler, train->id);
+		result.trajectoryRecord.trainIndex =
+			this->trajectoryWriter.registerTrain(train->trainUserID);
+		this->trajectoryWriter.write(result.trajectoryRecord);
+		timer.lap(StepProfiler::Phase::Output);
+	}
+}
 
+// Minimize waiting when no trains are on network
+void Simulator::skipTimeIfNoTrainIsOnNetwork()
+{
+	if (this->checkNoTrainIsOnNetwork()) {
+		double shiftTime = this->getNotLoadedTrainsMinStartTime();
+		if (shiftTime > this->simulationTime) {
+			this->simulationTime = shiftTime;
 		}
 	}
-
-    // Minimize waiting when no trains are on network
-    if (this->checkNoTrainIsOnNetwork()) {
-        double shiftTime = this->getNotLoadedTrainsMinStartTime();
-        if (shiftTime > this->simulationTime) {
-            this->simulationTime = shiftTime;
-        }
-    }
 }
 
 bool Simulator::checkNoTrainIsOnNetwork() {
     for (std::shared_ptr<Train>& t : (this->trains)) {
-        if (t->loaded && ! t->reachedDestination) {
+        Train::StepSnapshot state = t->getObservedState();
+        if (state.loaded && ! state.reachedDestination) {
             return false;
         }
     }
@@ -809,6 +1025,8 @@ double Simulator::getNotLoadedTrainsMinStartTime() {
 void Simulator::PlayTrainVirtualStepsAStarOptimization(std::shared_ptr<Train> train, double timeStep){
 
 	if (train->trainStartTime <= this->simulationTime){
+		TraceRecorder::Span span("aStarLookAhead", "train", "trainID", train->id);
+		StepProfiler::Timer timer(this->profiler, train->id);
 
 		train->virtualTravelledDistance = train->travelledDistance;
 		double speed = train->currentSpeed;
@@ -823,8 +1041,8 @@ void Simulator::PlayTrainVirtualStepsAStarOptimization(std::shared_ptr<Train> tr
 			auto CurrentFreeSpeed_ms = std::get<2>(linksData).min();
 
 			unsigned int pindx = 0;
-			for (int i = 0; i < train->linksCumLengths.size() ; i++) {
-				if (train->linksCumLengths[i] >= train->virtualTravelledDistance) {
+			for (int i = 0; i < train->route->cumLengths.size() ; i++) {
+				if (train->route->cumLengths[i] >= train->virtualTravelledDistance) {
 					pindx = i-1;
 					break;
 				}
@@ -861,84 +1079,68 @@ void Simulator::PlayTrainVirtualStepsAStarOptimization(std::shared_ptr<Train> tr
 		}
 
 		train->pickOptimalThrottleLevelAStar(throttleLevelVec, train->lookAheadCounterToUpdate);
+		timer.lap(StepProfiler::Phase::AStarLookAhead);
 	}
 }
 
 
-Vector<Vector<Vector < std::shared_ptr<NetNode>>>> Simulator::getConflictTrainsIntersections() {
-	Vector<Vector<Vector < std::shared_ptr<NetNode>>>> trainSignalsGroups(this->trains.size(), Vector<Vector < std::shared_ptr<NetNode>>>(this->trains.size()));
-	if (this->trains.size() < 2) {return trainSignalsGroups;}
-	vector<pair<std::shared_ptr<Train>, std::shared_ptr<Train>>> ts;
-	for (int i = 0; i < this->trains.size(); ++i) {
-        if (this->trains.at(i)->reachedDestination) { continue; }
-		// if the train has the same nodes as the previous train, skip it
-		if (i > 0){
-			int prevI = i - 1;
-			if (this->trains.at(i)->trainPath.isSubsetOf(this->trains.at(prevI)->trainPath) ||
-					this->trains.at(prevI)->trainPath.isSubsetOf(this->trains.at(i)->trainPath)) {
-				continue;
+void Simulator::defineSignalsGroups(double& minSafeDistance) {
+	// only the trains added since the groups were last defined are grouped,
+	// the controllers of the groups they change are created or extended
+	int groupedTrainsCount = this->signalGroupsBuilder.getTrainsCount();
+	this->calculateSignalsProximities();
+	Vector<std::set<std::shared_ptr<NetNode>>> nodesGroup =
+		this->signalGroupsBuilder.update(this->network, this->trains, minSafeDistance);
+
+	std::set<NetSignalGroupControllerWithQueuing*> changedControllers;
+	for (int i = 0; i < nodesGroup.size(); i++) {
+		std::set<std::shared_ptr<NetNode>>& group = nodesGroup.at(i);
+
+		// the controllers already at the group nodes
+		std::set<std::shared_ptr<NetSignalGroupControllerWithQueuing>> controllers;
+		for (const std::shared_ptr<NetNode>& n : group) {
+			if (n->id < this->signalsGroups.size() && this->signalsGroups[n->id] != nullptr) {
+				controllers.insert(this->signalsGroups[n->id]);
 			}
 		}
 
-		for (int j = i + 1; j < this->trains.size(); ++j) {
-			if (i == j) { continue; }
-			ts.emplace_back(this->trains.at(i), this->trains.at(j));
-		}
-	}
-	if (ts.empty()) {
-		return trainSignalsGroups;
-	}
-	else {
-		for (auto& t : ts) {
-			Vector<std::shared_ptr<NetNode>> intersections = this->getTrainsIntersections(t.first, t.second);
-			trainSignalsGroups[t.first->id][t.second->id] = intersections;
-		}
-		return trainSignalsGroups;
-	}
-}
-Vector<std::shared_ptr<NetNode>> Simulator::getTrainsIntersections(std::shared_ptr<Train> train1, std::shared_ptr<Train> train2) {
-	Vector<std::shared_ptr<NetNode>> intersections;
-	for (std::shared_ptr<NetNode>& value : train1->trainPathNodes) {
-		if (find(train2->trainPathNodes.begin(), train2->trainPathNodes.end(), value) != train2->trainPathNodes.end()) {
-			// check if the node has signals, if yes, add it to control
-			if (value->networkSignals.size() > 0){
-				intersections.push_back(value);
+		// a group that grew from one controller extends it, a new group or
+		// a group merging controllers gets a new controller
+		std::shared_ptr<NetSignalGroupControllerWithQueuing> s = nullptr;
+		if (controllers.size() == 1) {
+			s = *controllers.begin();
+			for (const std::shared_ptr<NetNode>& n : group) {
+				s->addNode(n);
 			}
 		}
-	}
-	return intersections;
-}
-
-Vector<std::set<std::shared_ptr<NetNode>>> Simulator::getNodesIntersectionsForSignals(double& minSafeDistance) {
-	Vector<Vector<Vector < std::shared_ptr<NetNode>>>> ConflictTrainsIntersections = this->getConflictTrainsIntersections();
-	Vector<Vector< Map<int, std::set<std::shared_ptr<NetNode>>>>> GS =
-		this->getNodeGroupsForSignals(ConflictTrainsIntersections, minSafeDistance);
-	auto r = this->unionNodesIntersectionsForSignals(GS);
-	return r;
-}
-
-void Simulator::defineSignalsGroups(double& minSafeDistance) {
-	this->calculateSignalsProximities();
-	Vector<std::set<std::shared_ptr<NetNode>>> nodesGroup = this->getNodesIntersectionsForSignals(minSafeDistance);
-	for (int i = 0; i < nodesGroup.size(); i++) {
-		std::set<std::shared_ptr<NetNode>> group = nodesGroup.at(i);
-        std::shared_ptr<NetSignalGroupControllerWithQueuing> s =
-            std::make_shared< NetSignalGroupControllerWithQueuing>(NetSignalGroupControllerWithQueuing(group, this->timeStep));
-        //s->confinedLinks = this->getLinksByNodes(nodesGroup.at(i));
+		else {
+			s = std::make_shared< NetSignalGroupControllerWithQueuing>(NetSignalGroupControllerWithQueuing(group, this->timeStep));
+		}
+		//s->confinedLinks = this->getLinksByNodes(nodesGroup.at(i));
 
-		for (std::shared_ptr<NetNode> n : group) {
-			this->signalsGroups[n] = s;
+		for (const std::shared_ptr<NetNode>& n : group) {
+			if (n->id >= this->signalsGroups.size()) {
+				this->signalsGroups.resize(n->id + 1, nullptr);
+			}
+			this->signalsGroups[n->id] = s;
+			// the signals are at their current node, they use its controller
+			for (auto& networkSignal : n->networkSignals) {
+				networkSignal->controller = s.get();
+			}
 		}
+		changedControllers.insert(s.get());
 	}
-	
+	this->setTrainsRouteSignals(groupedTrainsCount, changedControllers);
 }
 
 void Simulator::calculateSignalsProximities() {
+	// all the trains are measured at their current speeds, as a full rebuild
+	// would, so adding trains gives the same proximities
 	for (auto &s : this->network->networkSignals) {
 		Vector<double> proximity;
-		for (auto &t : this->trains) {
-			if (t->trainPathNodes.exist(std::shared_ptr<NetNode>(s->currentNode)) && 
-				t->trainPathNodes.exist(std::shared_ptr<NetNode>(s->previousNode))) {
+		for (const std::shared_ptr<Train>& t : this->trains) {
+			if (t->getPathIndex(s->currentNode.lock()->id) >= 0 &&
+				t->getPathIndex(s->previousNode.lock()->id) >= 0) {
                 proximity.push_back(t->getSafeGap(t->getMinFollowingTrainGap(),
                                                   t->currentSpeed, s->link.lock()->freeFlowSpeed,
                                                   t->T_s, true));
@@ -950,118 +1152,6 @@ void Simulator::calculateSignalsProximities() {
 	}
 }
 
-Vector<Vector< Map<int, std::set<std::shared_ptr<NetNode>>>>> Simulator::getNodeGroupsForSignals(
-		Vector<Vector<Vector < std::shared_ptr<NetNode>>>> ConflictTrainsIntersections, double& minSafeDistance) {
-
-	Vector<Vector< Map<int, std::set<std::shared_ptr<NetNode>>>>> nodesGroups(this->trains.size(),
-		Vector<Map<int, std::set<std::shared_ptr<NetNode>>>>(this->trains.size()));
-
-	if (this->trains.size() < 2) { return nodesGroups; }
-	for (int t1i = 0; t1i < ConflictTrainsIntersections.size(); t1i++) {
-		for (int t2i = 0; t2i < ConflictTrainsIntersections.at(t1i).size(); t2i++) {
-			// if it is the same train, skip
-			if (t1i == t2i) { continue; }
-			// get the conflicts of train t1i and t2i
-			Vector<std::shared_ptr<NetNode>> trainIntersections = ConflictTrainsIntersections[t1i][t2i];
-			// if the intersections is empty, skip
-			if (trainIntersections.size() < 1) { continue; }
-			// map of group number and nodes of intersections
-			Map<int, std::set<std::shared_ptr<NetNode>>> G;
-			int gn = 0;
-			// loop over all intersecting nodes
-			for (int i = 0; i < trainIntersections.size() - 1; i++) {
-				int nextI = i + 1;
-				double d = this->network->getDistanceBetweenTwoNodes(this->trains.at(t1i), 
-					trainIntersections.at(i), trainIntersections.at(nextI));
-
-				// if the distance is short or the section has only 1 link, it is a conflict
-				// and shoud be controlled by one controller
-                if ((d < minSafeDistance) || (this->network->isConflictZone(this->trains.at(t1i),
-                                                                            trainIntersections.at(i),
-																			trainIntersections.at(nextI)))) {
-					G[gn].insert(trainIntersections.at(i)); 
-					G[gn].insert(trainIntersections.at(nextI)); 
-				}
-				else {
-					G[gn].insert(trainIntersections.at(i));
-					gn++;
-					G[gn].insert(trainIntersections.at(nextI));
-				}
-			}
-			nodesGroups[t1i][t2i] = G;
-		}
-	}
-	return nodesGroups;
-
-}
-
-Vector<std::set<std::shared_ptr<NetNode>>> Simulator::unionNodesIntersectionsForSignals(
-	Vector<Vector< Map<int, std::set<std::shared_ptr<NetNode>>>>> nodesGroups) {
-
-	Vector<std::set<std::shared_ptr<NetNode>>> unified;
-	for (int t1i = 0; t1i < nodesGroups.size(); t1i++) {
-		for (int t2i = 0; t2i < nodesGroups.at(t1i).size(); t2i++) {
-			Vector<std::set<std::shared_ptr<NetNode>>> g = nodesGroups.at(t1i).at(t2i).get_values();
-			if (g.size() < 1) { continue; }
-
-			bool isUnified = false;
-			for (int i = 0; i < g.size(); i++) {
-				for (int j = 0; j < unified.size(); j++){
-					isUnified = false;
-					std::set<std::shared_ptr<NetNode>> intersections;
-					std::set_intersection(g.at(i).begin(), g.at(i).end(), 
-											unified.at(j).begin(), unified.at(j).end(),
-											std::inserter(intersections, intersections.begin()));
-					if (!intersections.empty()) {
-						std::set<std::shared_ptr<NetNode>> union_set;
-						std::set_union(g.at(i).begin(), g.at(i).end(),
-										unified.at(j).begin(), unified.at(j).end(),
-										std::inserter(union_set, union_set.begin()));
-						unified.at(j) = union_set;
-						isUnified = true;
-					}
-				}
-				if (!isUnified) {
-					unified.push_back(g.at(i));
-				}
-			}
-		}
-	}
-	return removeRedundancy(unified);
-
-}
-
-Vector<std::set<std::shared_ptr<NetNode>>> Simulator::removeRedundancy(Vector<std::set<std::shared_ptr<NetNode>>> unified) {
-	bool needsAnotherRun = true;
-	while (needsAnotherRun) {
-		needsAnotherRun = false;
-		for (int i = 0; i < unified.size(); i++) {
-			if (unified.at(i).empty()) { continue; }
-			for (int j = 0; j < unified.size(); j++) {
-				if (i == j) { continue; }
-				if (unified.at(j).empty()) { continue; }
-
-				std::set<std::shared_ptr<NetNode>> intersections;
-				std::set_intersection(unified.at(i).begin(), unified.at(i).end(),
-					unified.at(j).begin(), unified.at(j).end(),
-					std::inserter(intersections, intersections.begin()));
-				if (!intersections.empty()) {
-					std::set<std::shared_ptr<NetNode>> union_set;
-					std::set_union(unified.at(i).begin(), unified.at(i).end(),
-						unified.at(j).begin(), unified.at(j).end(),
-						std::inserter(union_set, union_set.begin()));
-					unified.at(i) = union_set;
-					unified.at(j).clear();
-					needsAnotherRun = true;
-				}
-			}
-		}
-	}
-	unified.erase(std::remove_if(unified.begin(), unified.end(), [](const std::set<std::shared_ptr<NetNode>>& set) { return set.empty(); }), unified.end());
-	return unified;
-
-}
-
 /**
  * Gets links by nodes
  * @author	Ahmed
@@ -1080,7 +1170,8 @@ Vector<std::shared_ptr<NetLink>> Simulator::getLinksByNodes(std::set<std::shared
 			while (jt != nodes.end()) {
 				std::vector<std::shared_ptr<NetNode>> permutation = { *it, *jt };
 				// process permutation
-				Vector<std::shared_ptr<NetNode>> path = this->network->shortestPathSearch(it->get()->id, jt->get()->id).first;
+				std::shared_ptr<const NetRoute> route = this->network->getShortestRoute(it->get()->id, jt->get()->id);
+				const Vector<std::shared_ptr<NetNode>> &path = route->nodes;
 				if (!path.empty()) {
 					for (int i = 0; i < path.size() - 1; i++) {
 						int nextI = i + 1;
@@ -1122,6 +1213,7 @@ Vector<std::pair<double, double>> Simulator::getStartEndPoints(std::shared_ptr<T
 }
 
 void Simulator::runOneTimeStep() {
+    TraceRecorder::Span span("step", "simulator", "simulationTime", this->simulationTime);
 
     QVector<std::shared_ptr<Train>> trainsToSimulate;
 
@@ -1131,7 +1223,58 @@ void Simulator::runOneTimeStep() {
         trainsToSimulate = trains;
     }
 
-    for (std::shared_ptr <Train>& t : (trainsToSimulate)) {
+    // ##################################################################
+    // #              phase 1: compute the trains steps                 #
+    // ##################################################################
+    // the trains that are already moving on the network only change
+    // themselves, so their steps are computed from the state of the
+    // previous step; other trains observe them through their snapshots
+    std::vector<TrainStepResult> stepResults(trainsToSimulate.size());
+    for (qsizetype i = 0; i < trainsToSimulate.size(); i++) {
+        std::shared_ptr<Train> &t = trainsToSimulate[i];
+        stepResults[i].train = t;
+        stepResults[i].scheduled = t->loaded && !t->reachedDestination &&
+                                   t->trainStartTime <= this->simulationTime;
+        t->captureStepSnapshot(stepResults[i].scheduled);
+        this->profiler.registerTrain(t->id, t->trainUserID);
+    }
+
+    auto computeStep = [this](TrainStepResult &result) {
+        if (!result.scheduled) { return; }
+        try {
+            std::shared_ptr<Train> &t = result.train;
+            TraceRecorder::Span span("computeTrainStep", "train", "trainID", t->id);
+            if (t->optimize){
+                if (t->lookAheadCounterToUpdate <= 0) {
+                    t->resetTrainLookAhead();
+                    this->PlayTrainVirtualStepsAStarOptimization(t, this->timeStep);
+                }
+            }
+            this->computeTrainOneTimeStep(t, result);
+        } catch (...) {
+            result.error = std::current_exception();
+        }
+    };
+
+    if (this->threadsCount > 1) {
+        QtConcurrent::blockingMap(&this->stepThreadPool, stepResults, computeStep);
+    }
+    else {
+        std::for_each(stepResults.begin(), stepResults.end(), computeStep);
+    }
+
+    // ##################################################################
+    // #         phase 2: commit the steps in the trains order          #
+    // ##################################################################
+    for (TrainStepResult &result : stepResults) {
+        std::shared_ptr <Train> &t = result.train;
+        if (result.scheduled) {
+            this->commitTrainOneTimeStep(result);
+            this->skipTimeIfNoTrainIsOnNetwork();
+            this->trainStepsCount++;
+            continue;
+        }
+
         if (t->reachedDestination) { continue;  }
 
         if (t->optimize){
@@ -1141,9 +1284,12 @@ void Simulator::runOneTimeStep() {
             }
         }
 
+        // trains that are not on the network yet are loaded and stepped serially
         this->playTrainOneTimeStep(t);
+        if (t->loaded) { this->trainStepsCount++; }
     }
 
+    StepProfiler::Timer timer(this->profiler);
     if (plotFrequency > 0.0 && ((int(this->simulationTime) * 10) % (plotFrequency * 10)) == 0) {
         Vector<std::pair<std::string, Vector<std::pair<double,double>>>> trainsStartEndPoints;
         for (std::shared_ptr <Train>& t : (trainsToSimulate)) {
@@ -1152,11 +1298,15 @@ void Simulator::runOneTimeStep() {
         }
         emit this->plotTrainsUpdated(trainsStartEndPoints);
     }
-
+    timer.lap(StepProfiler::Phase::Output);
 
     this->runSignalsforTrains(trainsToSimulate);
+    timer.lap(StepProfiler::Phase::Signals);
 
     this->checkTrainsCollision(trainsToSimulate);
+    timer.lap(StepProfiler::Phase::Collision);
+    this->profiler.countStep();
+    this->stepsCount++;
 
     this->simulationTime += this->timeStep;
 
@@ -1171,21 +1321,14 @@ void Simulator::initializeSimulator(bool emitSignal)
             this, [this]() {
         generateSummaryData();
         exportSummaryToTXTFile();
+        exportSummaryToDatabase();
+        exportStepProfile();
         finalizeSimulation();
     });
 
     // define trajectory file and set it up
     if (this->exportTrajectory) {
         this->openTrajectoryFile();
-        std::stringstream exportLine;
-        exportLine << "TrainNo,TStep_s,TravelledDistance_m,Acceleration_mps2,"
-                   << "Speed_mps,LinkMaxSpeed_mps,"
-                   << "EnergyConsumption_KWH,DelayTimeToEach_s,DelayTime_s,"
-                   << "Stoppings,tractiveForce_N,"
-                   << "ResistanceForces_N,CurrentUsedTractivePower_kw,"
-                   << "GradeAtTip_Perc,CurvatureAtTip_Perc,"
-                   << "FirstLocoNotchPosition,optimizationEnabled\n";
-        this->trajectoryFile << exportLine.str();
     }
 
     init_time = std::chrono::system_clock::to_time_t(
@@ -1202,6 +1345,10 @@ void Simulator::runSimulation(double runFor,
 
     qDebug() << "Starting simulation.";
 
+    if (TraceRecorder::instance().isEnabled()) {
+        TraceRecorder::instance().setThreadName("simulator");
+    }
+
     // initialize the simulator only if it was not initialized earlier
     if (!mSimulatorInitialized) {
         initializeSimulator(false);
@@ -1642,11 +1789,12 @@ void Simulator::generateSummaryData() {
 
     std::string trajectoryFilePath = "";
     if (this->exportTrajectory) {
-        trajectoryFilePath = QDir(this->outputLocation).filePath(QString::fromStdString(this->trajectoryFilename)).toStdString();
+        // the trajectory file has to be complete before it is reported
+        this->trajectoryWriter.close();
+        trajectoryFilePath = this->getTrajectoryFilePath().toStdString();
     }
 
-    QString sfp =
-        QDir(this->outputLocation).filePath(QString::fromStdString(this->summaryFileName));
+    QString sfp = this->getSummaryFilePath();
 
     TrainsResults tr =
         TrainsResults(trainsSummaryData,
@@ -1657,34 +1805,107 @@ void Simulator::generateSummaryData() {
 }
 
 void Simulator::exportSummaryToTXTFile() {
+    TraceRecorder::Span span("exportSummary", "output");
 
     // setup the summary file
     this->openSummaryFile();
-    this->summaryFile << Utils::replaceAll(summaryTextData.str(), "\x1D", " ");
+    std::ostream &summary = this->compressOutput ?
+        static_cast<std::ostream&>(this->compressedSummaryFile) : this->summaryFile;
+    summary << Utils::replaceAll(summaryTextData.str(), "\x1D", " ");
     // ##################################################################
     // #                       end: summary file                      #
     // ##################################################################
-    this->summaryFile.close();
+    if (this->compressOutput) { this->compressedSummaryFile.close(); }
+    else { this->summaryFile.close(); }
+}
+
+void Simulator::exportSummaryToDatabase() {
+    if (!this->exportTrajectory ||
+        this->trajectoryWriter.getFormat() != TrajectoryWriter::Format::SQLite) {
+        return;
+    }
+
+    SQLiteResultsStore database;
+    if (!database.open(this->getTrajectoryFilePath(), this->resultsRunName)) {
+        qWarning() << "Could not add the trains summary to the results database";
+        return;
+    }
+    for (std::shared_ptr<Train>& t : this->trains) {
+        SQLiteResultsStore::TrainSummary summary;
+        summary.trainID = QString::fromStdString(t->trainUserID);
+        summary.reachedDestination = t->reachedDestination;
+        summary.startNode = t->trainPathNodes.at(0)->userID;
+        summary.destinationNode = t->trainPathNodes.back()->userID;
+        summary.pathLength = t->trainTotalPathLength;
+        summary.tripTime = t->tripTime;
+        summary.averageSpeed = t->averageSpeed;
+        summary.averageAcceleration = t->averageAcceleration;
+        summary.travelledDistance = t->travelledDistance;
+        summary.energyConsumption = t->cumEnergyStat;
+        summary.energyConsumed = t->totalEConsumed;
+        summary.energyRegenerated = t->totalERegenerated;
+        summary.delayTime = t->cumDelayTimeStat;
+        summary.maxDelayTime = t->cumMaxDelayTimeStat;
+        summary.stoppings = t->cumStoppedStat;
+        summary.cargoNetWeight = t->getCargoNetWeight();
+        summary.tonKm = t->getTrainTotalTorque();
+        summary.optimizationEnabled = t->optimize;
+        database.insertTrainSummary(summary);
+    }
+    database.close();
+}
+
+void Simulator::exportStepProfile() {
+    if (!this->profiler.isEnabled()) { return; }
+
+    QString filename = QString::fromStdString(this->stepProfileFilename);
+    if (!this->profiler.writeJson(QDir(this->outputLocation).filePath(filename))) {
+        qWarning() << "Could not write the step profile" << filename;
+    }
 }
 
 void Simulator::finalizeSimulation() {
-    this->trajectoryFile.close();
+    TraceRecorder::Span span("closeTrajectory", "output");
+    this->trajectoryWriter.close();
 }
 
 bool Simulator::checkTrainsCollision(QVector<std::shared_ptr<Train>> trainsList) {
-    QVector<std::pair<std::shared_ptr<Train>, std::shared_ptr<Train>>> comb;
-    for (int i = 0; i < trainsList.size() - 1; i++) {
-        for (int j = i + 1; j < trainsList.size(); j++) {
-            std::shared_ptr < Train> tt = trainsList.at(i);
-            comb.push_back( std::make_pair(trainsList.at(i),
-                                          trainsList.at(j)));
-		}
-	}
-	for (auto &t : comb) {
-        if (t.first->loaded && t.second->loaded && !t.first->offloaded &&
-            !t.second->offloaded && !t.first->reachedDestination &&
-            !t.second->reachedDestination)
+    TraceRecorder::Span span("collisionCheck", "simulator");
+    auto isOnNetwork = [](const std::shared_ptr<Train> &t) {
+        return t->loaded && !t->offloaded && !t->reachedDestination;
+    };
+
+    // broad phase: only trains sharing a link can collide, so the candidate
+    // pairs are collected from the trains occupying each spanned link
+    std::unordered_map<const Train*, int> trainsOrder;
+    trainsOrder.reserve(trainsList.size());
+    for (int i = 0; i < trainsList.size(); i++) {
+        trainsOrder.emplace(trainsList.at(i).get(), i);
+    }
+
+    Vector<std::pair<int, int>> candidates;
+    for (int i = 0; i < trainsList.size(); i++) {
+        const std::shared_ptr<Train> &t = trainsList.at(i);
+        if (!isOnNetwork(t)) { continue; }
+        for (const std::shared_ptr<NetLink> &link : t->currentLinks) {
+            for (const std::shared_ptr<Train> &other : link->currentTrains) {
+                auto it = trainsOrder.find(other.get());
+                if (it == trainsOrder.end() || it->second <= i) { continue; }
+                candidates.push_back(std::make_pair(i, it->second));
+            }
+        }
+    }
+    // keep the pairs order of the full pairwise check
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    // narrow phase
+    for (auto &c : candidates) {
+        std::pair<std::shared_ptr<Train>, std::shared_ptr<Train>> t =
+            std::make_pair(trainsList.at(c.first), trainsList.at(c.second));
+        if (isOnNetwork(t.first) && isOnNetwork(t.second))
         {
+            this->narrowPhaseCollisionChecks++;
             if (this->network->twoLinesIntersect(
                     t.first->startEndPoints[0],
                     t.first->startEndPoints[1],
@@ -1709,8 +1930,22 @@ bool Simulator::checkTrainsCollision(QVector<std::shared_ptr<Train>> trainsList)
 	return false;
 }
 
+unsigned long long Simulator::getNarrowPhaseCollisionChecksCount() const {
+    return this->narrowPhaseCollisionChecks;
+}
+
+unsigned long long Simulator::getStepsCount() const {
+    return this->stepsCount;
+}
+
+unsigned long long Simulator::getTrainStepsCount() const {
+    return this->trainStepsCount;
+}
+
 
 void Simulator::setTrainSimulatorPath() {
+	// the trains the simulator should find a path for, with the error of each search
+	std::vector<std::pair<std::shared_ptr<Train>, std::exception_ptr>> trainsToRoute;
 	for (std::shared_ptr <Train>& t : this->trains) {
         if (t->loaded || t->isSetup) { continue; }
 		// set the train path ids to the simulator ids instead of the users ids
@@ -1726,19 +1961,40 @@ void Simulator::setTrainSimulatorPath() {
 					continue;
 				}
 			}
-            // if the path is more than 2 nodes but the user wants the
-            // simulator to decide the path.
-            Vector<std::shared_ptr<NetNode>> nPath =
-                this->network->shortestPathSearch(t->trainPath[0],
-                                                  t->trainPath[1]).first;
-			Vector<int> path;
-			for (auto &n: nPath) {
-				path.push_back(n->id);
-			}
-			t->setTrainPath(path);
+            trainsToRoute.push_back(std::make_pair(t, std::exception_ptr()));
 		}
 	}
 
+    // if the path is more than 2 nodes but the user wants the
+    // simulator to decide the path.
+    // every search keeps its own state, so the trains are routed in parallel
+    auto routeTrain = [this](std::pair<std::shared_ptr<Train>, std::exception_ptr> &trainToRoute) {
+        try {
+            std::shared_ptr<Train> &t = trainToRoute.first;
+            // trains between the same nodes share the cached route
+            std::shared_ptr<const NetRoute> route =
+                this->network->getShortestRoute(t->trainPath[0],
+                                                t->trainPath[1]);
+            t->setTrainPath(route->nodeIDs);
+            t->setRoute(route);
+        } catch (...) {
+            trainToRoute.second = std::current_exception();
+        }
+    };
+
+    if (trainsToRoute.size() > 1) {
+        QtConcurrent::blockingMap(trainsToRoute, routeTrain);
+    }
+    else {
+        std::for_each(trainsToRoute.begin(), trainsToRoute.end(), routeTrain);
+    }
+
+    // report the first failed search in the trains order
+    for (auto &trainToRoute : trainsToRoute) {
+        if (trainToRoute.second) {
+            std::rethrow_exception(trainToRoute.second);
+        }
+    }
 }
 
 
@@ -1746,9 +2002,12 @@ void Simulator::setTrainSimulatorPath() {
 void Simulator::setTrainsPathNodes() {
 	for (std::shared_ptr<Train>& t : this->trains) {
         if (t->loaded || t->isSetup) { continue; }
-		for (int tpn : t->trainPath) {
-			t->trainPathNodes.push_back(this->network->getNodeByID(tpn));
+		// the user defined paths get their own route, the searched paths
+		// already hold the shared route
+		if (t->route == nullptr || t->route->nodeIDs != t->trainPath) {
+			t->setRoute(this->network->buildRoute(t->trainPath));
 		}
+		t->trainPathNodes = t->route->nodes;
 	}
 }
 void Simulator::setTrainPathLength() {
@@ -1759,18 +2018,108 @@ void Simulator::setTrainPathLength() {
 	}
 }
 
-void Simulator::turnOnAllSignals() {
-	for (auto& s : this->network->networkSignals) {
+void Simulator::turnOnRedSignals() {
+	for (auto& s : this->redSignals) {
 		s->isGreen = true;
 	}
+	this->redSignals.clear();
+}
+
+void Simulator::setTrainsRouteSignals(int firstTrainIndex,
+                                      const std::set<NetSignalGroupControllerWithQueuing*>& changedControllers) {
+	for (int ti = 0; ti < this->trains.size(); ti++) {
+		std::shared_ptr<Train> t = this->trains.at(ti);
+		if (t->route == nullptr) { continue; }
+
+		// the trains added before keep their route signals, only the same
+		// direction signals of the changed controllers change
+		if (ti < firstTrainIndex) {
+			for (Train::RouteSignal& routeSignal : t->routeSignals) {
+				NetSignalGroupControllerWithQueuing* controller = routeSignal.signal->controller;
+				if (controller != nullptr && changedControllers.count(controller)) {
+					routeSignal.sameDirectionSignals =
+						this->getSignalsInSameDirection(t, controller->getControllerSignals());
+				}
+			}
+			continue;
+		}
+
+		Vector<Train::RouteSignal> routeSignals;
+		for (int i = 0; i < t->trainPath.size(); i++) {
+			// the first signal at the node that faces the train
+			for (auto& networkSignal : t->trainPathNodes.at(i)->networkSignals) {
+				if (!t->trainPathNodes.exist(std::shared_ptr<NetNode>(networkSignal->previousNode))) {
+					continue;
+				}
+				int currentIndex = t->getPathIndex(networkSignal->currentNode.lock()->id);
+				if (currentIndex <= t->getPathIndex(networkSignal->previousNode.lock()->id)) {
+					continue;
+				}
+				Train::RouteSignal routeSignal;
+				routeSignal.pathIndex = i;
+				routeSignal.distanceIndex = currentIndex;
+				routeSignal.signal = networkSignal;
+				if (networkSignal->controller != nullptr) {
+					routeSignal.sameDirectionSignals =
+						this->getSignalsInSameDirection(t, networkSignal->controller->getControllerSignals());
+				}
+				routeSignals.push_back(routeSignal);
+				break;
+			}
+		}
+		t->routeSignals = routeSignals;
+	}
+}
+
+Train::RouteSignal* Simulator::advanceSignalCursor(std::shared_ptr<Train>& train,
+                                                   int& cursor,
+                                                   double travelledDistance) {
+	// the signals ahead start after the previous node the train tip passed
+	// and after the travelled distance, both only move forward
+	int previousNodeIndex = train->getPathIndex(train->previousNodeID);
+	while (cursor < train->routeSignals.size()) {
+		int pathIndex = train->routeSignals.at(cursor).pathIndex;
+		if (pathIndex >= previousNodeIndex &&
+			train->route->cumLengths.at(pathIndex) > travelledDistance) {
+			return &train->routeSignals.at(cursor);
+		}
+		cursor++;
+	}
+	return nullptr;
+}
+
+void Simulator::requestSignalPass(std::shared_ptr<Train>& train,
+                                  Train::RouteSignal& routeSignal,
+                                  double travelledDistance) {
+	NetSignalGroupControllerWithQueuing* controller = routeSignal.signal->controller;
+	controller->clearTimeoutTrains(this->simulationTime);
+
+	// if the train is within the critical zone of the signal,
+	// add the train to the controller queue to process its request
+	double d = train->route->cumLengths.at(routeSignal.distanceIndex) - travelledDistance;
+	if (d <= routeSignal.signal->proximityToActivate) {
+		controller->addTrain(train, this->simulationTime);
+	}
+
+	// a controller with no waiting trains keeps all its signals on
+	if (!controller->hasWaitingTrains()) { return; }
+
+	// send signal to let the train pass
+	controller->sendPassRequestToControlTo(train, routeSignal.signal, this->simulationTime,
+	                                       routeSignal.sameDirectionSignals);
+
+	// turn off the signals that should be off and keep them to turn them
+	// on again in the next signals run
+	controller->turnOffOtherDirectionSignals(this->redSignals);
 }
 
 
 void Simulator::runSignalsforTrains(QVector<std::shared_ptr<Train>> trainsList) {
-    // turn on temporarly all signals in the network
-    // the signals that should be turned off will be processed based on
-    // the trains locations
-	this->turnOnAllSignals();
+    TraceRecorder::Span span("runSignals", "signals");
+    // turn on the signals turned off in the last run only, the others are
+    // still on. the signals that should be turned off will be processed
+    // based on the trains locations
+	this->turnOnRedSignals();
 
     // loop over all train in the simulator
     for (auto& train : trainsList) {
@@ -1781,97 +2130,37 @@ void Simulator::runSignalsforTrains(QVector<std::shared_ptr<Train>> trainsList)
             continue;
         }
 
-        // try to retreive the next signal for that train
-        // the next from both ends of the train
-		std::shared_ptr<NetSignal> nextSignal = this->getClosestSignal(train);
-        std::shared_ptr<NetSignal> nextBackSignal = this->getClosestSignalToTrainEnd(train);
-        if (nextSignal == nullptr && nextBackSignal == nullptr) {
-            continue; // if no signal is found, the train is not approaching any signal
+        // retreive the next signal for that train from both ends of the
+        // train, the cursors skip the signals the train passed already
+        Train::RouteSignal* nextSignal =
+            this->advanceSignalCursor(train, train->frontSignalCursor, train->travelledDistance);
+        double endTravelledDistance = train->travelledDistance - train->totalLength;
+        Train::RouteSignal* nextBackSignal = nullptr;
+        if (endTravelledDistance > 0) {
+            nextBackSignal = this->advanceSignalCursor(train, train->backSignalCursor, endTravelledDistance);
         }
 
-
-        // define a holder for the signal groups
-        std::shared_ptr<NetSignalGroupControllerWithQueuing> sgfront = nullptr;
-        std::shared_ptr<NetSignalGroupControllerWithQueuing> sgback = nullptr;
+        // if no controlled signal is ahead, the train is not approaching any signal
+        NetSignalGroupControllerWithQueuing* sgfront =
+            (nextSignal != nullptr) ? nextSignal->signal->controller : nullptr;
+        NetSignalGroupControllerWithQueuing* sgback =
+            (nextBackSignal != nullptr) ? nextBackSignal->signal->controller : nullptr;
+        if (sgfront == nullptr && sgback == nullptr) {
+            continue;
+        }
+        TraceRecorder::Span trainSpan("trainSignalGroups", "signals", "trainID", train->id);
 
         // process the train's front side next signal
-        if (nextSignal != nullptr) {
-            // if a signal is found, calculate the distance to the signal
-            double dFront = this->network->getDistanceToSpecificNodeByTravelledDistance(train,
-                                                                                        train->travelledDistance,
-                                                                                        nextSignal->currentNode.lock()->id);
-
-            // get the signal group controller at the current node
-            if (this->signalsGroups.is_key(std::shared_ptr<NetNode>(nextSignal->currentNode))) {
-                sgfront = this->signalsGroups.at(std::shared_ptr<NetNode>(nextSignal->currentNode));
-                sgfront->clearTimeoutTrains(this->simulationTime);
-            }
-
-            // if no group controller was found, skip it
-            if (sgfront != nullptr) {
-                // if the train is within the critical zone of the signal,
-                // add the train to the controller queue to process its request
-                if (dFront <= nextSignal->proximityToActivate) {
-                    sgfront->addTrain(train, this->simulationTime);
-                }
-
-                // get the signals in the path of the train (signals of this group controller only)
-                Vector<std::shared_ptr<NetSignal>> sameDirSignals =
-                    this->getSignalsInSameDirection(train, sgfront->getControllerSignals());
-
-                // send signal to let the train pass
-                sgfront->sendPassRequestToControlTo(train, nextSignal, this->simulationTime, sameDirSignals);
-
-                // get feedback from the controller
-                Vector<std::shared_ptr<NetSignal>> otherDirSignals = sgfront->getFeedback().second;
-
-                // turn off the signals that should be off
-                sgfront->turnOffSignals(otherDirSignals);
-            }
-
+        if (sgfront != nullptr) {
+            this->requestSignalPass(train, *nextSignal, train->travelledDistance);
         }
 
-        // process the train's end side next signal
-        if (nextBackSignal != nullptr) {
-            double endTravelledDistance = train->travelledDistance - train->totalLength;
-            if (endTravelledDistance < 0) {
-                continue;
-            }
-            // if a signal is found, calculate the distance to the signal
-            double dBack = this->network->getDistanceToSpecificNodeByTravelledDistance(train,
-                                                                                       endTravelledDistance,
-                                                                                       nextBackSignal->currentNode.lock()->id);
-
-            // get the signal group controller at the current node
-            if (this->signalsGroups.is_key(std::shared_ptr<NetNode>(nextBackSignal->currentNode))) {
-                sgback = this->signalsGroups.at(std::shared_ptr<NetNode>(nextBackSignal->currentNode));
-                sgback->clearTimeoutTrains(this->simulationTime);
-            }
-            // skip if the same signal group
-            // the train's call was already processed once
-            if (sgback == sgfront) {
-                continue;
-            }
-            // if the train is within the critical zone of the signal,
-            // add the train to the controller queue to process its request
-            if (dBack <= nextBackSignal->proximityToActivate) {
-                sgback->addTrain(train, this->simulationTime);
-            }
-
-            // get the signals in the path of the train (signals of this group controller only)
-            Vector<std::shared_ptr<NetSignal>> sameDirSignals =
-                this->getSignalsInSameDirection(train, sgback->getControllerSignals());
-
-            // send signal to let the train pass
-            sgback->sendPassRequestToControlTo(train, nextBackSignal, this->simulationTime, sameDirSignals);
-
-            // get feedback from the controller
-            Vector<std::shared_ptr<NetSignal>> otherDirSignals = sgback->getFeedback().second;
-
-            // turn off the signals that should be off
-            sgback->turnOffSignals(otherDirSignals);
+        // process the train's end side next signal,
+        // skip it if it is the same signal group since
+        // the train's call was already processed once
+        if (sgback != nullptr && sgback != sgfront) {
+            this->requestSignalPass(train, *nextBackSignal, endTravelledDistance);
         }
-
 	}
 }
 
@@ -1882,8 +2171,8 @@ Vector<std::shared_ptr<NetSignal>> Simulator::getSignalsInSameDirection(std::sha
 	for (auto& netSignal : signalsGroupList) {
 		if ((train->trainPath.exist(netSignal->currentNode.lock()->id)) &&
 			(train->trainPath.exist(netSignal->previousNode.lock()->id)) ) {
-			if ((train->trainPath.index(netSignal->currentNode.lock()->id)) >
-				(train->trainPath.index(netSignal->previousNode.lock()->id))) {
+			if ((train->getPathIndex(netSignal->currentNode.lock()->id)) >
+				(train->getPathIndex(netSignal->previousNode.lock()->id))) {
 				signalsList.push_back(netSignal);
 			}
 		}
@@ -1927,6 +2216,7 @@ void Simulator::restartSimulation()
 {
     simulationTime = 0.0;
     progress = -1;
+    this->profiler.reset();
 
     for (auto train : trains) {
         train->resetTrain();
@@ -1941,7 +2231,7 @@ void Simulator::restartSimulation()
 
 
 std::shared_ptr<NetSignal> Simulator::getClosestSignal(std::shared_ptr<Train>& train) {
-	int indx = train->trainPath.index(this->network->getPreviousNodeByDistance(train, 
+	int indx = train->getPathIndex(this->network->getPreviousNodeByDistance(train, 
 		train->travelledDistance, train->previousNodeID)->id) + 1;
 
 	for (int i = indx; i < train->trainPath.size(); i++) {
@@ -1950,8 +2240,8 @@ std::shared_ptr<NetSignal> Simulator::getClosestSignal(std::shared_ptr<Train>& t
 			for (int j = 0; j < networkSignals.size(); j++) {
 				if (train->trainPathNodes.exist(std::shared_ptr<NetNode>(networkSignals.at(j)->previousNode))) {
 
-					if (train->trainPath.index(networkSignals.at(j)->currentNode.lock()->id) >
-						(train->trainPath.index(networkSignals.at(j)->previousNode.lock()->id))) {
+					if (train->getPathIndex(networkSignals.at(j)->currentNode.lock()->id) >
+						(train->getPathIndex(networkSignals.at(j)->previousNode.lock()->id))) {
 						return networkSignals.at(j);
 					}
 				}
@@ -1969,7 +2259,7 @@ std::shared_ptr<NetSignal> Simulator::getClosestSignalToTrainEnd(std::shared_ptr
         return nullptr;
     }
 
-    int indx = train->trainPath.index(
+    int indx = train->getPathIndex(
                    this->network->getPreviousNodeByDistance(train,
                                                             backD,
                                                             train->previousNodeID)->id) + 1;
@@ -1981,8 +2271,8 @@ std::shared_ptr<NetSignal> Simulator::getClosestSignalToTrainEnd(std::shared_ptr
             for (int j = 0; j < networkSignals.size(); j++) {
                 if (train->trainPathNodes.exist(std::shared_ptr<NetNode>(networkSignals.at(j)->previousNode))) {
 
-                    if (train->trainPath.index(networkSignals.at(j)->currentNode.lock()->id) >
-                        (train->trainPath.index(networkSignals.at(j)->previousNode.lock()->id))) {
+                    if (train->getPathIndex(networkSignals.at(j)->currentNode.lock()->id) >
+                        (train->getPathIndex(networkSignals.at(j)->previousNode.lock()->id))) {
                         return networkSignals.at(j);
                     }
                 }
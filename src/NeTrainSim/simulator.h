@@ -10,16 +10,21 @@
 #include <QObject>
 #include "qmutex.h"
 #include "qwaitcondition.h"
+#include <QThreadPool>
 #include "traindefinition/train.h"
 #include "network/network.h"
 #include "network/netsignalgroupcontroller.h"
 #include "network/netsignalgroupcontrollerwithqueuing.h"
+#include "network/netsignalgroupsbuilder.h"
 #include "traindefinition/trainscommon.h"
 #include "util/vector.h"
+#include "util/trajectorywriter.h"
+#include "util/stepprofiler.h"
 #include <string>
 #include <iostream>
 #include <filesystem>
 #include <memory>
+#include <exception>
 #include <QDir>
 
 
@@ -54,8 +59,14 @@ private:
 	inline static const std::string DefaultInstantaneousTrajectoryFilename = "trainTrajectory_";
 	/** (Immutable) the default summary filename */
 	inline static const std::string DefaultSummaryFilename =  "trainSummary_";
+	/** (Immutable) the default step profile filename */
+	inline static const std::string DefaultStepProfileFilename =  "stepProfile_";
 	/** (Immutable) true to optimize each train trajectory */
 	static constexpr bool DefaultOptimizeSingleTrains = false;
+	/** (Immutable) the default number of threads stepping the trains */
+	static constexpr int DefaultThreadsCount = 1;
+	/** (Immutable) the farthest distance in meters a train looks for a leading train */
+	static constexpr double DefaultLeaderLookAheadDistance = 10000.0;
 
 private:
 	/** The trains */
@@ -80,13 +91,29 @@ private:
     double progress = -1;
 	/** True to export trajectory */
 	bool exportTrajectory;
-	/** The trajectory file */
-	std::ofstream trajectoryFile;
+	/** Writes the trajectory file in the background */
+	TrajectoryWriter trajectoryWriter;
 	/** The summary file */
 	std::ofstream summaryFile;
+	/** The block compressed summary file */
+	CompressedOFStream compressedSummaryFile;
+	/** True to write the CSV trajectory and the summary block compressed */
+	bool compressOutput = false;
+	/** The name of the run in the results database */
+	QString resultsRunName;
+	/** Times the phases of the time steps when enabled */
+	StepProfiler profiler;
+	/** Filename of the step profile file */
+	std::string stepProfileFilename;
 	//Vector<Vector<Vector < std::shared_ptr<NetNode>>>> conflictTrainsIntersections;
-	/** Groups the signals belongs to */
-    Map<std::shared_ptr<NetNode>, std::shared_ptr<NetSignalGroupControllerWithQueuing>> signalsGroups;
+	/** The signals group controller of each node indexed by the simulator
+	 * node ID, nullptr if the node is not controlled. The signals point to
+	 * the controllers held here. */
+    Vector<std::shared_ptr<NetSignalGroupControllerWithQueuing>> signalsGroups;
+	/** Groups the signal nodes as the trains are added */
+	NetSignalGroupsBuilder signalGroupsBuilder;
+	/** The signals the controllers turned off in the last signals run */
+	Vector<std::shared_ptr<NetSignal>> redSignals;
 	/** export individualized trains summary in the summary file*/
 	bool exportIndividualizedTrainsSummary = false;
 
@@ -95,6 +122,44 @@ private:
     bool mSimulatorInitialized = false;
 
     double progressPercentage;
+
+	/** The number of threads used to compute the trains steps */
+	int threadsCount = DefaultThreadsCount;
+	/** The pool of threads computing the trains steps */
+	QThreadPool stepThreadPool;
+	/** The number of train pairs checked for collision after the broad phase */
+	unsigned long long narrowPhaseCollisionChecks = 0;
+	/** The number of simulation steps run */
+	unsigned long long stepsCount = 0;
+	/** The number of steps the trains made on the network */
+	unsigned long long trainStepsCount = 0;
+
+	/**
+	 * @brief The outcome of computing one train step that has to be
+	 *        committed serially and in the trains order.
+	 */
+	struct TrainStepResult {
+		/** The train this result belongs to */
+		std::shared_ptr<Train> train;
+		/** True if the train step is computed in the parallel phase */
+		bool scheduled = false;
+		/** True if the train is still on the network after the step */
+		bool onNetwork = false;
+		/** The new start and end points of the train */
+		Vector<std::pair<double, double>> startEndPoints;
+		/** True if the step has a trajectory record to export */
+		bool hasTrajectoryRecord = false;
+		/** The trajectory record of the step */
+		TrajectoryWriter::Record trajectoryRecord;
+		/** True if the train arrived to a terminal in this step */
+		bool reachedTerminal = false;
+		/** The terminal node the train arrived to */
+		std::shared_ptr<NetNode> terminalNode;
+		/** The catenary energy the train exchanged with the links */
+		Vector<TrainComponent::CatenaryEnergy> catenaryEnergy;
+		/** The exception thrown while computing the step, if any */
+		std::exception_ptr error;
+	};
 public:
 
     std::stringstream summaryTextData;
@@ -187,8 +252,12 @@ public:
 	 *
 	 * @param exportInstaTraject
 	 * @param newInstaTrajectFilename
+	 * @param exportConfig	the exported columns, the decimation interval and
+	 * 						the on-change mode of the trajectory.
+	 * @throws std::runtime_error if a column name is not a trajectory column.
 	 */
-	void setExportInstantaneousTrajectory(bool exportInstaTraject, string newInstaTrajectFilename = DefaultInstantaneousTrajectoryEmptyFilename);
+	void setExportInstantaneousTrajectory(bool exportInstaTraject, string newInstaTrajectFilename = DefaultInstantaneousTrajectoryEmptyFilename,
+										  const TrajectoryWriter::ExportConfig &exportConfig = TrajectoryWriter::ExportConfig());
 
 
 	/**
@@ -242,6 +311,22 @@ public:
 	 */
 	void openTrajectoryFile();
 
+	/**
+	 * @brief Gets the path of the trajectory file. The extension of the
+	 *        trajectory filename follows the trajectory format.
+	 *
+	 * @return the trajectory file path in the output folder.
+	 */
+	QString getTrajectoryFilePath() const;
+
+	/**
+	 * @brief Gets the path of the summary file. The compressed extension is
+	 *        appended when the output is compressed.
+	 *
+	 * @return the summary file path in the output folder.
+	 */
+	QString getSummaryFilePath() const;
+
 	/**
 	 * Opens summary file
 	 *
@@ -261,18 +346,106 @@ public:
 	bool checkAllTrainsReachedDestination();
 
 	/**
-	 * Executes the 'threaded one time step' operation
+	 * @brief Sets the number of threads used to compute the trains steps.
 	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
+	 * @details Each train computes its next state from a snapshot of the
+	 *          previous step, then the link occupancy, the output and the
+	 *          signals are committed serially in the trains order. The
+	 *          results are identical regardless of the number of threads.
+	 *
+	 * @param newThreadsCount   the number of threads. Values less than 1
+	 *                          use all the available cores.
+	 */
+	void setThreadsCount(int newThreadsCount);
+
+	/**
+	 * @brief Gets the number of threads used to compute the trains steps.
+	 *
+	 * @return the number of threads.
+	 */
+	int getThreadsCount() const;
+
+	/**
+	 * @brief Sets the number of trajectory records queued for the
+	 *        background writer before the simulation waits for it.
+	 *
+	 * @param newBufferSize the number of records. Values less than 1 use
+	 *                      the default buffer size.
+	 */
+	void setTrajectoryBufferSize(int newBufferSize);
+
+	/**
+	 * @brief Gets the number of trajectory records queued for the
+	 *        background writer.
+	 *
+	 * @return the number of records.
+	 */
+	int getTrajectoryBufferSize() const;
+
+	/**
+	 * @brief Sets the format of the trajectory file.
+	 *
+	 * @details The CSV format has one row per train step. The binary format
+	 *          (.ntst) stores the columns of each train in chunks and is
+	 *          read with the TrajectoryReader. The SQLite format adds the
+	 *          trajectory and the trains summary of the run to a results
+	 *          database shared by many runs.
+	 *
+	 * @param newFormat the trajectory file format.
+	 */
+	void setTrajectoryFormat(TrajectoryWriter::Format newFormat);
+
+	/**
+	 * @brief Gets the format of the trajectory file.
+	 *
+	 * @return the trajectory file format.
+	 */
+	TrajectoryWriter::Format getTrajectoryFormat() const;
+
+	/**
+	 * @brief Sets if the CSV trajectory and the summary files are written
+	 *        block compressed (.ntz appended to their names). The CSVManager
+	 *        reads the compressed files transparently.
+	 *
+	 * @param newCompressOutput true to compress the output files.
+	 */
+	void setCompressOutput(bool newCompressOutput);
+
+	/**
+	 * @brief Checks if the output files are written block compressed.
+	 *
+	 * @return true if the output files are compressed.
+	 */
+	bool getCompressOutput() const;
+
+	/**
+	 * @brief Sets if the phases of every time step are timed. The
+	 *        durations per phase and per train are written as JSON to the
+	 *        output folder when the simulation finishes.
 	 *
-	 * @param [in,out]	obj  	If non-null, the object.
-	 * @param [in,out]	train	If non-null, the train.
+	 * @param profileSteps true to profile the time steps.
+	 * @param newProfileFilename the step profile filename, a time stamped
+	 *                           name is used if it is empty.
 	 */
-	void runThreadedOneTimeStep(Simulator* obj, Train* train);
+	void setProfileSteps(bool profileSteps, std::string newProfileFilename = "");
 
 	/**
-	 * Determines if we can check trains collision
+	 * @brief Checks if the phases of the time steps are timed.
+	 *
+	 * @return true if the time steps are profiled.
+	 */
+	bool getProfileSteps() const;
+
+	/**
+	 * @brief Gets the step profiler.
+	 *
+	 * @return the step profiler.
+	 */
+	const StepProfiler& getStepProfiler() const;
+
+	/**
+	 * Determines if we can check trains collision. Only the trains that share
+	 * a link are checked for intersection.
 	 *
 	 * @author	Ahmed Aredah
 	 * @date	2/28/2023
@@ -281,6 +454,28 @@ public:
 	 */
     bool checkTrainsCollision(QVector<std::shared_ptr<Train> > trainsList);
 
+    /**
+     * @brief Gets the number of train pairs that passed the collision
+     *        broad phase and were checked for intersection since the
+     *        simulator was created.
+     * @return the number of narrow phase checks.
+     */
+    unsigned long long getNarrowPhaseCollisionChecksCount() const;
+
+    /**
+     * @brief Gets the number of simulation steps run since the simulator
+     *        was created.
+     * @return the number of steps.
+     */
+    unsigned long long getStepsCount() const;
+
+    /**
+     * @brief Gets the number of steps the loaded trains made since the
+     *        simulator was created, one per train per simulation step.
+     * @return the number of train steps.
+     */
+    unsigned long long getTrainStepsCount() const;
+
 	/**
 	 * Play train one time step
 	 *
@@ -340,16 +535,22 @@ public:
 
 	/**
 	 * Gets the ahead train and the gap between the current train and the ahead train.
+	 * The links of the remaining train path are scanned through their current trains
+	 * until the look ahead distance is exceeded. Only trains taking the links in the
+	 * same direction are considered leading trains.
 	 *
 	 * @author	Ahmed Aredah
 	 * @date	2/28/2023
 	 *
-	 * @param 	train	The current train.
+	 * @param 	train			 	The current train.
+	 * @param 	lookAheadDistance	The farthest along-track distance to look for a train.
 	 *
-	 * @returns	a pointer to the ahead train and the gap between the current train and
-	 *          the ahead train.
+	 * @returns	a pointer to the ahead train and the along-track gap between the head
+	 *          of the current train and the rear end of the ahead train, a nullptr
+	 *          if there is no train within the look ahead distance.
 	 */
-	std::pair<std::shared_ptr<Train>, double> getAheadTrainAndGap(std::shared_ptr <Train> train);
+	std::pair<std::shared_ptr<Train>, double> getAheadTrainAndGap(std::shared_ptr <Train> train,
+																  double lookAheadDistance);
 
 	/**
 	 * Gets start end points
@@ -497,138 +698,134 @@ public:
 private:
 
 	/**
-	 * Turn on all signals
-	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
+	 * @brief Turns on the signals the controllers turned off in the last
+	 * signals run, all the other signals are still on.
 	 */
-	void turnOnAllSignals();
+	void turnOnRedSignals();
 
 	/**
-	 * Check links are free
-	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
-	 *
-	 * @param [in,out]	links	The links.
-	 *
-	 * @returns	True if it succeeds, false if it fails.
+	 * @brief Sets the signals along the path of the trains added since the
+	 * signals groups were last defined. The trains added before only get
+	 * the same direction signals of the changed controllers. The signals
+	 * cursors of the trains are kept since the route signals only depend
+	 * on the train path.
+	 * @param firstTrainIndex       the index of the first added train.
+	 * @param changedControllers    the controllers created or extended.
 	 */
-	bool checkLinksAreFree(Vector<std::shared_ptr<NetLink>> &links);
+	void setTrainsRouteSignals(int firstTrainIndex,
+	                           const std::set<NetSignalGroupControllerWithQueuing*>& changedControllers);
 
 	/**
-	 * Check train on links
-	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
-	 *
-	 * @param [in,out]	train	The train.
-	 * @param [in,out]	links	The links.
-	 *
-	 * @returns	True if it succeeds, false if it fails.
+	 * @brief Moves a signal cursor of a train forward to the first route
+	 * signal after the previous node the train tip passed and after a
+	 * travelled distance.
+	 * @param train             the train.
+	 * @param cursor            the front or back signal cursor of the train.
+	 * @param travelledDistance the travelled distance of the train tip or end.
+	 * @return the route signal at the cursor, nullptr if no signal is ahead.
 	 */
-	bool checkTrainOnLinks(std::shared_ptr<Train>& train, Vector<std::shared_ptr<NetLink>>& links);
+	Train::RouteSignal* advanceSignalCursor(std::shared_ptr<Train>& train,
+	                                        int& cursor,
+	                                        double travelledDistance);
 
 	/**
-	 * Gets accurate train current link
-	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
-	 *
-	 * @param [in,out]	train	The train.
-	 *
-	 * @returns	The accurate train current link.
+	 * @brief Requests the controller of a route signal to let the train
+	 * pass and turns off the signals the controller does not open.
+	 * The train joins the controller queue once it is within the
+	 * signal activation proximity.
+	 * @param train             the train.
+	 * @param routeSignal       the next route signal of the train tip or end.
+	 * @param travelledDistance the travelled distance of the train tip or end.
 	 */
-	std::set<std::shared_ptr<NetLink>> getAccurateTrainCurrentLink(std::shared_ptr<Train>& train);
+	void requestSignalPass(std::shared_ptr<Train>& train,
+	                       Train::RouteSignal& routeSignal,
+	                       double travelledDistance);
 
 	/**
-	 * Gets signals in same direction
+	 * @brief Loads the train if its start time has passed and its
+	 *        starting node is free.
 	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
-	 *
-	 * @param [in,out]	train				The train.
-	 * @param 		  	SignalsGroupList	List of signals groups.
-	 *
-	 * @returns	The signals in same direction.
+	 * @param 	train	The train.
 	 */
-	Vector<std::shared_ptr<NetSignal>> getSignalsInSameDirection(std::shared_ptr<Train>& train,
-		Vector<std::shared_ptr<NetSignal>> SignalsGroupList);
+	void loadTrainIfReady(std::shared_ptr<Train> train);
 
 	/**
-	 * Gets nodes intersections for signals
-	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
-	 *
-	 * @param [in,out]	minSafeDistance	The minimum safe distance.
+	 * @brief Computes the next state of a loaded train. It only changes the
+	 *        train itself, everything shared with the other trains is kept
+	 *        in the result until it is committed.
 	 *
-	 * @returns	The nodes intersections for signals.
+	 * @param 		  	train 	The train.
+	 * @param [in,out]	result	The step result to fill.
 	 */
-	Vector<std::set<std::shared_ptr<NetNode>>> getNodesIntersectionsForSignals(double& minSafeDistance);
+	void computeTrainOneTimeStep(std::shared_ptr<Train> train, TrainStepResult &result);
 
 	/**
-	 * Gets trains intersections
-	 *
-	 * @author	Ahmed Aredah
-	 * @date	2/28/2023
+	 * @brief Commits a computed train step to the link occupancy, the
+	 *        trajectory file and the listeners.
 	 *
-	 * @param 	train1	The first train.
-	 * @param 	train2	The second train.
-	 *
-	 * @returns	The trains intersections.
+	 * @param [in,out]	result	The computed step result.
+	 */
+	void commitTrainOneTimeStep(TrainStepResult &result);
+
+	/**
+	 * @brief Shifts the simulation time to the next train start time if no
+	 *        train is currently on the network.
 	 */
-	Vector<std::shared_ptr<NetNode>> getTrainsIntersections(std::shared_ptr<Train> train1, std::shared_ptr<Train> train2);
+	void skipTimeIfNoTrainIsOnNetwork();
 
 	/**
-	 * Gets conflict trains intersections
+	 * Check links are free
 	 *
 	 * @author	Ahmed Aredah
 	 * @date	2/28/2023
 	 *
-	 * @returns	The conflict trains intersections.
+	 * @param [in,out]	links	The links.
+	 *
+	 * @returns	True if it succeeds, false if it fails.
 	 */
-	Vector<Vector<Vector < std::shared_ptr<NetNode>>>> getConflictTrainsIntersections();
+	bool checkLinksAreFree(Vector<std::shared_ptr<NetLink>> &links);
 
 	/**
-	 * Gets node groups for signals
+	 * Check train on links
 	 *
 	 * @author	Ahmed Aredah
 	 * @date	2/28/2023
 	 *
-	 * @param 		  	ConflictTrainsIntersections	The conflict trains intersections.
-	 * @param [in,out]	minSafeDistance			   	The minimum safe distance.
+	 * @param [in,out]	train	The train.
+	 * @param [in,out]	links	The links.
 	 *
-	 * @returns	The node groups for signals.
+	 * @returns	True if it succeeds, false if it fails.
 	 */
-	Vector<Vector< Map<int, std::set<std::shared_ptr<NetNode>>>>> getNodeGroupsForSignals(Vector<Vector<Vector < std::shared_ptr<NetNode>>>> ConflictTrainsIntersections, double& minSafeDistance);
+	bool checkTrainOnLinks(std::shared_ptr<Train>& train, Vector<std::shared_ptr<NetLink>>& links);
 
 	/**
-	 * Union nodes intersections for signals
+	 * Gets accurate train current link
 	 *
 	 * @author	Ahmed Aredah
 	 * @date	2/28/2023
 	 *
-	 * @param 	nodesGroups	Groups the nodes belongs to.
+	 * @param [in,out]	train	The train.
 	 *
-	 * @returns	A Vector&lt;std::set&lt;std::shared_ptr&lt;NetNode&gt;&gt;&gt;
+	 * @returns	The accurate train current link.
 	 */
-	Vector<std::set<std::shared_ptr<NetNode>>> unionNodesIntersectionsForSignals(Vector<Vector< Map<int, std::set<std::shared_ptr<NetNode>>>>> nodesGroups);
+	std::set<std::shared_ptr<NetLink>> getAccurateTrainCurrentLink(std::shared_ptr<Train>& train);
 
 	/**
-	 * Removes the redundancy described by unified
+	 * Gets signals in same direction
 	 *
 	 * @author	Ahmed Aredah
 	 * @date	2/28/2023
 	 *
-	 * @param 	unified	The unified.
+	 * @param [in,out]	train				The train.
+	 * @param 		  	SignalsGroupList	List of signals groups.
 	 *
-	 * @returns	A Vector&lt;std::set&lt;std::shared_ptr&lt;NetNode&gt;&gt;&gt;
+	 * @returns	The signals in same direction.
 	 */
-	Vector<std::set<std::shared_ptr<NetNode>>> removeRedundancy(Vector<std::set<std::shared_ptr<NetNode>>> unified);
+	Vector<std::shared_ptr<NetSignal>> getSignalsInSameDirection(std::shared_ptr<Train>& train,
+		Vector<std::shared_ptr<NetSignal>> SignalsGroupList);
 
 	/**
-	 * Calculates the signals proximities
+	 * Calculates the signals proximities from all the trains passing them.
 	 *
 	 * @author	Ahmed Aredah
 	 * @date	2/28/2023
@@ -709,6 +906,18 @@ public slots:
 
     void exportSummaryToTXTFile();
 
+    /**
+     * @brief Adds the summary of every train to the results database when
+     *        the trajectory is exported in the SQLite format.
+     */
+    void exportSummaryToDatabase();
+
+    /**
+     * @brief Writes the step profile to the output folder when the time
+     *        steps are profiled.
+     */
+    void exportStepProfile();
+
     void finalizeSimulation();
 
     void runOneTimeStep();
@@ -1,5 +1,6 @@
 #include "simulatorapi.h"
 #include "./traindefinition/trainslist.h"
+#include "./network/networksnapshot.h"
 #include <QDebug> // For debugging
 #include <QEventLoop>
 #include <QMetaObject> // Required for QMetaObject::invokeMethod and Q_ARG
@@ -276,25 +277,41 @@ void SimulatorAPI::createNewSimulationEnvironmentFromFiles(
                            + networkName + " exists!");
         return;
     }
-    auto nodeRecords = ReadWriteNetwork::readNodesFile(
-        nodesFile.toStdString());
+    // the binary snapshot replaces parsing the network
+    // files when it was built from the same files
+    std::string snapshotFile =
+        NetworkSnapshot::getSnapshotFilename(
+            linksFile.toStdString());
+    bool isSnapshotUpToDate =
+        NetworkSnapshot::isSnapshotUpToDate(
+            snapshotFile, nodesFile.toStdString(),
+            linksFile.toStdString());
+
+    QVector<QMap<QString, QString>> nodeRecordsf;
+    QVector<QMap<QString, QString>> linkRecordsf;
+    if (!isSnapshotUpToDate)
+    {
+        auto nodeRecords = ReadWriteNetwork::readNodesFile(
+            nodesFile.toStdString());
+
+        auto linkRecords = ReadWriteNetwork::readLinksFile(
+            linksFile.toStdString());
 
-    auto linkRecords = ReadWriteNetwork::readLinksFile(
-        linksFile.toStdString());
+        nodeRecordsf =
+            Utils::convertToQVectorString(nodeRecords);
+        linkRecordsf =
+            Utils::convertToQVectorString(linkRecords);
+    }
 
     auto trainsRecords = TrainsList::readTrainsFile(
         trainsFile.toStdString());
 
-    auto nodeRecordsf =
-        Utils::convertToQVectorString(nodeRecords);
-    auto linkRecordsf =
-        Utils::convertToQVectorString(linkRecords);
-
     auto trainsRecordsf =
         Utils::convertToQVector(trainsRecords);
 
     setupSimulator(networkName, nodeRecordsf, linkRecordsf,
-                   trainsRecordsf, timeStep, mode);
+                   trainsRecordsf, timeStep, mode,
+                   nodesFile, linksFile);
 
     emit simulationCreated(networkName);
 }
@@ -328,7 +345,8 @@ void SimulatorAPI::setupSimulator(
     QVector<QMap<QString, QString>>  &nodeRecords,
     QVector<QMap<QString, QString>>  &linkRecords,
     QVector<QMap<QString, std::any>> &trainList,
-    double timeStep, Mode mode)
+    double timeStep, Mode mode, QString nodesFile,
+    QString linksFile)
 {
     // Capture networkName by value to ensure stability
     QString localNetworkName = networkName;
@@ -386,7 +404,8 @@ void SimulatorAPI::setupSimulator(
             apiDataMap.get(localNetworkName);
         simulatorWorker->setupSimulator(
             workerData, localNetworkName, nodeRecords,
-            linkRecords, trainList, timeStep);
+            linkRecords, trainList, timeStep,
+            nodesFile, linksFile);
     });
 
     loop.exec();
@@ -540,6 +540,13 @@ protected:
      * @param timeStep Time step size for the simulation,
      * specified in seconds.
      * @param mode Operation mode, either Async or Sync.
+     * @param nodesFile The nodes file of the network.
+     * @param linksFile The links file of the network. With
+     * the nodes file, the binary network snapshot is used:
+     * if the node records are empty, the network is read
+     * from the snapshot, or from the files if the snapshot
+     * cannot be read; otherwise the snapshot is refreshed
+     * from the records. Empty to not use a snapshot.
      * @details This function sets up the simulator
      * environment by loading the network nodes, links, and
      * trains, and configuring them for simulation according
@@ -550,7 +557,9 @@ protected:
         QVector<QMap<QString, QString>>  &nodeRecords,
         QVector<QMap<QString, QString>>  &linkRecords,
         QVector<QMap<QString, std::any>> &trainList,
-        double timeStep, Mode mode);
+        double timeStep, Mode mode,
+        QString nodesFile = QString(),
+        QString linksFile = QString());
 
     /**
      * @brief Emit the specified signal if conditions are
@@ -1,6 +1,7 @@
 #include "simulatorworker.h"
 #include "simulatorapi.h"
 #include "traindefinition/trainslist.h"
+#include "network/networksnapshot.h"
 #include "util/vector.h"
 #include "util/map.h"
 #include <qthread.h>
@@ -15,7 +16,9 @@ void SimulatorWorker::setupSimulator(
     const QVector<QMap<QString, QString> > &nodeRecords,
     const QVector<QMap<QString, QString> > &linkRecords,
     const QVector<QMap<QString, std::any> > &trainsList,
-    double timeStep)
+    double timeStep,
+    const QString &nodesFile,
+    const QString &linksFile)
 {
     qDebug() << "Creating simulator inside thread:"
              << QThread::currentThread();
@@ -44,8 +47,34 @@ void SimulatorWorker::setupSimulator(
 
         qInfo() << "Reading Network: " << qUtf8Printable(networkName)
                 << "!                    \r";
-        auto nodes = ReadWriteNetwork::generateNodes(snodeRecords);
-        auto links = ReadWriteNetwork::generateLinks(nodes, slinkRecords);
+        Vector<std::shared_ptr<NetNode>> nodes;
+        Vector<std::shared_ptr<NetLink>> links;
+        // without records, the network is read from its binary snapshot.
+        // if the snapshot cannot be read, the network files are parsed
+        // and the snapshot is rewritten
+        std::string snapshotFile;
+        if (!nodesFile.isEmpty() && !linksFile.isEmpty()) {
+            snapshotFile = NetworkSnapshot::getSnapshotFilename(
+                linksFile.toStdString());
+        }
+        bool isSnapshotRead = false;
+        if (nodeRecords.isEmpty() && !snapshotFile.empty()) {
+            isSnapshotRead = NetworkSnapshot::readSnapshot(
+                snapshotFile, nodes, links);
+            if (!isSnapshotRead) {
+                qWarning() << "Could not read the network snapshot: "
+                           << QString::fromStdString(snapshotFile)
+                           << ", reading the network files instead";
+                snodeRecords = ReadWriteNetwork::readNodesFile(
+                    nodesFile.toStdString());
+                slinkRecords = ReadWriteNetwork::readLinksFile(
+                    linksFile.toStdString());
+            }
+        }
+        if (!isSnapshotRead) {
+            nodes = ReadWriteNetwork::generateNodes(snodeRecords);
+            links = ReadWriteNetwork::generateLinks(nodes, slinkRecords);
+        }
         auto trains =
             TrainsList::generateTrains(trainsRecords, true);
         auto trainsq = Utils::convertToQVector(trains);
@@ -56,6 +85,17 @@ void SimulatorWorker::setupSimulator(
 
         apiData.network = new Network(nodes, links, networkName.toStdString());
 
+        // refresh the snapshot with the built network, so the next run
+        // skips parsing the network files
+        if (!isSnapshotRead && !snapshotFile.empty()) {
+            if (!NetworkSnapshot::writeSnapshot(
+                    snapshotFile, nodesFile.toStdString(),
+                    linksFile.toStdString(), nodes, links)) {
+                qWarning() << "Could not write the network snapshot: "
+                           << QString::fromStdString(snapshotFile);
+            }
+        }
+
 
         // Store the train list in APIData for future reference
         apiData.trains.clear();
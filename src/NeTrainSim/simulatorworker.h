@@ -18,7 +18,9 @@ public:
                         const QVector<QMap<QString, QString> > &nodeRecords,
                         const QVector<QMap<QString, QString> > &linkRecords,
                         const QVector<QMap<QString, std::any> > &trainsList,
-                        double timeStep);
+                        double timeStep,
+                        const QString &nodesFile = QString(),
+                        const QString &linksFile = QString());
 signals:
     void simulatorLoaded(APIData& apiData);
     void errorOccured(QString error);
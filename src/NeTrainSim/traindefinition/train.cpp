@@ -56,14 +56,6 @@ Train::Train(
     this->resetTrain();
 
     this->WeightCentroids     = this->getTrainCentroids();
-    int sizeOfPath            = this->trainPath.size();
-    this->betweenNodesLengths = Vector<Vector<double>>(
-        sizeOfPath, Vector<double>(sizeOfPath));
-    this->LowerSpeedNodeIDs =
-        Vector<Vector<Map<int, double>>>(
-            sizeOfPath,
-            Vector<Map<int, double>>(sizeOfPath,
-                                     Map<int, double>()));
     Train::NumberOfTrainsInSimulator++;
     this->T_s = this->operatorReactionTime
                 + (this->totalLength / this->brakePipePropagationSpeed);
@@ -133,12 +125,6 @@ void Train::setTrainSimulatorID(int newID)
 void Train::setTrainPath(Vector<int> path)
 {
     this->trainPath = path;
-    int sizeOfPath  = this->trainPath.size();
-    this->LowerSpeedNodeIDs =
-        Vector<Vector<Map<int, double>>>(
-            sizeOfPath,
-            Vector<Map<int, double>>(sizeOfPath,
-                                     Map<int, double>()));
 }
 
 // ##################################################################
@@ -2167,9 +2153,81 @@ void Train::resetTrainLookAhead()
     this->lookAheadStepCounter = mem_lookAheadStepCounter;
 }
 
+Vector<TrainComponent::CatenaryEnergy> Train::takeCatenaryEnergy()
+{
+    Vector<TrainComponent::CatenaryEnergy> energy;
+    for (std::shared_ptr<TrainComponent> &vehicle : this->trainVehicles)
+    {
+        energy.insert(energy.end(),
+                      vehicle->pendingCatenaryEnergy.begin(),
+                      vehicle->pendingCatenaryEnergy.end());
+        vehicle->pendingCatenaryEnergy.clear();
+    }
+    return energy;
+}
+
+void Train::captureStepSnapshot(bool pending)
+{
+    this->stepSnapshot.pending            = pending;
+    this->stepSnapshot.loaded             = this->loaded;
+    this->stepSnapshot.reachedDestination =
+        this->reachedDestination;
+    this->stepSnapshot.travelledDistance =
+        this->travelledDistance;
+    this->stepSnapshot.currentSpeed = this->currentSpeed;
+}
+
+Train::StepSnapshot Train::getObservedState() const
+{
+    if (this->stepSnapshot.pending)
+    {
+        return this->stepSnapshot;
+    }
+    StepSnapshot state;
+    state.loaded             = this->loaded;
+    state.reachedDestination = this->reachedDestination;
+    state.travelledDistance  = this->travelledDistance;
+    state.currentSpeed       = this->currentSpeed;
+    return state;
+}
+
+void Train::setRoute(std::shared_ptr<const NetRoute> newRoute)
+{
+    this->route             = newRoute;
+    this->routeCursor       = 0;
+    this->frontSignalCursor = 0;
+    this->backSignalCursor  = 0;
+    this->routeSignals.clear();
+}
+
+int Train::getPathIndex(int nodeID) const
+{
+    if (this->route == nullptr)
+    {
+        return -1;
+    }
+    auto it = this->route->pathIndexByNodeID.find(nodeID);
+    if (it == this->route->pathIndexByNodeID.end())
+    {
+        return -1;
+    }
+    return it->second;
+}
+
+void Train::advanceRouteCursor(int nodeID)
+{
+    for (int i = this->routeCursor; i < this->trainPath.size(); i++)
+    {
+        if (this->trainPath[i] == nodeID)
+        {
+            this->routeCursor = i;
+            return;
+        }
+    }
+}
+
 void Train::resetTrain()
 {
-    this->betweenNodesLengths.clear();
     for (Vector<std::shared_ptr<TrainComponent>>::iterator
              it = this->trainVehicles.begin();
          it != this->trainVehicles.end(); ++it)
@@ -2212,6 +2270,10 @@ void Train::resetTrain()
     this->optimumThrottleLevel     = 1;
     this->maxDelayTimeStat         = 0.0;
     this->stoppedStat              = 0.0;
+    this->stepSnapshot             = StepSnapshot();
+    this->routeCursor              = 0;
+    this->frontSignalCursor        = 0;
+    this->backSignalCursor         = 0;
 
     // this->LastTrainPointpreviousNodeID = -1;
     // this->previousNodeID = -1;
@@ -11,6 +11,7 @@
 #include "../util/vector.h"
 #include "car.h"
 #include "locomotive.h"
+#include "../network/netroute.h"
 #include "../util/map.h"
 #include "qobject.h"
 #include <utility>
@@ -36,6 +37,8 @@ class NetNode;
  * @date	2/28/2023
  */
 class NetLink;
+
+class NetSignal;
 using namespace std;
 
 /**
@@ -190,13 +193,10 @@ public:
     Vector<std::shared_ptr<NetNode>> trainPathNodes;
     /** The spanned links the train is on. works as blocks */
     Vector<std::shared_ptr<NetLink>> currentLinks;
-    /** Holds the computed distances between two nodes along the train's path */
-    Vector<Vector<double>> betweenNodesLengths;
-    /** Holds the cummulative distance from the start of the train's path to each and every node in
-     * the path. */
-    Vector<double> linksCumLengths;
-    /** Holds the lower speed node ID's the train will have to reduce its speed at */
-    Vector<Vector<Map<int, double>>> LowerSpeedNodeIDs;
+    /** The compiled route of the train's path. It holds the cummulative distance from the start
+     * of the path to every node, the path index table, and the per link track data. Trains that
+     * travel between the same nodes share the same route. */
+    std::shared_ptr<const NetRoute> route;
     /** Holds both the start and end tips' coordinates of the train */
     Vector<pair<double, double>> startEndPoints;
     /** The previous links the train spanned before. */
@@ -227,6 +227,9 @@ public:
     int previousNodeID;
     /** The previous node ID the last point of the train just passed */
     int LastTrainPointpreviousNodeID;
+    /** The path index of the previous node the tip of the train just passed.
+     * It only moves forward along the path. */
+    int routeCursor = 0;
     /** The next node the train is targetting */
     int nextNodeID;
     /** Counts the number of steps the train could not move forward because of the lack of power
@@ -261,6 +264,47 @@ public:
     double dwellStartTime = -1;
     double dwellDuration = 0;
 
+    /**
+     * @brief The state of the train that other trains are allowed to
+     * observe while a simulator step is being computed.
+     */
+    struct StepSnapshot {
+        /** True while the train's new state is not committed yet */
+        bool pending = false;
+        bool loaded = false;
+        bool reachedDestination = false;
+        double travelledDistance = 0.0;
+        double currentSpeed = 0.0;
+    };
+
+    /** The train state at the start of the current simulator step */
+    StepSnapshot stepSnapshot;
+
+    /**
+     * @brief A signal along the train path the train requests to pass.
+     */
+    struct RouteSignal {
+        /** The path index of the signal node */
+        int pathIndex = -1;
+        /** The path index the distance to the signal is measured to. The
+         * route distances are read when the train is loaded since the
+         * routes with parallel links are compiled then. */
+        int distanceIndex = -1;
+        /** The signal facing the train at the node */
+        std::shared_ptr<NetSignal> signal;
+        /** The controller signals the train passes in its direction */
+        Vector<std::shared_ptr<NetSignal>> sameDirectionSignals;
+    };
+
+    /** The signals along the train path ordered by the path index */
+    Vector<RouteSignal> routeSignals;
+    /** The index in routeSignals of the next signal ahead of the train tip.
+     * It only moves forward along the path. */
+    int frontSignalCursor = 0;
+    /** The index in routeSignals of the next signal ahead of the train end.
+     * It only moves forward along the path. */
+    int backSignalCursor = 0;
+
     /**
      * \brief This constructor initializes a train with the passed parameters
      *
@@ -1066,6 +1110,50 @@ public:
      */
     void resetTrainLookAhead();
 
+    /**
+     * @brief Captures the current train state into the step snapshot.
+     * @param pending   true if the train state will change before the
+     *                  simulator commits it.
+     */
+    void captureStepSnapshot(bool pending);
+
+    /**
+     * @brief Takes the catenary energy the train vehicles exchanged since
+     *        the last call, in the vehicles order.
+     * @return the catenary energy of each vehicle exchange.
+     */
+    Vector<TrainComponent::CatenaryEnergy> takeCatenaryEnergy();
+
+    /**
+     * @brief Gets the train state that other trains should observe.
+     * @return the step snapshot if the train is not committed yet,
+     *         the live state otherwise.
+     */
+    StepSnapshot getObservedState() const;
+
+    /**
+     * @brief Sets the compiled route of the train path and resets the
+     * route and signal cursors to the start of the path. The route
+     * signals are cleared until the simulator sets them again.
+     * @param newRoute  the route of the train path.
+     */
+    void setRoute(std::shared_ptr<const NetRoute> newRoute);
+
+    /**
+     * @brief Gets the index of a node in the train path.
+     * @param nodeID    the simulator node ID.
+     * @return the first index of the node in the train path,
+     *         -1 if the node is not in the path.
+     */
+    int getPathIndex(int nodeID) const;
+
+    /**
+     * @brief Moves the route cursor forward to the next occurrence of
+     * a node in the train path. The cursor never moves backward.
+     * @param nodeID    the simulator node ID the tip of the train passed.
+     */
+    void advanceRouteCursor(int nodeID);
+
     /**
      * @brief getMaxProvidedEnergy
      * @param timeStep
@@ -109,7 +109,7 @@ std::pair<bool, double> TrainComponent::consumeElectricity(double timeStep, doub
         // update stats
 		this->energyConsumed = EC_kwh;
 		this->cumEnergyConsumed += this->energyConsumed;
-        this->hostLink->catenaryCumConsumedEnergy += EC_kwh;
+        this->pendingCatenaryEnergy.push_back({this->hostLink, EC_kwh, 0.0});
         // return true as all energy required is consumed from the catenary
 		return std::make_pair(true, 0.0);
     } // end else
@@ -151,7 +151,7 @@ bool TrainComponent::rechargeCatenary(double EC_kwh) {
     // if the link the vehicle is on has catenary, recharge it
 	if (this->hostLink->hasCatenary){
         // trasfer regenerated energy to the catenary
-		this->hostLink->catenaryCumRegeneratedEnergy += std::abs(EC_kwh);
+		this->pendingCatenaryEnergy.push_back({this->hostLink, 0.0, std::abs(EC_kwh)});
         // add the total amount of regenerated energy to the train total Regenerated Energy
         this->energyRegenerated = std::abs(EC_kwh);
         this->cumEnergyRegenerated += this->energyRegenerated;
@@ -66,6 +66,20 @@ public:
 	/** Holds the current link this vehicle is on. */
 	std::shared_ptr<NetLink> hostLink;
 
+	/** The catenary energy a vehicle exchanged with a link */
+	struct CatenaryEnergy {
+		/** The link the energy was exchanged on */
+		std::shared_ptr<NetLink> link;
+		/** The energy consumed from the catenary in kwh */
+		double consumed = 0.0;
+		/** The energy regenerated to the catenary in kwh */
+		double regenerated = 0.0;
+	};
+	/** The catenary energy exchanged since the simulator last took it. The
+	 * links are shared by the trains, so the simulator adds it to them when
+	 * the train step is committed */
+	Vector<CatenaryEnergy> pendingCatenaryEnergy;
+
 
     /***********************************************
     *                   Methods                    *
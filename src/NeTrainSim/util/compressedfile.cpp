@@ -0,0 +1,234 @@
+#include "compressedfile.h"
+#include <cstring>
+
+bool CompressedFile::isCompressedFile(const QString& filename) {
+    QFile f(filename);
+    if (!f.open(QIODevice::ReadOnly)) { return false; }
+    return f.read(4) == QByteArray("NTZB", 4);
+}
+
+// ---------------------------------------------------------------------------
+// CompressedFileBuffer
+// ---------------------------------------------------------------------------
+
+CompressedFileBuffer::CompressedFileBuffer() {}
+
+CompressedFileBuffer::~CompressedFileBuffer() {
+    this->close();
+}
+
+bool CompressedFileBuffer::open(const std::string& filename, int blockSize) {
+    this->close();
+
+    this->file.open(filename,
+                    std::ios::out | std::ios::trunc | std::ios::binary);
+    if (!this->file.is_open()) { return false; }
+
+    this->fileOffset = 0;
+    this->rawOffset = 0;
+    this->blocks.clear();
+    this->block.resize(blockSize > 0 ? blockSize :
+                                       CompressedFile::DefaultBlockSize);
+    this->setp(this->block.data(), this->block.data() + this->block.size());
+
+    CompressedFile::Header header = {};
+    std::memcpy(header.magic, "NTZB", 4);
+    header.version = CompressedFile::Version;
+    header.blockSize = this->block.size();
+    this->writeBytes(&header, sizeof(header));
+    return true;
+}
+
+bool CompressedFileBuffer::isOpen() const {
+    return this->file.is_open();
+}
+
+bool CompressedFileBuffer::close() {
+    if (!this->file.is_open()) { return true; }
+
+    bool isWritten = this->writeBlock();
+
+    // the index and the footer mark the file as complete
+    CompressedFile::Footer footer = {};
+    footer.blockCount = this->blocks.size();
+    footer.indexOffset = this->fileOffset;
+    std::memcpy(footer.magic, "NTZI", 4);
+    if (!this->blocks.empty()) {
+        this->writeBytes(this->blocks.data(),
+                         this->blocks.size() *
+                             sizeof(CompressedFile::BlockEntry));
+    }
+    this->writeBytes(&footer, sizeof(footer));
+
+    isWritten = isWritten && this->file.good();
+    this->file.close();
+    this->setp(nullptr, nullptr);
+    this->block.clear();
+    this->blocks.clear();
+    return isWritten;
+}
+
+CompressedFileBuffer::int_type CompressedFileBuffer::overflow(int_type ch) {
+    if (!this->file.is_open() || !this->writeBlock()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+        *this->pptr() = traits_type::to_char_type(ch);
+        this->pbump(1);
+    }
+    return traits_type::not_eof(ch);
+}
+
+int CompressedFileBuffer::sync() {
+    if (!this->file.is_open()) { return 0; }
+    this->file.flush();
+    return this->file.good() ? 0 : -1;
+}
+
+bool CompressedFileBuffer::writeBlock() {
+    int rawSize = this->pptr() - this->pbase();
+    if (rawSize <= 0) { return true; }
+
+    QByteArray compressed = qCompress(
+        reinterpret_cast<const uchar*>(this->pbase()), rawSize);
+
+    CompressedFile::BlockEntry entry;
+    entry.fileOffset = this->fileOffset;
+    entry.rawOffset = this->rawOffset;
+    this->blocks.push_back(entry);
+
+    uint32_t sizes[2] = {static_cast<uint32_t>(rawSize),
+                         static_cast<uint32_t>(compressed.size())};
+    this->writeBytes(sizes, sizeof(sizes));
+    this->writeBytes(compressed.constData(), compressed.size());
+
+    this->rawOffset += rawSize;
+    this->setp(this->block.data(), this->block.data() + this->block.size());
+    return this->file.good();
+}
+
+void CompressedFileBuffer::writeBytes(const void* data, size_t size) {
+    this->file.write(static_cast<const char*>(data), size);
+    this->fileOffset += size;
+}
+
+// ---------------------------------------------------------------------------
+// CompressedOFStream
+// ---------------------------------------------------------------------------
+
+CompressedOFStream::CompressedOFStream() : std::ostream(nullptr) {
+    this->rdbuf(&this->buffer);
+}
+
+void CompressedOFStream::open(const std::string& filename) {
+    if (this->buffer.open(filename)) { this->clear(); }
+    else { this->setstate(std::ios::failbit); }
+}
+
+bool CompressedOFStream::is_open() const {
+    return this->buffer.isOpen();
+}
+
+void CompressedOFStream::close() {
+    if (!this->buffer.close()) { this->setstate(std::ios::failbit); }
+}
+
+// ---------------------------------------------------------------------------
+// CompressedFileReader
+// ---------------------------------------------------------------------------
+
+CompressedFileReader::CompressedFileReader() {}
+
+bool CompressedFileReader::open(const QString& filename) {
+    this->close();
+
+    this->file.setFileName(filename);
+    if (!this->file.open(QIODevice::ReadOnly)) { return false; }
+
+    CompressedFile::Header header;
+    if (this->file.read(reinterpret_cast<char*>(&header), sizeof(header)) !=
+            static_cast<qint64>(sizeof(header)) ||
+        std::memcmp(header.magic, "NTZB", 4) != 0 ||
+        header.version != CompressedFile::Version) {
+        this->close();
+        return false;
+    }
+
+    // read the blocks index of a complete file
+    qint64 size = this->file.size();
+    CompressedFile::Footer footer;
+    if (size >= static_cast<qint64>(sizeof(header) + sizeof(footer)) &&
+        this->file.seek(size - sizeof(footer)) &&
+        this->file.read(reinterpret_cast<char*>(&footer), sizeof(footer)) ==
+            static_cast<qint64>(sizeof(footer)) &&
+        std::memcmp(footer.magic, "NTZI", 4) == 0 &&
+        footer.indexOffset + footer.blockCount *
+            sizeof(CompressedFile::BlockEntry) + sizeof(footer) ==
+            static_cast<uint64_t>(size)) {
+        this->blocks.resize(footer.blockCount);
+        this->file.seek(footer.indexOffset);
+        qint64 indexSize =
+            footer.blockCount * sizeof(CompressedFile::BlockEntry);
+        if (this->file.read(reinterpret_cast<char*>(this->blocks.data()),
+                            indexSize) == indexSize) {
+            return true;
+        }
+        this->blocks.clear();
+    }
+
+    // otherwise walk the blocks sizes
+    qint64 offset = sizeof(header);
+    qint64 rawOffset = 0;
+    uint32_t sizes[2];
+    while (this->file.seek(offset) &&
+           this->file.read(reinterpret_cast<char*>(sizes), sizeof(sizes)) ==
+               static_cast<qint64>(sizeof(sizes)) &&
+           offset + static_cast<qint64>(sizeof(sizes)) + sizes[1] <= size) {
+        CompressedFile::BlockEntry entry;
+        entry.fileOffset = offset;
+        entry.rawOffset = rawOffset;
+        this->blocks.push_back(entry);
+        offset += sizeof(sizes) + sizes[1];
+        rawOffset += sizes[0];
+    }
+    return true;
+}
+
+void CompressedFileReader::close() {
+    if (this->file.isOpen()) { this->file.close(); }
+    this->blocks.clear();
+}
+
+int CompressedFileReader::getBlockCount() const {
+    return this->blocks.size();
+}
+
+qint64 CompressedFileReader::getBlockRawOffset(int blockIndex) const {
+    return this->blocks.at(blockIndex).rawOffset;
+}
+
+QByteArray CompressedFileReader::readBlock(int blockIndex) {
+    if (blockIndex < 0 || blockIndex >= static_cast<int>(this->blocks.size())) {
+        return QByteArray();
+    }
+
+    uint32_t sizes[2];
+    if (!this->file.seek(this->blocks[blockIndex].fileOffset) ||
+        this->file.read(reinterpret_cast<char*>(sizes), sizeof(sizes)) !=
+            static_cast<qint64>(sizeof(sizes))) {
+        return QByteArray();
+    }
+    QByteArray compressed = this->file.read(sizes[1]);
+    if (compressed.size() != static_cast<qsizetype>(sizes[1])) {
+        return QByteArray();
+    }
+    return qUncompress(compressed);
+}
+
+QByteArray CompressedFileReader::readAll() {
+    QByteArray text;
+    for (int i = 0; i < static_cast<int>(this->blocks.size()); i++) {
+        text.append(this->readBlock(i));
+    }
+    return text;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file compressedfile.h
+ * @brief This file declares the classes that write and read the block
+ *        compressed output files (.ntz).
+ *        The output text is cut into fixed size blocks and every block is
+ *        compressed on its own (zlib), so a reader can seek to any block
+ *        and decompress it without reading the blocks before it.
+ *
+ *        File layout: the CompressedFile::Header, then every block as
+ *        its raw size, its compressed size (32 bits each) and the
+ *        compressed bytes, then the blocks index (the file offset and the
+ *        raw offset of every block, 64 bits each) and the
+ *        CompressedFile::Footer.
+ */
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include "../export.h"
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace CompressedFile {
+    /** (Immutable) the extension appended to the compressed files */
+    inline const std::string Extension = "ntz";
+    /** (Immutable) the default size in bytes of an uncompressed block */
+    static constexpr int DefaultBlockSize = 1 << 20;
+    /** (Immutable) the version of the compressed file format */
+    static constexpr uint32_t Version = 1;
+
+    /** The header at the start of a compressed file */
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t blockSize;
+        uint32_t reserved;
+    };
+
+    /** The footer at the end of a complete compressed file */
+    struct Footer {
+        uint64_t blockCount;
+        /** The file offset of the blocks index */
+        uint64_t indexOffset;
+        char magic[4];
+        uint32_t reserved;
+    };
+
+    /** The index entry of a block */
+    struct BlockEntry {
+        /** The file offset of the block sizes */
+        uint64_t fileOffset;
+        /** The offset of the block in the uncompressed text */
+        uint64_t rawOffset;
+    };
+
+    /**
+     * @brief Checks if a file is a block compressed file.
+     * @param filename The file to check.
+     * @return true if the file starts with the compressed file magic.
+     */
+    bool NETRAINSIMCORE_EXPORT isCompressedFile(const QString& filename);
+}
+
+/**
+ * @class CompressedFileBuffer
+ * @brief A write only stream buffer that compresses the written text in
+ *        fixed size blocks.
+ */
+class NETRAINSIMCORE_EXPORT CompressedFileBuffer : public std::streambuf {
+public:
+    CompressedFileBuffer();
+    ~CompressedFileBuffer() override;
+
+    /**
+     * @brief Opens the compressed file and writes its header.
+     * @param filename The compressed file path.
+     * @param blockSize The size in bytes of an uncompressed block.
+     * @return true if the file is opened, false otherwise.
+     */
+    bool open(const std::string& filename,
+              int blockSize = CompressedFile::DefaultBlockSize);
+
+    /**
+     * @brief Checks if the file is open.
+     * @return true if the file is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Compresses the last block, writes the blocks index and closes
+     *        the file.
+     * @return true if all the blocks were written.
+     */
+    bool close();
+
+protected:
+    /**
+     * @brief Compresses the full block and starts a new one.
+     */
+    int_type overflow(int_type ch) override;
+
+    /**
+     * @brief Flushes the written blocks to the file. The current block is
+     *        kept open, so the blocks keep their size.
+     */
+    int sync() override;
+
+private:
+    /** The compressed file */
+    std::ofstream file;
+    /** The uncompressed text of the current block */
+    std::vector<char> block;
+    /** The index of the written blocks */
+    std::vector<CompressedFile::BlockEntry> blocks;
+    /** The number of bytes written to the file */
+    uint64_t fileOffset = 0;
+    /** The number of uncompressed bytes written before the current block */
+    uint64_t rawOffset = 0;
+
+    /**
+     * @brief Compresses the current block and writes it to the file.
+     * @return true if the block was written.
+     */
+    bool writeBlock();
+
+    /**
+     * @brief Writes raw bytes to the file.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     */
+    void writeBytes(const void* data, size_t size);
+};
+
+/**
+ * @class CompressedOFStream
+ * @brief An output stream writing a block compressed file, used in place
+ *        of a std::ofstream.
+ */
+class NETRAINSIMCORE_EXPORT CompressedOFStream : public std::ostream {
+public:
+    CompressedOFStream();
+
+    /**
+     * @brief Opens the compressed file. Sets the failbit if it fails.
+     * @param filename The compressed file path.
+     */
+    void open(const std::string& filename);
+
+    /**
+     * @brief Checks if the file is open.
+     * @return true if the file is open.
+     */
+    bool is_open() const;
+
+    /**
+     * @brief Writes the remaining text and closes the file. Sets the
+     *        failbit if it fails.
+     */
+    void close();
+
+private:
+    /** The compressing stream buffer */
+    CompressedFileBuffer buffer;
+};
+
+/**
+ * @class CompressedFileReader
+ * @brief Reads the blocks of a block compressed file.
+ */
+class NETRAINSIMCORE_EXPORT CompressedFileReader {
+public:
+    CompressedFileReader();
+
+    /**
+     * @brief Opens a compressed file and reads its blocks index. If the
+     *        file has no index (it was not closed), the blocks are found by
+     *        walking the blocks sizes.
+     * @param filename The compressed file path.
+     * @return true if the file is a compressed file, false otherwise.
+     */
+    bool open(const QString& filename);
+
+    /**
+     * @brief Closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Gets the number of blocks in the file.
+     * @return The number of blocks.
+     */
+    int getBlockCount() const;
+
+    /**
+     * @brief Gets the offset of a block in the uncompressed text.
+     * @param blockIndex The block index.
+     * @return The uncompressed offset of the block.
+     */
+    qint64 getBlockRawOffset(int blockIndex) const;
+
+    /**
+     * @brief Reads and decompresses a block.
+     * @param blockIndex The block index.
+     * @return The uncompressed text of the block, empty if it cannot be
+     *         read.
+     */
+    QByteArray readBlock(int blockIndex);
+
+    /**
+     * @brief Reads and decompresses all the blocks.
+     * @return The uncompressed text of the file.
+     */
+    QByteArray readAll();
+
+private:
+    /** The compressed file */
+    QFile file;
+    /** The index of the blocks */
+    std::vector<CompressedFile::BlockEntry> blocks;
+};
+
+#endif // COMPRESSEDFILE_H
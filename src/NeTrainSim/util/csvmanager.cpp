@@ -1,10 +1,12 @@
 #include "csvmanager.h"
+#include <QBuffer>
 #include <QFile>
 #include <QTextStream>
 #include <iostream>
 #include <stdexcept>
 #include <QSet>
 #include "error.h"
+#include "compressedfile.h"
 
 CSVManager::CSVManager(QObject* parent)
     : QObject(parent) {}
@@ -12,12 +14,27 @@ CSVManager::CSVManager(QObject* parent)
 QVector<QVector<QString>> CSVManager::readCSV(const QString& filename, const QString& delimiter, bool firstRowHeader) {
     QFile file(filename);
     data.clear();
+    header.clear();
     if (!file.open(QIODevice::ReadOnly)) {
         throw std::runtime_error("Error: " + std::to_string(static_cast<int>(Error::CouldNotOpenFile)) +
                                  "\nFailed to open file: " + filename.toStdString());
     }
 
-    QTextStream in(&file);
+    // the block compressed files are decompressed before parsing
+    QBuffer decompressed;
+    QIODevice* device = &file;
+    if (CompressedFile::isCompressedFile(filename)) {
+        CompressedFileReader reader;
+        if (!reader.open(filename)) {
+            throw std::runtime_error("Error: " + std::to_string(static_cast<int>(Error::CouldNotOpenFile)) +
+                                     "\nFailed to open file: " + filename.toStdString());
+        }
+        decompressed.setData(reader.readAll());
+        decompressed.open(QIODevice::ReadOnly);
+        device = &decompressed;
+    }
+
+    QTextStream in(device);
     bool isFirstRow = true; // Flag to skip the first row
 
     while (!in.atEnd()) {
@@ -25,6 +42,10 @@ QVector<QVector<QString>> CSVManager::readCSV(const QString& filename, const QSt
 
         if (isFirstRow && firstRowHeader) {
             isFirstRow = false;
+            // Keep the column names
+            for (const QString& name : line.split(delimiter)) {
+                header.append(name.trimmed());
+            }
             continue; // Skip the first row
         }
 
@@ -99,3 +120,7 @@ QVector<QString> CSVManager::getColumnValues(const QVector<QVector<QString>> &da
 
     return columnValues;
 }
+
+int CSVManager::getColumnIndex(const QString &name) const {
+    return header.indexOf(name);
+}
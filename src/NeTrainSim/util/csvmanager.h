@@ -68,6 +68,14 @@ public:
      */
     QVector<QString> getColumnValues(const QVector<QVector<QString>>& data, int column) const;
 
+    /**
+     * Gets the index of a column by its name in the header row of the last read file.
+     *
+     * @param name The column name.
+     * @returns The column index, -1 if the file has no header row or no such column.
+     */
+    int getColumnIndex(const QString& name) const;
+
 signals:
     /**
      * Signal emitted when the data is ready.
@@ -78,6 +86,7 @@ signals:
 
 private:
     QVector<QVector<QString>> data;
+    QVector<QString> header;
 };
 
 #endif // CSVMANAGER_H
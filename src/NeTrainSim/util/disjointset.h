@@ -0,0 +1,105 @@
+/**
+ * @file DisjointSet.h
+ * @brief This file declares the DisjointSet class, a union-find structure
+ *        over non negative integer IDs such as the simulator node IDs.
+ *        The sets are merged by size and the finds halve the paths, so a
+ *        sequence of operations runs in near linear time.
+ */
+#ifndef DISJOINTSET_H
+#define DISJOINTSET_H
+
+#include <map>
+#include <utility>
+#include <vector>
+
+class DisjointSet {
+public:
+    /**
+     * @brief Adds an ID as a set of its own if it is not added yet.
+     * @param id    the ID.
+     * @return true if the ID was not added before.
+     */
+    bool insert(int id) {
+        if (id >= static_cast<int>(parent.size())) {
+            parent.resize(id + 1, -1);
+            size.resize(id + 1, 0);
+        }
+        if (parent[id] < 0) {
+            parent[id] = id;
+            size[id] = 1;
+            ids.push_back(id);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Checks if an ID was added.
+     * @param id    the ID.
+     * @return true if the ID is in any set.
+     */
+    bool contains(int id) const {
+        return id >= 0 && id < static_cast<int>(parent.size()) &&
+               parent[id] >= 0;
+    }
+
+    /**
+     * @brief Finds the representative ID of the set of an added ID.
+     * @param id    the ID.
+     * @return the representative ID.
+     */
+    int find(int id) {
+        while (parent[id] != id) {
+            parent[id] = parent[parent[id]];
+            id = parent[id];
+        }
+        return id;
+    }
+
+    /**
+     * @brief Merges the sets of two IDs, the IDs are added if needed.
+     * @param first     the first ID.
+     * @param second    the second ID.
+     * @return true if the IDs were in different sets or not added before.
+     */
+    bool unite(int first, int second) {
+        bool isAdded = insert(first);
+        isAdded = insert(second) || isAdded;
+        int a = find(first);
+        int b = find(second);
+        if (a == b) { return isAdded; }
+        if (size[a] < size[b]) { std::swap(a, b); }
+        parent[b] = a;
+        size[a] += size[b];
+        return true;
+    }
+
+    /**
+     * @brief Gets the sets, each ordered by the insertion of its IDs.
+     * @return the sets ordered by the insertion of their first ID.
+     */
+    std::vector<std::vector<int>> getSets() {
+        std::map<int, int> setIndexByRoot;
+        std::vector<std::vector<int>> sets;
+        for (int id : ids) {
+            int root = find(id);
+            auto it = setIndexByRoot.find(root);
+            if (it == setIndexByRoot.end()) {
+                it = setIndexByRoot.emplace(root, sets.size()).first;
+                sets.emplace_back();
+            }
+            sets[it->second].push_back(id);
+        }
+        return sets;
+    }
+
+private:
+    /** The parent of each ID, -1 if the ID is not added */
+    std::vector<int> parent;
+    /** The size of the set of each representative ID */
+    std::vector<int> size;
+    /** The added IDs in the insertion order */
+    std::vector<int> ids;
+};
+
+#endif // DISJOINTSET_H
@@ -45,6 +45,7 @@ enum class Error {
     // output start with 4
     cannotOpenTrajectoryFile        = 410,
     cannotOpenSummaryFile           = 420,
+    wrongTrajectoryColumn           = 430,
 
 
     CouldNotOpenFile                = 500
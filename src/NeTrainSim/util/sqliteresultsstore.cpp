@@ -0,0 +1,212 @@
+#include "sqliteresultsstore.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStringList>
+#include <QVariant>
+
+SQLiteResultsStore::SQLiteResultsStore() {}
+
+SQLiteResultsStore::~SQLiteResultsStore() {
+    this->close();
+}
+
+bool SQLiteResultsStore::open(const QString& filename,
+                              const QString& runName) {
+    this->close();
+
+    this->connectionName = QString("NeTrainSimResults_%1")
+                               .arg(reinterpret_cast<quintptr>(this));
+    this->runName = runName;
+    {
+        QSqlDatabase db =
+            QSqlDatabase::addDatabase("QSQLITE", this->connectionName);
+        db.setDatabaseName(filename);
+        if (!db.open()) {
+            qWarning() << "Could not open the results database"
+                       << filename << ":" << db.lastError().text();
+            db = QSqlDatabase();
+            QSqlDatabase::removeDatabase(this->connectionName);
+            this->connectionName.clear();
+            return false;
+        }
+    }
+
+    // the trajectory columns follow the trajectory file columns
+    QStringList trajectoryColumns;
+    QStringList trajectoryPlaceholders;
+    for (const TrajectoryWriter::Column& column :
+         TrajectoryWriter::getColumns()) {
+        trajectoryColumns << QString("%1 %2").arg(
+            column.name,
+            column.type == TrajectoryWriter::ColumnType::Int32 ?
+                "INTEGER" : "REAL");
+        trajectoryPlaceholders << "?";
+    }
+
+    bool isCreated =
+        this->execute("PRAGMA journal_mode = WAL") &&
+        this->execute("PRAGMA synchronous = NORMAL") &&
+        this->execute("CREATE TABLE IF NOT EXISTS runs ("
+                      "run TEXT PRIMARY KEY, created_at TEXT)") &&
+        this->execute("CREATE TABLE IF NOT EXISTS trajectory ("
+                      "run TEXT NOT NULL, train_id TEXT NOT NULL, " +
+                      trajectoryColumns.join(", ") + ")") &&
+        this->execute("CREATE TABLE IF NOT EXISTS train_summary ("
+                      "run TEXT NOT NULL, train_id TEXT NOT NULL, "
+                      "reached_destination INTEGER, start_node INTEGER, "
+                      "destination_node INTEGER, path_length_m REAL, "
+                      "trip_time_s REAL, average_speed_mps REAL, "
+                      "average_acceleration_mps2 REAL, "
+                      "travelled_distance_m REAL, "
+                      "energy_consumption_kwh REAL, "
+                      "energy_consumed_kwh REAL, "
+                      "energy_regenerated_kwh REAL, delay_time_s REAL, "
+                      "max_delay_time_s REAL, stoppings REAL, "
+                      "cargo_net_weight_ton REAL, ton_km REAL, "
+                      "optimization_enabled INTEGER)");
+    if (!isCreated) {
+        this->close();
+        return false;
+    }
+
+    QSqlDatabase db = QSqlDatabase::database(this->connectionName, false);
+    QSqlQuery addRun(db);
+    addRun.prepare("INSERT OR IGNORE INTO runs (run, created_at) "
+                   "VALUES (?, ?)");
+    addRun.addBindValue(this->runName);
+    addRun.addBindValue(QDateTime::currentDateTime().toString(Qt::ISODate));
+    if (!addRun.exec()) {
+        qWarning() << "Could not add the run" << this->runName << ":"
+                   << addRun.lastError().text();
+        addRun = QSqlQuery();
+        db = QSqlDatabase();
+        this->close();
+        return false;
+    }
+
+    this->trajectoryInsert = std::make_unique<QSqlQuery>(db);
+    this->trajectoryInsert->prepare(
+        "INSERT INTO trajectory VALUES (?, ?, " +
+        trajectoryPlaceholders.join(", ") + ")");
+    this->summaryInsert = std::make_unique<QSqlQuery>(db);
+    this->summaryInsert->prepare(
+        "INSERT INTO train_summary VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, "
+        "?, ?, ?, ?, ?, ?, ?, ?, ?)");
+
+    this->transactionRows = 0;
+    db.transaction();
+    return true;
+}
+
+bool SQLiteResultsStore::isOpen() const {
+    return !this->connectionName.isEmpty();
+}
+
+bool SQLiteResultsStore::execute(const QString& statement) {
+    QSqlQuery query(QSqlDatabase::database(this->connectionName, false));
+    if (!query.exec(statement)) {
+        qWarning() << "Results database error:"
+                   << query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void SQLiteResultsStore::countInsertedRow() {
+    if (++this->transactionRows < TransactionRows) { return; }
+
+    QSqlDatabase db = QSqlDatabase::database(this->connectionName, false);
+    db.commit();
+    db.transaction();
+    this->transactionRows = 0;
+}
+
+bool SQLiteResultsStore::insertTrajectoryRow(
+    const QString& trainID, const TrajectoryWriter::Record& record,
+    const std::vector<int>& exportedColumns) {
+    if (!this->isOpen()) { return false; }
+
+    QSqlQuery& query = *this->trajectoryInsert;
+    const std::vector<TrajectoryWriter::Column>& columns =
+        TrajectoryWriter::getColumns();
+    query.bindValue(0, this->runName);
+    query.bindValue(1, trainID);
+    for (int c = 0; c < static_cast<int>(columns.size()); c++) {
+        query.bindValue(c + 2, QVariant());
+    }
+    for (int c : exportedColumns) {
+        double value = TrajectoryWriter::getColumnValue(record, c);
+        if (columns[c].type == TrajectoryWriter::ColumnType::Int32) {
+            query.bindValue(c + 2, static_cast<qlonglong>(value));
+        }
+        else {
+            query.bindValue(c + 2, value);
+        }
+    }
+    if (!query.exec()) {
+        qWarning() << "Could not insert a trajectory row:"
+                   << query.lastError().text();
+        return false;
+    }
+    this->countInsertedRow();
+    return true;
+}
+
+bool SQLiteResultsStore::insertTrainSummary(const TrainSummary& summary) {
+    if (!this->isOpen()) { return false; }
+
+    QSqlQuery& query = *this->summaryInsert;
+    int i = 0;
+    query.bindValue(i++, this->runName);
+    query.bindValue(i++, summary.trainID);
+    query.bindValue(i++, summary.reachedDestination ? 1 : 0);
+    query.bindValue(i++, summary.startNode);
+    query.bindValue(i++, summary.destinationNode);
+    query.bindValue(i++, summary.pathLength);
+    query.bindValue(i++, summary.tripTime);
+    query.bindValue(i++, summary.averageSpeed);
+    query.bindValue(i++, summary.averageAcceleration);
+    query.bindValue(i++, summary.travelledDistance);
+    query.bindValue(i++, summary.energyConsumption);
+    query.bindValue(i++, summary.energyConsumed);
+    query.bindValue(i++, summary.energyRegenerated);
+    query.bindValue(i++, summary.delayTime);
+    query.bindValue(i++, summary.maxDelayTime);
+    query.bindValue(i++, summary.stoppings);
+    query.bindValue(i++, summary.cargoNetWeight);
+    query.bindValue(i++, summary.tonKm);
+    query.bindValue(i++, summary.optimizationEnabled ? 1 : 0);
+    if (!query.exec()) {
+        qWarning() << "Could not insert a train summary:"
+                   << query.lastError().text();
+        return false;
+    }
+    this->countInsertedRow();
+    return true;
+}
+
+void SQLiteResultsStore::close() {
+    if (!this->isOpen()) { return; }
+
+    this->trajectoryInsert.reset();
+    this->summaryInsert.reset();
+    {
+        QSqlDatabase db =
+            QSqlDatabase::database(this->connectionName, false);
+        if (db.isOpen()) {
+            db.commit();
+            // the indexes are built once after the bulk inserts
+            this->execute("CREATE INDEX IF NOT EXISTS trajectory_run_train "
+                          "ON trajectory (run, train_id, TStep_s)");
+            this->execute("CREATE INDEX IF NOT EXISTS "
+                          "train_summary_run_train "
+                          "ON train_summary (run, train_id)");
+            db.close();
+        }
+    }
+    QSqlDatabase::removeDatabase(this->connectionName);
+    this->connectionName.clear();
+}
@@ -0,0 +1,134 @@
+/**
+ * @file SQLiteResultsStore.h
+ * @brief This file declares the SQLiteResultsStore class that writes the
+ *        simulation results to a local SQLite database.
+ *        A database holds many runs: the runs table lists them, the
+ *        trajectory table holds the trajectory rows and the train_summary
+ *        table holds the summary of every train, both keyed by the run name
+ *        and the train user ID.
+ *        The rows are inserted through prepared statements in large
+ *        transactions, and the indexes are created once the rows are
+ *        inserted.
+ */
+#ifndef SQLITERESULTSSTORE_H
+#define SQLITERESULTSSTORE_H
+
+#include "../export.h"
+#include "trajectorywriter.h"
+#include <QString>
+#include <memory>
+#include <vector>
+
+class QSqlQuery; // Forward declaration of QSqlQuery class
+
+class NETRAINSIMCORE_EXPORT SQLiteResultsStore {
+public:
+    /** The summary of a train in a run */
+    struct TrainSummary {
+        QString trainID;
+        bool reachedDestination = false;
+        int startNode = 0;
+        int destinationNode = 0;
+        double pathLength = 0.0;
+        double tripTime = 0.0;
+        double averageSpeed = 0.0;
+        double averageAcceleration = 0.0;
+        double travelledDistance = 0.0;
+        double energyConsumption = 0.0;
+        double energyConsumed = 0.0;
+        double energyRegenerated = 0.0;
+        double delayTime = 0.0;
+        double maxDelayTime = 0.0;
+        double stoppings = 0.0;
+        double cargoNetWeight = 0.0;
+        double tonKm = 0.0;
+        bool optimizationEnabled = false;
+    };
+
+    /** (Immutable) the number of rows inserted in one transaction */
+    static constexpr int TransactionRows = 100000;
+
+    /**
+     * @brief Constructs a closed results store.
+     */
+    SQLiteResultsStore();
+
+    /**
+     * @brief Closes the database if it is open.
+     */
+    ~SQLiteResultsStore();
+
+    SQLiteResultsStore(const SQLiteResultsStore&) = delete;
+    SQLiteResultsStore& operator=(const SQLiteResultsStore&) = delete;
+
+    /**
+     * @brief Opens or creates the database and its tables, and adds the
+     *        run if it does not exist.
+     *
+     * The database connection belongs to the calling thread, so the
+     * store must be used from that thread only.
+     *
+     * @param filename The database file.
+     * @param runName The name of the run the rows belong to.
+     * @return true if the database is open, false otherwise.
+     */
+    bool open(const QString& filename, const QString& runName);
+
+    /**
+     * @brief Checks if the database is open.
+     * @return true if the database is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Inserts a trajectory row of the run.
+     * @param trainID The train user ID.
+     * @param record The trajectory record.
+     * @param exportedColumns The indices in TrajectoryWriter::getColumns of
+     *                        the exported columns, the others are NULL.
+     * @return true if the row is inserted.
+     */
+    bool insertTrajectoryRow(const QString& trainID,
+                             const TrajectoryWriter::Record& record,
+                             const std::vector<int>& exportedColumns);
+
+    /**
+     * @brief Inserts the summary of a train of the run.
+     * @param summary The train summary.
+     * @return true if the summary is inserted.
+     */
+    bool insertTrainSummary(const TrainSummary& summary);
+
+    /**
+     * @brief Commits the inserted rows, creates the indexes and closes the
+     *        database.
+     */
+    void close();
+
+private:
+    /** The name of the database connection */
+    QString connectionName;
+    /** The name of the run */
+    QString runName;
+    /** The prepared trajectory insert */
+    std::unique_ptr<QSqlQuery> trajectoryInsert;
+    /** The prepared train summary insert */
+    std::unique_ptr<QSqlQuery> summaryInsert;
+    /** The number of rows inserted in the open transaction */
+    int transactionRows = 0;
+
+    /**
+     * @brief Executes a statement and reports its error.
+     * @param statement The SQL statement.
+     * @return true if the statement is executed.
+     */
+    bool execute(const QString& statement);
+
+    /**
+     * @brief Counts an inserted row and commits the transaction once it
+     *        holds TransactionRows rows.
+     */
+    void countInsertedRow();
+};
+
+#endif // SQLITERESULTSSTORE_H
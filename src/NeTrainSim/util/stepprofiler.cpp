@@ -0,0 +1,157 @@
+#include "stepprofiler.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+#include <bit>
+
+void StepProfiler::PhaseStats::add(uint64_t ns) {
+    this->count++;
+    this->totalNs += ns;
+    this->minNs = std::min(this->minNs, ns);
+    this->maxNs = std::max(this->maxNs, ns);
+    int bucket = ns == 0 ? 0 : std::bit_width(ns) - 1;
+    this->histogram[std::min(bucket, HistogramBuckets - 1)]++;
+}
+
+void StepProfiler::PhaseStats::merge(const PhaseStats& other) {
+    this->count += other.count;
+    this->totalNs += other.totalNs;
+    this->minNs = std::min(this->minNs, other.minNs);
+    this->maxNs = std::max(this->maxNs, other.maxNs);
+    for (int b = 0; b < HistogramBuckets; b++) {
+        this->histogram[b] += other.histogram[b];
+    }
+}
+
+StepProfiler::StepProfiler() {}
+
+void StepProfiler::setEnabled(bool newEnabled) {
+    this->enabled = newEnabled;
+}
+
+bool StepProfiler::isEnabled() const {
+    return this->enabled;
+}
+
+void StepProfiler::registerTrain(int trainID, const std::string& trainUserID) {
+    if (!this->enabled || trainID < 0) { return; }
+    if (trainID >= static_cast<int>(this->trains.size())) {
+        this->trains.resize(trainID + 1);
+    }
+    TrainStats& train = this->trains[trainID];
+    if (!train.registered) {
+        train.trainUserID = trainUserID;
+        train.registered = true;
+    }
+}
+
+void StepProfiler::countStep() {
+    if (this->enabled) { this->stepsCount++; }
+}
+
+void StepProfiler::record(Phase phase, int trainID, int64_t ns) {
+    if (!this->enabled) { return; }
+    uint64_t duration = ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    if (trainID >= 0 && trainID < static_cast<int>(this->trains.size())) {
+        this->trains[trainID].phases[static_cast<int>(phase)].add(duration);
+    }
+    else {
+        this->stepPhases[static_cast<int>(phase)].add(duration);
+    }
+}
+
+std::string StepProfiler::getPhaseName(Phase phase) {
+    switch (phase) {
+    case Phase::Loading: return "loading";
+    case Phase::LinksData: return "linksData";
+    case Phase::CriticalPoints: return "criticalPoints";
+    case Phase::Dynamics: return "accelerationEnergy";
+    case Phase::Movement: return "movement";
+    case Phase::Signals: return "signals";
+    case Phase::Collision: return "collisionCheck";
+    case Phase::Output: return "output";
+    case Phase::AStarLookAhead: return "aStarLookAhead";
+    }
+    return "unknown";
+}
+
+std::array<StepProfiler::PhaseStats, StepProfiler::PhaseCount>
+StepProfiler::getPhasesStats() const {
+    std::array<PhaseStats, PhaseCount> phases = this->stepPhases;
+    for (const TrainStats& train : this->trains) {
+        for (int p = 0; p < PhaseCount; p++) {
+            phases[p].merge(train.phases[p]);
+        }
+    }
+    return phases;
+}
+
+QJsonObject StepProfiler::toJson(const PhaseStats& stats) {
+    QJsonObject json;
+    json["count"] = static_cast<qint64>(stats.count);
+    json["total_ms"] = stats.totalNs / 1.0e6;
+    json["mean_us"] = stats.count > 0 ?
+        stats.totalNs / 1.0e3 / stats.count : 0.0;
+    json["min_us"] = stats.count > 0 ? stats.minNs / 1.0e3 : 0.0;
+    json["max_us"] = stats.maxNs / 1.0e3;
+
+    // only the buckets that hold durations are written
+    QJsonArray histogram;
+    for (int b = 0; b < HistogramBuckets; b++) {
+        if (stats.histogram[b] == 0) { continue; }
+        QJsonObject bucket;
+        bucket["from_ns"] = static_cast<qint64>(b == 0 ? 0 : 1LL << b);
+        bucket["to_ns"] = static_cast<qint64>(1LL << (b + 1));
+        bucket["count"] = static_cast<qint64>(stats.histogram[b]);
+        histogram.append(bucket);
+    }
+    json["histogram"] = histogram;
+    return json;
+}
+
+QJsonObject StepProfiler::toJson() const {
+    QJsonObject json;
+    json["steps"] = static_cast<qint64>(this->stepsCount);
+
+    std::array<PhaseStats, PhaseCount> phasesStats = this->getPhasesStats();
+    QJsonObject phases;
+    for (int p = 0; p < PhaseCount; p++) {
+        phases[QString::fromStdString(getPhaseName(static_cast<Phase>(p)))] =
+            toJson(phasesStats[p]);
+    }
+    json["phases"] = phases;
+
+    QJsonArray trains;
+    for (const TrainStats& train : this->trains) {
+        if (!train.registered) { continue; }
+        QJsonObject trainPhases;
+        for (int p = 0; p < PhaseCount; p++) {
+            if (train.phases[p].count == 0) { continue; }
+            trainPhases[QString::fromStdString(
+                getPhaseName(static_cast<Phase>(p)))] =
+                toJson(train.phases[p]);
+        }
+        QJsonObject trainJson;
+        trainJson["trainID"] = QString::fromStdString(train.trainUserID);
+        trainJson["phases"] = trainPhases;
+        trains.append(trainJson);
+    }
+    json["trains"] = trains;
+    return json;
+}
+
+bool StepProfiler::writeJson(const QString& filename) const {
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    QJsonDocument document(this->toJson());
+    return file.write(document.toJson()) >= 0;
+}
+
+void StepProfiler::reset() {
+    this->stepsCount = 0;
+    this->stepPhases = {};
+    this->trains.clear();
+}
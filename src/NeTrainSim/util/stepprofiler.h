@@ -0,0 +1,217 @@
+/**
+ * @file StepProfiler.h
+ * @brief This file declares the StepProfiler class that measures the time
+ *        the simulator spends in each phase of a time step.
+ *        The durations are aggregated per phase and per train (count, total,
+ *        min, max and a log2 histogram of the durations) and written as JSON
+ *        at the end of the run.
+ *        A disabled profiler does not read the clock, so the instrumentation
+ *        costs one branch per phase.
+ */
+#ifndef STEPPROFILER_H
+#define STEPPROFILER_H
+
+#include "../export.h"
+#include <QJsonObject>
+#include <QString>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class NETRAINSIMCORE_EXPORT StepProfiler {
+public:
+    /** The profiled phases of a time step */
+    enum class Phase {
+        /** Loading the trains on the network */
+        Loading,
+        /** Fetching the spanned links data */
+        LinksData,
+        /** Assembling the critical points ahead of the train */
+        CriticalPoints,
+        /** Calculating the acceleration, power and energy */
+        Dynamics,
+        /** Moving the train and updating its statistics */
+        Movement,
+        /** Running the network signals */
+        Signals,
+        /** Checking the trains collision */
+        Collision,
+        /** Queuing the trajectory and plotting the trains */
+        Output,
+        /** The A* optimization look-ahead */
+        AStarLookAhead
+    };
+
+    /** (Immutable) the number of profiled phases */
+    static constexpr int PhaseCount = 9;
+    /** (Immutable) the number of log2 buckets of the durations in ns */
+    static constexpr int HistogramBuckets = 48;
+    /** (Immutable) the train ID of the phases that are not per train */
+    static constexpr int NoTrain = -1;
+
+    /** The aggregate durations of a phase */
+    struct PhaseStats {
+        uint64_t count = 0;
+        uint64_t totalNs = 0;
+        uint64_t minNs = UINT64_MAX;
+        uint64_t maxNs = 0;
+        /** bucket b counts the durations in [2^b, 2^(b+1)) ns */
+        std::array<uint64_t, HistogramBuckets> histogram = {};
+
+        /**
+         * @brief Adds a duration.
+         * @param ns The duration in nanoseconds.
+         */
+        void add(uint64_t ns);
+
+        /**
+         * @brief Adds the durations of another aggregate.
+         * @param other The other aggregate.
+         */
+        void merge(const PhaseStats& other);
+    };
+
+    /**
+     * @class Timer
+     * @brief Times consecutive phases of a train or of the whole step. Each
+     *        lap records the time since the previous lap (or since the
+     *        timer was created) to a phase.
+     */
+    class Timer {
+    public:
+        /**
+         * @brief Starts timing.
+         * @param profiler The profiler the laps are recorded to.
+         * @param trainID The simulator ID of the train, or NoTrain.
+         */
+        Timer(StepProfiler& profiler, int trainID = NoTrain)
+            : profiler(profiler), trainID(trainID) {
+            if (profiler.enabled) { this->mark = Clock::now(); }
+        }
+
+        /**
+         * @brief Records the time since the previous lap to a phase.
+         * @param phase The phase.
+         */
+        void lap(Phase phase) {
+            if (!this->profiler.enabled) { return; }
+            Clock::time_point now = Clock::now();
+            this->profiler.record(
+                phase, this->trainID,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    now - this->mark).count());
+            this->mark = now;
+        }
+
+        /**
+         * @brief Restarts timing without recording.
+         */
+        void restart() {
+            if (this->profiler.enabled) { this->mark = Clock::now(); }
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        StepProfiler& profiler;
+        int trainID;
+        Clock::time_point mark;
+    };
+
+    /**
+     * @brief Constructs a disabled profiler.
+     */
+    StepProfiler();
+
+    /**
+     * @brief Enables or disables the profiler.
+     * @param newEnabled True to profile the time steps.
+     */
+    void setEnabled(bool newEnabled);
+
+    /**
+     * @brief Checks if the profiler is enabled.
+     * @return true if the time steps are profiled.
+     */
+    bool isEnabled() const;
+
+    /**
+     * @brief Registers a train so its phases are recorded. It must be
+     *        called before the trains steps are computed in parallel.
+     * @param trainID The simulator ID of the train.
+     * @param trainUserID The user ID of the train.
+     */
+    void registerTrain(int trainID, const std::string& trainUserID);
+
+    /**
+     * @brief Counts a profiled time step.
+     */
+    void countStep();
+
+    /**
+     * @brief Records the duration of a phase. The phases of a train are
+     *        recorded by the thread computing its step only.
+     * @param phase The phase.
+     * @param trainID The simulator ID of the train, or NoTrain.
+     * @param ns The duration in nanoseconds.
+     */
+    void record(Phase phase, int trainID, int64_t ns);
+
+    /**
+     * @brief Gets the name of a phase as written to the JSON file.
+     * @param phase The phase.
+     * @return The phase name.
+     */
+    static std::string getPhaseName(Phase phase);
+
+    /**
+     * @brief Gets the aggregates of the phases over all the trains.
+     * @return The aggregates in the phases order.
+     */
+    std::array<PhaseStats, PhaseCount> getPhasesStats() const;
+
+    /**
+     * @brief Builds the JSON report of the phases and the trains.
+     * @return The JSON report.
+     */
+    QJsonObject toJson() const;
+
+    /**
+     * @brief Writes the JSON report to a file.
+     * @param filename The JSON file path.
+     * @return true if the file is written.
+     */
+    bool writeJson(const QString& filename) const;
+
+    /**
+     * @brief Clears the recorded durations.
+     */
+    void reset();
+
+private:
+    /** The recorded durations of a train */
+    struct TrainStats {
+        std::string trainUserID;
+        bool registered = false;
+        std::array<PhaseStats, PhaseCount> phases;
+    };
+
+    /** True to profile the time steps */
+    bool enabled = false;
+    /** The number of profiled time steps */
+    uint64_t stepsCount = 0;
+    /** The durations of the phases that are not per train */
+    std::array<PhaseStats, PhaseCount> stepPhases;
+    /** The durations per train indexed by the train simulator ID */
+    std::vector<TrainStats> trains;
+
+    /**
+     * @brief Converts a phase aggregate to JSON.
+     * @param stats The aggregate.
+     * @return The JSON object of the aggregate.
+     */
+    static QJsonObject toJson(const PhaseStats& stats);
+};
+
+#endif // STEPPROFILER_H
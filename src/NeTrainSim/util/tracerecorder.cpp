@@ -0,0 +1,181 @@
+#include "tracerecorder.h"
+#include <QCoreApplication>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+// ---------------------------------------------------------------------------
+// Span
+// ---------------------------------------------------------------------------
+
+TraceRecorder::Span::Span(const char* name, const char* category,
+                          const char* argName, double argValue) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    if (!recorder.isEnabled()) { return; }
+    this->event.name = name;
+    this->event.category = category;
+    this->event.argName = argName;
+    this->event.argValue = argValue;
+    this->event.startNs = recorder.now();
+}
+
+TraceRecorder::Span::Span(const std::string& name, const char* category) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    if (!recorder.isEnabled()) { return; }
+    this->event.name = recorder.intern(name);
+    this->event.category = category;
+    this->event.startNs = recorder.now();
+}
+
+TraceRecorder::Span::~Span() {
+    if (this->event.name == nullptr) { return; }
+    TraceRecorder& recorder = TraceRecorder::instance();
+    this->event.durationNs = recorder.now() - this->event.startNs;
+    recorder.record(this->event);
+}
+
+// ---------------------------------------------------------------------------
+// TraceRecorder
+// ---------------------------------------------------------------------------
+
+TraceRecorder::TraceRecorder() : origin(std::chrono::steady_clock::now()) {}
+
+TraceRecorder& TraceRecorder::instance() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+void TraceRecorder::setEnabled(bool newEnabled) {
+    this->enabled.store(newEnabled);
+}
+
+void TraceRecorder::setThreadCapacity(int newCapacity) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->threadCapacity = newCapacity > 0 ? newCapacity :
+                                             DefaultThreadCapacity;
+}
+
+void TraceRecorder::setThreadName(const std::string& name) {
+    ThreadBuffer* buffer = this->getThreadBuffer();
+    std::lock_guard<std::mutex> lock(this->mutex);
+    buffer->name = name;
+}
+
+const char* TraceRecorder::intern(const std::string& name) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    // the set nodes do not move, so the pointers stay valid
+    return this->names.insert(name).first->c_str();
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::getThreadBuffer() {
+    // returns the buffer to the recorder when the thread exits, the buffers
+    // are never freed, so the cached pointer stays valid
+    struct ThreadBufferOwner {
+        ThreadBuffer* buffer = nullptr;
+        ~ThreadBufferOwner() {
+            if (buffer != nullptr) {
+                TraceRecorder::instance().releaseThreadBuffer(buffer);
+            }
+        }
+    };
+    thread_local ThreadBufferOwner owner;
+    if (owner.buffer != nullptr) { return owner.buffer; }
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (!this->freeBuffers.empty()) {
+        owner.buffer = this->freeBuffers.back();
+        this->freeBuffers.pop_back();
+        owner.buffer->name.clear();
+        if (owner.buffer->events.size() !=
+            static_cast<size_t>(this->threadCapacity)) {
+            owner.buffer->count.store(0);
+            owner.buffer->events.assign(this->threadCapacity, Event());
+        }
+        return owner.buffer;
+    }
+    std::unique_ptr<ThreadBuffer> buffer = std::make_unique<ThreadBuffer>();
+    buffer->tid = this->buffers.size() + 1;
+    buffer->events.resize(this->threadCapacity);
+    owner.buffer = buffer.get();
+    this->buffers.push_back(std::move(buffer));
+    return owner.buffer;
+}
+
+void TraceRecorder::releaseThreadBuffer(ThreadBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->freeBuffers.push_back(buffer);
+}
+
+void TraceRecorder::record(const Event& event) {
+    ThreadBuffer* buffer = this->getThreadBuffer();
+    uint64_t count = buffer->count.load(std::memory_order_relaxed);
+    buffer->events[count % buffer->events.size()] = event;
+    buffer->count.store(count + 1, std::memory_order_release);
+}
+
+void TraceRecorder::clear() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (std::unique_ptr<ThreadBuffer>& buffer : this->buffers) {
+        buffer->count.store(0);
+    }
+}
+
+namespace {
+    // writes a JSON string, the names are identifiers but are escaped anyway
+    void writeJsonString(std::ostream& out, const char* text) {
+        out << '"';
+        for (const char* c = text; *c != '\0'; c++) {
+            if (*c == '"' || *c == '\\') { out << '\\' << *c; }
+            else if (static_cast<unsigned char>(*c) < 0x20) { out << ' '; }
+            else { out << *c; }
+        }
+        out << '"';
+    }
+}
+
+bool TraceRecorder::writeJson(const QString& filename) {
+    std::ofstream out(filename.toStdString(),
+                      std::ios::out | std::ios::trunc);
+    if (!out.is_open()) { return false; }
+
+    qint64 pid = QCoreApplication::applicationPid();
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+    bool isFirst = true;
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (const std::unique_ptr<ThreadBuffer>& buffer : this->buffers) {
+        std::string threadName = buffer->name.empty() ?
+            "thread " + std::to_string(buffer->tid) : buffer->name;
+        out << (isFirst ? "" : ",") << "\n{\"name\":\"thread_name\","
+            << "\"ph\":\"M\",\"pid\":" << pid << ",\"tid\":" << buffer->tid
+            << ",\"args\":{\"name\":";
+        writeJsonString(out, threadName.c_str());
+        out << "}}";
+        isFirst = false;
+
+        // the ring keeps the last spans of the thread
+        uint64_t count = buffer->count.load(std::memory_order_acquire);
+        uint64_t capacity = buffer->events.size();
+        uint64_t first = count > capacity ? count - capacity : 0;
+        for (uint64_t i = first; i < count; i++) {
+            const Event& event = buffer->events[i % capacity];
+            out << ",\n{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":";
+            writeJsonString(out, event.category);
+            out << ",\"ph\":\"X\",\"ts\":" << event.startNs / 1000.0
+                << ",\"dur\":" << event.durationNs / 1000.0
+                << ",\"pid\":" << pid << ",\"tid\":" << buffer->tid;
+            if (event.argName != nullptr) {
+                out << ",\"args\":{";
+                writeJsonString(out, event.argName);
+                out << ":" << event.argValue << "}";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,201 @@
+/**
+ * @file TraceRecorder.h
+ * @brief This file declares the TraceRecorder class that records timed
+ *        spans of the simulator, the trajectory writer and the server and
+ *        writes them as a Chrome trace_event JSON file, which opens in
+ *        chrome://tracing or in Perfetto.
+ *        Every thread records to its own ring buffer, so recording a span
+ *        takes no lock; when a buffer is full the oldest spans of that
+ *        thread are overwritten. The buffer of a thread that exits is
+ *        reused by the next thread that records, so the pooled threads
+ *        keep a bounded number of buffers.
+ *        The recorder is disabled by default and a span of a disabled
+ *        recorder does not read the clock.
+ */
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include "../export.h"
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+class NETRAINSIMCORE_EXPORT TraceRecorder {
+public:
+    /** (Immutable) the default number of spans each thread keeps */
+    static constexpr int DefaultThreadCapacity = 1 << 16;
+
+    /** A recorded span */
+    struct Event {
+        /** The span name, a literal or an interned string */
+        const char* name = nullptr;
+        /** The span category, a literal */
+        const char* category = nullptr;
+        /** The name of the span argument, nullptr if it has none */
+        const char* argName = nullptr;
+        /** The value of the span argument */
+        double argValue = 0.0;
+        /** The start of the span in ns since the recorder started */
+        int64_t startNs = 0;
+        /** The duration of the span in ns */
+        int64_t durationNs = 0;
+    };
+
+    /**
+     * @class Span
+     * @brief Records a span from its construction to its destruction.
+     */
+    class NETRAINSIMCORE_EXPORT Span {
+    public:
+        /**
+         * @brief Starts a span if the recorder is enabled.
+         * @param name The span name, it must outlive the recorder.
+         * @param category The span category, it must outlive the recorder.
+         * @param argName The name of the span argument, nullptr for none.
+         * @param argValue The value of the span argument.
+         */
+        Span(const char* name, const char* category,
+             const char* argName = nullptr, double argValue = 0.0);
+
+        /**
+         * @brief Starts a span with a runtime name, interned only if the
+         *        recorder is enabled.
+         * @param name The span name.
+         * @param category The span category, it must outlive the recorder.
+         */
+        Span(const std::string& name, const char* category);
+
+        /**
+         * @brief Ends and records the span.
+         */
+        ~Span();
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+    private:
+        /** The span, its name is nullptr if the recorder was disabled */
+        Event event;
+    };
+
+    /**
+     * @brief Gets the process wide recorder.
+     * @return The recorder.
+     */
+    static TraceRecorder& instance();
+
+    /**
+     * @brief Enables or disables recording.
+     * @param newEnabled True to record the spans.
+     */
+    void setEnabled(bool newEnabled);
+
+    /**
+     * @brief Checks if the spans are recorded.
+     * @return true if the recorder is enabled.
+     */
+    bool isEnabled() const {
+        return this->enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Sets the number of spans each thread keeps. It applies to the
+     *        threads that record their first span after the call.
+     * @param newCapacity The number of spans.
+     */
+    void setThreadCapacity(int newCapacity);
+
+    /**
+     * @brief Names the calling thread in the trace.
+     * @param name The thread name.
+     */
+    void setThreadName(const std::string& name);
+
+    /**
+     * @brief Gets a copy of a string that lives as long as the recorder,
+     *        used as a span name.
+     * @param name The string.
+     * @return The interned string.
+     */
+    const char* intern(const std::string& name);
+
+    /**
+     * @brief Gets the time since the recorder started.
+     * @return The time in ns.
+     */
+    int64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - this->origin).count();
+    }
+
+    /**
+     * @brief Records a span to the ring buffer of the calling thread.
+     * @param event The span.
+     */
+    void record(const Event& event);
+
+    /**
+     * @brief Writes the recorded spans as a Chrome trace_event JSON file.
+     *        The spans being recorded while writing may be missing.
+     * @param filename The JSON file path.
+     * @return true if the file is written.
+     */
+    bool writeJson(const QString& filename);
+
+    /**
+     * @brief Drops the recorded spans.
+     */
+    void clear();
+
+private:
+    /** The spans recorded by a thread */
+    struct ThreadBuffer {
+        /** The thread ID in the trace */
+        int tid = 0;
+        /** The thread name in the trace */
+        std::string name;
+        /** The ring of spans */
+        std::vector<Event> events;
+        /** The number of spans recorded by the thread */
+        std::atomic<uint64_t> count{0};
+    };
+
+    /** True to record the spans */
+    std::atomic<bool> enabled{false};
+    /** The number of spans a new thread buffer keeps */
+    int threadCapacity = DefaultThreadCapacity;
+    /** The time the recorder started */
+    std::chrono::steady_clock::time_point origin;
+    /** Guards the buffers list, the thread names and the interned names */
+    std::mutex mutex;
+    /** The buffers of all the threads that recorded a span */
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    /** The buffers of the exited threads, free to reuse */
+    std::vector<ThreadBuffer*> freeBuffers;
+    /** The interned span names */
+    std::unordered_set<std::string> names;
+
+    TraceRecorder();
+
+    /**
+     * @brief Gets the buffer of the calling thread. On the first call it
+     *        reuses the buffer of an exited thread or creates one.
+     * @return The thread buffer.
+     */
+    ThreadBuffer* getThreadBuffer();
+
+    /**
+     * @brief Returns the buffer of an exiting thread to the free buffers,
+     *        its spans are kept until the next thread overwrites them.
+     * @param buffer The thread buffer.
+     */
+    void releaseThreadBuffer(ThreadBuffer* buffer);
+};
+
+#endif // TRACERECORDER_H
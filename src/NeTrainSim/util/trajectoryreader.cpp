@@ -0,0 +1,208 @@
+#include "trajectoryreader.h"
+#include "error.h"
+#include <cstring>
+#include <stdexcept>
+
+TrajectoryReader::TrajectoryReader() {}
+
+TrajectoryReader::~TrajectoryReader() {
+    this->close();
+}
+
+size_t TrajectoryReader::getColumnSize(uint32_t type, uint32_t rows) {
+    size_t typeSize =
+        type == static_cast<uint32_t>(TrajectoryWriter::ColumnType::Float64) ?
+            8 : 4;
+    return (rows * typeSize + 7) & ~size_t(7);
+}
+
+bool TrajectoryReader::isBinaryTrajectoryFile(const QString& filename) {
+    QFile f(filename);
+    if (!f.open(QIODevice::ReadOnly)) { return false; }
+    return f.read(4) == QByteArray("NTST", 4);
+}
+
+bool TrajectoryReader::open(const QString& filename) {
+    this->close();
+
+    this->file.setFileName(filename);
+    if (!this->file.open(QIODevice::ReadOnly)) { return false; }
+    this->size = this->file.size();
+    if (this->size < static_cast<qint64>(sizeof(TrajectoryWriter::BinaryHeader))) {
+        this->close();
+        return false;
+    }
+    this->data = this->file.map(0, this->size);
+    if (this->data == nullptr) {
+        this->close();
+        return false;
+    }
+
+    // the header
+    TrajectoryWriter::BinaryHeader header;
+    std::memcpy(&header, this->data, sizeof(header));
+    uint64_t columnsEnd = sizeof(header) +
+        uint64_t(header.columnCount) * sizeof(TrajectoryWriter::BinaryColumn);
+    // a file without an index was not closed by the writer
+    if (std::memcmp(header.magic, "NTST", 4) != 0 ||
+        header.version != TrajectoryWriter::BinaryVersion ||
+        header.indexOffset == 0 ||
+        columnsEnd > static_cast<uint64_t>(this->size) ||
+        header.indexOffset + sizeof(TrajectoryWriter::BinaryIndex) >
+            static_cast<uint64_t>(this->size)) {
+        this->close();
+        return false;
+    }
+
+    // the columns description
+    this->columns.resize(header.columnCount);
+    std::memcpy(this->columns.data(), this->data + sizeof(header),
+                header.columnCount * sizeof(TrajectoryWriter::BinaryColumn));
+
+    // the chunks index
+    TrajectoryWriter::BinaryIndex index;
+    const uchar* p = this->data + header.indexOffset;
+    const uchar* end = this->data + this->size;
+    std::memcpy(&index, p, sizeof(index));
+    p += sizeof(index);
+    if (index.chunkCount >
+        uint64_t(end - p) / sizeof(TrajectoryWriter::BinaryChunk)) {
+        this->close();
+        return false;
+    }
+    this->chunks.resize(index.chunkCount);
+    std::memcpy(this->chunks.data(), p,
+                index.chunkCount * sizeof(TrajectoryWriter::BinaryChunk));
+    p += index.chunkCount * sizeof(TrajectoryWriter::BinaryChunk);
+
+    // the train user IDs
+    this->trainIDs.reserve(index.trainCount);
+    for (uint64_t i = 0; i < index.trainCount; i++) {
+        uint32_t length;
+        if (end - p < static_cast<qint64>(sizeof(length))) {
+            this->close();
+            return false;
+        }
+        std::memcpy(&length, p, sizeof(length));
+        p += sizeof(length);
+        if (end - p < static_cast<qint64>(length)) {
+            this->close();
+            return false;
+        }
+        this->trainIDs.emplace_back(reinterpret_cast<const char*>(p), length);
+        p += length;
+    }
+
+    // the chunks are written in the time order of each train
+    for (int i = 0; i < static_cast<int>(this->chunks.size()); i++) {
+        const TrajectoryWriter::BinaryChunk& chunk = this->chunks[i];
+        if (chunk.trainIndex >= this->trainIDs.size()) {
+            this->close();
+            return false;
+        }
+        this->chunksByTrainID[this->trainIDs[chunk.trainIndex]].push_back(i);
+    }
+    return true;
+}
+
+void TrajectoryReader::close() {
+    if (this->data != nullptr) {
+        this->file.unmap(const_cast<uchar*>(this->data));
+        this->data = nullptr;
+    }
+    if (this->file.isOpen()) { this->file.close(); }
+    this->size = 0;
+    this->columns.clear();
+    this->chunks.clear();
+    this->trainIDs.clear();
+    this->chunksByTrainID.clear();
+}
+
+bool TrajectoryReader::isOpen() const {
+    return this->data != nullptr;
+}
+
+const std::vector<std::string>& TrajectoryReader::getTrainIDs() const {
+    return this->trainIDs;
+}
+
+std::vector<std::string> TrajectoryReader::getColumnNames() const {
+    std::vector<std::string> names;
+    names.reserve(this->columns.size());
+    for (const TrajectoryWriter::BinaryColumn& column : this->columns) {
+        names.emplace_back(column.name,
+                           strnlen(column.name, sizeof(column.name)));
+    }
+    return names;
+}
+
+int TrajectoryReader::getColumnIndex(const std::string& name) const {
+    std::vector<std::string> names = this->getColumnNames();
+    for (int i = 0; i < static_cast<int>(names.size()); i++) {
+        if (names[i] == name) { return i; }
+    }
+    return -1;
+}
+
+long long TrajectoryReader::getRowCount(const std::string& trainID) const {
+    auto it = this->chunksByTrainID.find(trainID);
+    if (it == this->chunksByTrainID.end()) { return 0; }
+    long long rows = 0;
+    for (int chunkIndex : it->second) {
+        rows += this->chunks[chunkIndex].rowCount;
+    }
+    return rows;
+}
+
+std::vector<double> TrajectoryReader::readColumn(const std::string& trainID,
+                                                 int column) const {
+    if (column < 0 || column >= static_cast<int>(this->columns.size())) {
+        throw std::runtime_error(std::string("Error: ") +
+                                 std::to_string(static_cast<int>(
+                                     Error::wrongTrajectoryColumn)) +
+                                 "\nThe trajectory file has no column: " +
+                                 std::to_string(column) + "\n");
+    }
+
+    std::vector<double> values;
+    auto it = this->chunksByTrainID.find(trainID);
+    if (it == this->chunksByTrainID.end()) { return values; }
+    values.reserve(this->getRowCount(trainID));
+
+    uint32_t type = this->columns[column].type;
+    for (int chunkIndex : it->second) {
+        const TrajectoryWriter::BinaryChunk& chunk = this->chunks[chunkIndex];
+        // skip the columns before the requested one
+        uint64_t offset = chunk.offset;
+        for (int c = 0; c < column; c++) {
+            offset += getColumnSize(this->columns[c].type, chunk.rowCount);
+        }
+        if (offset + getColumnSize(type, chunk.rowCount) >
+            static_cast<uint64_t>(this->size)) { break; }
+
+        const uchar* p = this->data + offset;
+        for (uint32_t r = 0; r < chunk.rowCount; r++) {
+            if (type == static_cast<uint32_t>(
+                            TrajectoryWriter::ColumnType::Float64)) {
+                double v;
+                std::memcpy(&v, p, sizeof(v));
+                values.push_back(v);
+                p += sizeof(v);
+            }
+            else if (type == static_cast<uint32_t>(
+                                 TrajectoryWriter::ColumnType::Float32)) {
+                float v;
+                std::memcpy(&v, p, sizeof(v));
+                values.push_back(v);
+                p += sizeof(v);
+            }
+            else {
+                int32_t v;
+                std::memcpy(&v, p, sizeof(v));
+                values.push_back(v);
+                p += sizeof(v);
+            }
+        }
+    }
+    return values;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file TrajectoryReader.h
+ * @brief This file declares the TrajectoryReader class that reads the
+ *        columnar binary trajectory files (.ntst) written by the
+ *        TrajectoryWriter.
+ *        The file is memory mapped and only the chunks of the requested
+ *        train and column are read, so a column of one train is extracted
+ *        without parsing the rest of the file.
+ */
+#ifndef TRAJECTORYREADER_H
+#define TRAJECTORYREADER_H
+
+#include "../export.h"
+#include "trajectorywriter.h"
+#include <QFile>
+#include <QString>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class NETRAINSIMCORE_EXPORT TrajectoryReader {
+public:
+    /**
+     * @brief Constructs a closed trajectory reader.
+     */
+    TrajectoryReader();
+
+    /**
+     * @brief Unmaps the file if it is open.
+     */
+    ~TrajectoryReader();
+
+    TrajectoryReader(const TrajectoryReader&) = delete;
+    TrajectoryReader& operator=(const TrajectoryReader&) = delete;
+
+    /**
+     * @brief Maps a binary trajectory file and reads its chunks index.
+     * @param filename The binary trajectory file.
+     * @return true if the file is a complete binary trajectory file, false
+     *         otherwise.
+     */
+    bool open(const QString& filename);
+
+    /**
+     * @brief Unmaps and closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Checks if a file is open.
+     * @return true if a file is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Checks if a file is a binary trajectory file.
+     * @param filename The file to check.
+     * @return true if the file starts with the binary trajectory magic.
+     */
+    static bool isBinaryTrajectoryFile(const QString& filename);
+
+    /**
+     * @brief Gets the user IDs of the trains in the file.
+     * @return The train user IDs in the order they first appear.
+     */
+    const std::vector<std::string>& getTrainIDs() const;
+
+    /**
+     * @brief Gets the names of the columns after the train user ID column.
+     * @return The column names in the file order.
+     */
+    std::vector<std::string> getColumnNames() const;
+
+    /**
+     * @brief Gets the index of a column by its name.
+     * @param name The column name.
+     * @return The column index, -1 if the file has no such column.
+     */
+    int getColumnIndex(const std::string& name) const;
+
+    /**
+     * @brief Gets the number of rows of a train.
+     * @param trainID The train user ID.
+     * @return The number of rows, 0 if the train is not in the file.
+     */
+    long long getRowCount(const std::string& trainID) const;
+
+    /**
+     * @brief Reads a column of a train.
+     * @param trainID The train user ID.
+     * @param column The column index.
+     * @return The column values in the time order, empty if the train is
+     *         not in the file.
+     * @throws std::runtime_error if the column index is out of range.
+     */
+    std::vector<double> readColumn(const std::string& trainID,
+                                   int column) const;
+
+private:
+    /** The mapped file */
+    QFile file;
+    /** The mapped bytes of the file */
+    const uchar* data = nullptr;
+    /** The size of the mapped file */
+    qint64 size = 0;
+    /** The columns description */
+    std::vector<TrajectoryWriter::BinaryColumn> columns;
+    /** The chunks index */
+    std::vector<TrajectoryWriter::BinaryChunk> chunks;
+    /** The train user IDs */
+    std::vector<std::string> trainIDs;
+    /** The chunks of each train in the time order */
+    std::unordered_map<std::string, std::vector<int>> chunksByTrainID;
+
+    /**
+     * @brief Gets the size of a column in a chunk, padded to 8 bytes.
+     * @param type The column type.
+     * @param rows The number of rows in the chunk.
+     * @return The size in bytes.
+     */
+    static size_t getColumnSize(uint32_t type, uint32_t rows);
+};
+
+#endif // TRAJECTORYREADER_H
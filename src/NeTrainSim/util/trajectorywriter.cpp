@@ -0,0 +1,501 @@
+#include "trajectorywriter.h"
+#include "error.h"
+#include "sqliteresultsstore.h"
+#include "tracerecorder.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+TrajectoryWriter::TrajectoryWriter() {}
+
+TrajectoryWriter::~TrajectoryWriter() {
+    this->close();
+}
+
+void TrajectoryWriter::setBufferSize(int newBufferSize) {
+    if (newBufferSize < 1) {
+        newBufferSize = DefaultBufferSize;
+    }
+    this->bufferSize = newBufferSize;
+}
+
+int TrajectoryWriter::getBufferSize() const {
+    return this->bufferSize;
+}
+
+void TrajectoryWriter::setFormat(Format newFormat) {
+    this->format = newFormat;
+}
+
+TrajectoryWriter::Format TrajectoryWriter::getFormat() const {
+    return this->format;
+}
+
+void TrajectoryWriter::setRunName(const std::string& newRunName) {
+    this->runName = newRunName;
+}
+
+void TrajectoryWriter::setCompression(bool newCompression) {
+    this->compression = newCompression;
+}
+
+bool TrajectoryWriter::getCompression() const {
+    return this->compression;
+}
+
+void TrajectoryWriter::setExportConfig(const ExportConfig& newConfig) {
+    const std::vector<Column>& columns = getColumns();
+    for (const std::string& name : newConfig.columns) {
+        bool found = false;
+        for (const Column& column : columns) {
+            if (name == column.name) { found = true; break; }
+        }
+        if (!found) {
+            throw std::runtime_error(std::string("Error: ") +
+                                     std::to_string(static_cast<int>(
+                                         Error::wrongTrajectoryColumn)) +
+                                     "\nUnknown trajectory column: " +
+                                     name + "!\n");
+        }
+    }
+    this->exportConfig = newConfig;
+}
+
+const TrajectoryWriter::ExportConfig&
+TrajectoryWriter::getExportConfig() const {
+    return this->exportConfig;
+}
+
+const std::vector<TrajectoryWriter::Column>& TrajectoryWriter::getColumns() {
+    static const std::vector<Column> columns = {
+        {"TStep_s",                     ColumnType::Float64},
+        {"TravelledDistance_m",         ColumnType::Float64},
+        {"Acceleration_mps2",           ColumnType::Float32},
+        {"Speed_mps",                   ColumnType::Float32},
+        {"LinkMaxSpeed_mps",            ColumnType::Float32},
+        {"EnergyConsumption_KWH",       ColumnType::Float64},
+        {"DelayTimeToEach_s",           ColumnType::Float64},
+        {"DelayTime_s",                 ColumnType::Float64},
+        {"Stoppings",                   ColumnType::Int32},
+        {"tractiveForce_N",             ColumnType::Float32},
+        {"ResistanceForces_N",          ColumnType::Float32},
+        {"CurrentUsedTractivePower_kw", ColumnType::Float32},
+        {"GradeAtTip_Perc",             ColumnType::Float32},
+        {"CurvatureAtTip_Perc",         ColumnType::Float32},
+        {"FirstLocoNotchPosition",      ColumnType::Int32},
+        {"optimizationEnabled",         ColumnType::Int32}
+    };
+    return columns;
+}
+
+double TrajectoryWriter::getColumnValue(const Record& record, int column) {
+    switch (column) {
+    case 0: return record.simulationTime;
+    case 1: return record.travelledDistance;
+    case 2: return record.acceleration;
+    case 3: return record.speed;
+    case 4: return record.linkMaxSpeed;
+    case 5: return record.energyConsumption;
+    case 6: return record.delayTimeToEach;
+    case 7: return record.delayTime;
+    case 8: return record.stoppings;
+    case 9: return record.tractiveForce;
+    case 10: return record.resistanceForces;
+    case 11: return record.usedTractivePower;
+    case 12: return record.grade;
+    case 13: return record.curvature;
+    case 14: return record.firstLocoNotch;
+    case 15: return record.optimizationEnabled;
+    default: return 0.0;
+    }
+}
+
+std::string TrajectoryWriter::getHeader() const {
+    std::string header = "TrainNo";
+    for (int c : this->exportedColumns) {
+        header += ",";
+        header += getColumns()[c].name;
+    }
+    return header + "\n";
+}
+
+std::string TrajectoryWriter::getFileExtension(Format format) {
+    switch (format) {
+    case Format::Binary: return "ntst";
+    case Format::SQLite: return "sqlite";
+    default: return "csv";
+    }
+}
+
+bool TrajectoryWriter::open(const std::string& filename) {
+    this->close();
+
+    this->records.assign(this->bufferSize, Record());
+    this->readCount.store(0);
+    this->writeCount.store(0);
+    this->closing.store(false);
+    this->trainsExportState.clear();
+
+    // the exported columns keep the file order
+    this->exportedColumns.clear();
+    const std::vector<Column>& columns = getColumns();
+    for (int c = 0; c < static_cast<int>(columns.size()); c++) {
+        bool isExported = this->exportConfig.columns.empty();
+        for (const std::string& name : this->exportConfig.columns) {
+            if (name == columns[c].name) { isExported = true; break; }
+        }
+        if (isExported) { this->exportedColumns.push_back(c); }
+    }
+
+    if (this->format == Format::SQLite) {
+        // the database connection belongs to the background thread
+        this->databaseFilename = filename;
+        this->databaseOpened = std::promise<bool>();
+        std::future<bool> isOpened = this->databaseOpened.get_future();
+        this->worker = std::thread(&TrajectoryWriter::run, this);
+        if (!isOpened.get()) {
+            this->worker.join();
+            return false;
+        }
+        return true;
+    }
+
+    if (this->format == Format::CSV && this->compression) {
+        // the compressed blocks are already large writes
+        this->compressedFile.open(filename);
+        if (!this->compressedFile.is_open()) {
+            return false;
+        }
+        this->output = &this->compressedFile;
+    }
+    else {
+        // the buffer has to be set before the file is opened to take effect
+        this->fileBuffer.resize(FileBufferSize);
+        this->file.rdbuf()->pubsetbuf(this->fileBuffer.data(),
+                                      this->fileBuffer.size());
+        std::ios::openmode mode = std::ios::out | std::ios::trunc;
+        if (this->format == Format::Binary) { mode |= std::ios::binary; }
+        this->file.open(filename, mode);
+        if (!this->file.is_open()) {
+            return false;
+        }
+        this->output = &this->file;
+    }
+
+    if (this->format == Format::Binary) {
+        this->fileOffset = 0;
+        this->pendingRows.clear();
+        this->chunks.clear();
+        this->writeBinaryHeader();
+    }
+    else {
+        *this->output << this->getHeader();
+    }
+
+    this->worker = std::thread(&TrajectoryWriter::run, this);
+    return true;
+}
+
+bool TrajectoryWriter::isOpen() const {
+    return this->worker.joinable();
+}
+
+int TrajectoryWriter::registerTrain(const std::string& trainUserID) {
+    auto it = this->trainIndexByUserID.find(trainUserID);
+    if (it != this->trainIndexByUserID.end()) {
+        return it->second;
+    }
+
+    std::lock_guard<std::mutex> lock(this->trainUserIDsMutex);
+    int index = this->trainUserIDs.size();
+    this->trainUserIDs.push_back(trainUserID);
+    this->trainIndexByUserID[trainUserID] = index;
+    return index;
+}
+
+bool TrajectoryWriter::isRecordExported(const Record& record) {
+    if (record.trainIndex >= static_cast<int>(this->trainsExportState.size())) {
+        this->trainsExportState.resize(record.trainIndex + 1);
+    }
+    TrainExportState& state = this->trainsExportState[record.trainIndex];
+
+    int accelerationSign =
+        (record.acceleration > 0.0) - (record.acceleration < 0.0);
+    bool isFirst = !state.seen;
+    bool hasChanged = isFirst || record.firstLocoNotch != state.lastNotch ||
+                      accelerationSign != state.lastAccelerationSign;
+    state.seen = true;
+    state.lastNotch = record.firstLocoNotch;
+    state.lastAccelerationSign = accelerationSign;
+
+    // a small tolerance keeps the rows on the interval despite the
+    // accumulated time step error
+    double interval = this->exportConfig.decimationInterval;
+    bool hasInterval = interval > 0.0;
+    bool isIntervalPassed =
+        isFirst || !hasInterval ||
+        record.simulationTime - state.lastExportTime >=
+            interval - 1e-6 * std::max(1.0, interval);
+
+    bool isExported = isIntervalPassed;
+    if (this->exportConfig.onChangeOnly) {
+        isExported = hasChanged || (hasInterval && isIntervalPassed);
+    }
+    if (isExported) { state.lastExportTime = record.simulationTime; }
+    return isExported;
+}
+
+void TrajectoryWriter::write(const Record& record) {
+    if (!this->isRecordExported(record)) { return; }
+
+    size_t count = this->writeCount.load(std::memory_order_relaxed);
+
+    // backpressure: wait for the background thread to free a slot
+    if (count - this->readCount.load() >= this->records.size()) {
+        TraceRecorder::Span span("trajectoryBackpressure", "output");
+        this->producerWaiting.store(true);
+        std::unique_lock<std::mutex> lock(this->waitMutex);
+        this->waitCondition.wait(lock, [this, count]() {
+            return count - this->readCount.load() < this->records.size();
+        });
+        this->producerWaiting.store(false);
+    }
+
+    this->records[count % this->records.size()] = record;
+    this->writeCount.store(count + 1);
+    this->wake(this->consumerWaiting);
+}
+
+void TrajectoryWriter::close() {
+    if (!this->worker.joinable()) { return; }
+
+    this->closing.store(true);
+    this->wake(this->consumerWaiting);
+    this->worker.join();
+
+    if (this->output == &this->compressedFile) {
+        this->compressedFile.close();
+    }
+    else if (this->file.is_open()) {
+        this->file.close();
+    }
+    this->output = &this->file;
+    this->pendingRows.clear();
+    this->chunks.clear();
+    this->trainIndexByUserID.clear();
+    std::lock_guard<std::mutex> lock(this->trainUserIDsMutex);
+    this->trainUserIDs.clear();
+}
+
+void TrajectoryWriter::wake(const std::atomic<bool>& waiting) {
+    if (waiting.load()) {
+        std::lock_guard<std::mutex> lock(this->waitMutex);
+        this->waitCondition.notify_all();
+    }
+}
+
+void TrajectoryWriter::run() {
+    // a local copy of the train user IDs, refreshed when a new train shows up
+    std::vector<std::string> userIDs;
+
+    if (TraceRecorder::instance().isEnabled()) {
+        TraceRecorder::instance().setThreadName("trajectoryWriter");
+    }
+
+    if (this->format == Format::SQLite) {
+        this->database = std::make_unique<SQLiteResultsStore>();
+        bool isOpened = this->database->open(
+            QString::fromStdString(this->databaseFilename),
+            QString::fromStdString(this->runName));
+        this->databaseOpened.set_value(isOpened);
+        if (!isOpened) {
+            this->database.reset();
+            return;
+        }
+    }
+
+    while (true) {
+        size_t first = this->readCount.load(std::memory_order_relaxed);
+        size_t last = this->writeCount.load();
+
+        if (first == last) {
+            // all the records are written before the closing flag is set
+            if (this->closing.load()) {
+                if (this->writeCount.load() == first) { break; }
+                continue;
+            }
+            this->consumerWaiting.store(true);
+            std::unique_lock<std::mutex> lock(this->waitMutex);
+            this->waitCondition.wait(lock, [this, first]() {
+                return this->writeCount.load() != first ||
+                       this->closing.load();
+            });
+            this->consumerWaiting.store(false);
+            continue;
+        }
+
+        {
+            TraceRecorder::Span span("writeTrajectoryBatch", "output",
+                                     "records", last - first);
+            for (size_t i = first; i != last; i++) {
+                const Record& r = this->records[i % this->records.size()];
+                if (this->format != Format::Binary &&
+                    r.trainIndex >= static_cast<int>(userIDs.size())) {
+                    std::lock_guard<std::mutex> lock(this->trainUserIDsMutex);
+                    userIDs = this->trainUserIDs;
+                }
+                this->writeRecord(r, userIDs);
+            }
+        }
+
+        // free the written slots
+        this->readCount.store(last);
+        this->wake(this->producerWaiting);
+    }
+
+    TraceRecorder::Span span("flushTrajectory", "output");
+    if (this->format == Format::Binary) {
+        {
+            std::lock_guard<std::mutex> lock(this->trainUserIDsMutex);
+            userIDs = this->trainUserIDs;
+        }
+        this->writeBinaryIndex(userIDs);
+    }
+    else if (this->format == Format::SQLite) {
+        this->database->close();
+        this->database.reset();
+        return;
+    }
+    this->output->flush();
+}
+
+void TrajectoryWriter::writeRecord(const Record& record,
+                                   const std::vector<std::string>& userIDs) {
+    switch (this->format) {
+    case Format::Binary:
+        this->addBinaryRow(record);
+        break;
+    case Format::SQLite:
+        this->database->insertTrajectoryRow(
+            QString::fromStdString(userIDs[record.trainIndex]), record,
+            this->exportedColumns);
+        break;
+    default:
+        this->writeCSVRow(record, userIDs[record.trainIndex]);
+        break;
+    }
+}
+
+void TrajectoryWriter::writeCSVRow(const Record& record,
+                                   const std::string& trainUserID) {
+    std::ostream& out = *this->output;
+    out << trainUserID;
+    for (int c : this->exportedColumns) {
+        out << "," << getColumnValue(record, c);
+    }
+    out << "\n";
+}
+
+void TrajectoryWriter::writeBytes(const void* data, size_t size) {
+    this->file.write(static_cast<const char*>(data), size);
+    this->fileOffset += size;
+}
+
+void TrajectoryWriter::writeBinaryHeader() {
+    BinaryHeader header = {};
+    std::memcpy(header.magic, "NTST", 4);
+    header.version = BinaryVersion;
+    header.columnCount = this->exportedColumns.size();
+    header.chunkRows = ChunkRows;
+    header.indexOffset = 0;
+    this->writeBytes(&header, sizeof(header));
+
+    for (int c : this->exportedColumns) {
+        const Column& column = getColumns()[c];
+        BinaryColumn description = {};
+        description.type = static_cast<uint32_t>(column.type);
+        std::strncpy(description.name, column.name,
+                     sizeof(description.name) - 1);
+        this->writeBytes(&description, sizeof(description));
+    }
+}
+
+void TrajectoryWriter::addBinaryRow(const Record& record) {
+    if (record.trainIndex >= static_cast<int>(this->pendingRows.size())) {
+        this->pendingRows.resize(record.trainIndex + 1);
+    }
+    std::vector<Record>& rows = this->pendingRows[record.trainIndex];
+    if (rows.empty()) { rows.reserve(ChunkRows); }
+    rows.push_back(record);
+    if (rows.size() >= static_cast<size_t>(ChunkRows)) {
+        this->writeBinaryChunk(record.trainIndex);
+    }
+}
+
+void TrajectoryWriter::writeBinaryChunk(int trainIndex) {
+    std::vector<Record>& rows = this->pendingRows[trainIndex];
+    if (rows.empty()) { return; }
+
+    BinaryChunk chunk;
+    chunk.trainIndex = trainIndex;
+    chunk.rowCount = rows.size();
+    chunk.offset = this->fileOffset;
+    this->chunks.push_back(chunk);
+
+    // every column is written as one contiguous array
+    std::vector<char> columnBytes;
+    const std::vector<Column>& columns = getColumns();
+    for (int c : this->exportedColumns) {
+        size_t typeSize = columns[c].type == ColumnType::Float64 ? 8 : 4;
+        size_t columnSize = (rows.size() * typeSize + 7) & ~size_t(7);
+        columnBytes.assign(columnSize, 0);
+        char* out = columnBytes.data();
+        for (const Record& row : rows) {
+            double value = getColumnValue(row, c);
+            if (columns[c].type == ColumnType::Float64) {
+                std::memcpy(out, &value, 8);
+            }
+            else if (columns[c].type == ColumnType::Float32) {
+                float v = static_cast<float>(value);
+                std::memcpy(out, &v, 4);
+            }
+            else {
+                int32_t v = static_cast<int32_t>(value);
+                std::memcpy(out, &v, 4);
+            }
+            out += typeSize;
+        }
+        this->writeBytes(columnBytes.data(), columnBytes.size());
+    }
+    rows.clear();
+}
+
+void TrajectoryWriter::writeBinaryIndex(
+    const std::vector<std::string>& userIDs) {
+    for (int i = 0; i < static_cast<int>(this->pendingRows.size()); i++) {
+        this->writeBinaryChunk(i);
+    }
+
+    uint64_t indexOffset = this->fileOffset;
+    BinaryIndex index;
+    index.chunkCount = this->chunks.size();
+    index.trainCount = userIDs.size();
+    this->writeBytes(&index, sizeof(index));
+    if (!this->chunks.empty()) {
+        this->writeBytes(this->chunks.data(),
+                         this->chunks.size() * sizeof(BinaryChunk));
+    }
+    for (const std::string& userID : userIDs) {
+        uint32_t length = userID.size();
+        this->writeBytes(&length, sizeof(length));
+        this->writeBytes(userID.data(), length);
+    }
+
+    // the index offset marks the file as complete
+    this->file.seekp(offsetof(BinaryHeader, indexOffset));
+    this->file.write(reinterpret_cast<const char*>(&indexOffset),
+                     sizeof(indexOffset));
+    this->file.seekp(0, std::ios::end);
+}
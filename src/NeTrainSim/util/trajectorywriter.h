@@ -0,0 +1,452 @@
+/**
+ * @file TrajectoryWriter.h
+ * @brief This file declares the TrajectoryWriter class that writes the
+ *        instantaneous trajectory of the trains to a CSV file, to a
+ *        columnar binary file (.ntst) or to a SQLite database (see
+ *        SQLiteResultsStore).
+ *        The simulator pushes one fixed size record per train step to a
+ *        lock-free queue, the rows skipped by the export configuration are
+ *        dropped right away, and a background thread formats the records and
+ *        writes them to the file in large buffered writes. When the queue is
+ *        full, the simulator waits until the background thread catches up.
+ *
+ *        The binary file starts with a BinaryHeader and a BinaryColumn per
+ *        column, followed by the chunks. A chunk holds up to ChunkRows rows
+ *        of one train stored column after column, each column padded to 8
+ *        bytes. The chunks index (BinaryIndex, BinaryChunk[] then the train
+ *        user IDs as a 32 bit length and the characters) is written at the
+ *        end of the file when the writer is closed.
+ *        The CSV file can be written block compressed (see CompressedFile),
+ *        the compression runs in the background thread too.
+ */
+#ifndef TRAJECTORYWRITER_H
+#define TRAJECTORYWRITER_H
+
+#include "../export.h"
+#include "compressedfile.h"
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+class SQLiteResultsStore; // Forward declaration of SQLiteResultsStore class
+
+class NETRAINSIMCORE_EXPORT TrajectoryWriter {
+public:
+    /** The trajectory file formats */
+    enum class Format {
+        /** A CSV file with one row per train step */
+        CSV,
+        /** A columnar binary file chunked per train */
+        Binary,
+        /** A SQLite database holding the rows of many runs */
+        SQLite
+    };
+
+    /** The types of the binary file columns */
+    enum class ColumnType : uint32_t {
+        Float64 = 0,
+        Float32 = 1,
+        Int32 = 2
+    };
+
+    /** A column of the trajectory file */
+    struct Column {
+        /** The column name in the file header */
+        const char* name;
+        /** The type of the column in the binary file */
+        ColumnType type;
+    };
+
+    /** The trajectory export configuration */
+    struct ExportConfig {
+        /** The names of the exported columns, empty to export all of them.
+         * The train user ID column is always exported. */
+        std::vector<std::string> columns;
+        /** The simulation time in seconds between two exported rows of a
+         * train, 0 to export every time step */
+        double decimationInterval = 0.0;
+        /** True to export a row only when the first locomotive notch or
+         * the acceleration sign of the train changes. If the decimation
+         * interval is set too, a row is also exported once the interval
+         * passes without a change. */
+        bool onChangeOnly = false;
+    };
+
+    /** The header at the start of the binary file */
+    struct BinaryHeader {
+        char magic[4];
+        uint32_t version;
+        uint32_t columnCount;
+        uint32_t chunkRows;
+        /** The file offset of the BinaryIndex, 0 if the file is not closed */
+        uint64_t indexOffset;
+    };
+
+    /** The description of a column in the binary file */
+    struct BinaryColumn {
+        uint32_t type;
+        char name[36];
+    };
+
+    /** The header of the chunks index in the binary file */
+    struct BinaryIndex {
+        uint64_t chunkCount;
+        uint64_t trainCount;
+    };
+
+    /** The index entry of a chunk in the binary file */
+    struct BinaryChunk {
+        uint32_t trainIndex;
+        uint32_t rowCount;
+        /** The file offset of the first column of the chunk */
+        uint64_t offset;
+    };
+
+    /**
+     * @brief The trajectory data of one train in one time step.
+     *
+     * The fields are in the order of the trajectory file columns.
+     */
+    struct Record {
+        /** The index of the train returned by registerTrain */
+        int trainIndex = 0;
+        /** The simulation time of the step */
+        double simulationTime = 0.0;
+        /** The travelled distance of the train */
+        double travelledDistance = 0.0;
+        /** The acceleration of the train */
+        double acceleration = 0.0;
+        /** The speed of the train */
+        double speed = 0.0;
+        /** The free flow speed at the tip of the train */
+        double linkMaxSpeed = 0.0;
+        /** The cumulative energy consumption of the train */
+        double energyConsumption = 0.0;
+        /** The maximum delay time of the train */
+        double delayTimeToEach = 0.0;
+        /** The cumulative delay time of the train */
+        double delayTime = 0.0;
+        /** The number of stoppings of the train */
+        double stoppings = 0.0;
+        /** The tractive force of the train */
+        double tractiveForce = 0.0;
+        /** The resistance forces of the train */
+        double resistanceForces = 0.0;
+        /** The used tractive power of the train */
+        double usedTractivePower = 0.0;
+        /** The grade at the tip of the train */
+        double grade = 0.0;
+        /** The curvature at the tip of the train */
+        double curvature = 0.0;
+        /** The notch position of the first locomotive */
+        int firstLocoNotch = 0;
+        /** True if the train trajectory optimization is enabled */
+        bool optimizationEnabled = false;
+    };
+
+    /** (Immutable) the default number of records the queue holds */
+    static constexpr int DefaultBufferSize = 8192;
+    /** (Immutable) the size in bytes of the file write buffer */
+    static constexpr int FileBufferSize = 1 << 20;
+    /** (Immutable) the maximum number of rows in a binary file chunk */
+    static constexpr int ChunkRows = 4096;
+    /** (Immutable) the version of the binary file format */
+    static constexpr uint32_t BinaryVersion = 1;
+
+    /**
+     * @brief Constructs a closed trajectory writer.
+     */
+    TrajectoryWriter();
+
+    /**
+     * @brief Closes the writer after writing all the queued records.
+     */
+    ~TrajectoryWriter();
+
+    TrajectoryWriter(const TrajectoryWriter&) = delete;
+    TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+    /**
+     * @brief Sets the number of records the queue holds. It takes effect
+     *        the next time the writer is opened.
+     * @param newBufferSize The number of records. Values less than 1 use
+     *                      the default buffer size.
+     */
+    void setBufferSize(int newBufferSize);
+
+    /**
+     * @brief Gets the number of records the queue holds.
+     * @return The number of records.
+     */
+    int getBufferSize() const;
+
+    /**
+     * @brief Sets the format of the trajectory file. It takes effect the
+     *        next time the writer is opened.
+     * @param newFormat The file format.
+     */
+    void setFormat(Format newFormat);
+
+    /**
+     * @brief Gets the format of the trajectory file.
+     * @return The file format.
+     */
+    Format getFormat() const;
+
+    /**
+     * @brief Sets the name of the run the SQLite rows belong to. It takes
+     *        effect the next time the writer is opened.
+     * @param newRunName The run name.
+     */
+    void setRunName(const std::string& newRunName);
+
+    /**
+     * @brief Sets if the CSV file is written block compressed. It takes
+     *        effect the next time the writer is opened. The binary format
+     *        is never compressed.
+     * @param newCompression true to compress the CSV file.
+     */
+    void setCompression(bool newCompression);
+
+    /**
+     * @brief Checks if the CSV file is written block compressed.
+     * @return true if the CSV file is compressed.
+     */
+    bool getCompression() const;
+
+    /**
+     * @brief Sets the export configuration. It takes effect the next time
+     *        the writer is opened.
+     * @param newConfig The export configuration.
+     * @throws std::runtime_error if a column name is not a trajectory
+     *         column.
+     */
+    void setExportConfig(const ExportConfig& newConfig);
+
+    /**
+     * @brief Gets the export configuration.
+     * @return The export configuration.
+     */
+    const ExportConfig& getExportConfig() const;
+
+    /**
+     * @brief Opens the trajectory file, writes the columns header and starts
+     *        the background thread.
+     * @param filename The trajectory file path.
+     * @return true if the file is opened, false otherwise.
+     */
+    bool open(const std::string& filename);
+
+    /**
+     * @brief Checks if the writer is open.
+     * @return true if the writer is open.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Gets the index of a train to use in its records. The train is
+     *        registered the first time it is seen.
+     *
+     * Must be called from the thread that writes the records.
+     *
+     * @param trainUserID The user ID of the train.
+     * @return The index of the train.
+     */
+    int registerTrain(const std::string& trainUserID);
+
+    /**
+     * @brief Queues a record to be written to the file if the export
+     *        configuration keeps it. If the queue is full, waits until the
+     *        background thread frees a slot.
+     *
+     * Must be called from one thread only.
+     *
+     * @param record The record to write.
+     */
+    void write(const Record& record);
+
+    /**
+     * @brief Writes all the queued records, stops the background thread and
+     *        closes the file. Does nothing if the writer is not open.
+     */
+    void close();
+
+    /**
+     * @brief Gets the CSV header line of the exported columns.
+     * @return The columns header, ending with a new line.
+     */
+    std::string getHeader() const;
+
+    /**
+     * @brief Gets the columns of the trajectory file after the train user
+     *        ID column.
+     * @return The columns in the file order.
+     */
+    static const std::vector<Column>& getColumns();
+
+    /**
+     * @brief Gets the file extension of a format.
+     * @param format The file format.
+     * @return The extension without the leading dot.
+     */
+    static std::string getFileExtension(Format format);
+
+    /**
+     * @brief Gets the value of a column in a record.
+     * @param record The record.
+     * @param column The column index in getColumns.
+     * @return The column value.
+     */
+    static double getColumnValue(const Record& record, int column);
+
+private:
+    /** The number of records the queue holds */
+    int bufferSize = DefaultBufferSize;
+    /** The format of the trajectory file */
+    Format format = Format::CSV;
+    /** The name of the run the SQLite rows belong to */
+    std::string runName;
+    /** True to write the CSV file block compressed */
+    bool compression = false;
+    /** The export configuration */
+    ExportConfig exportConfig;
+    /** The indices in getColumns of the exported columns */
+    std::vector<int> exportedColumns;
+
+    /** The export state of a train, used by the simulator only */
+    struct TrainExportState {
+        /** True once the first row of the train is seen */
+        bool seen = false;
+        /** The simulation time of the last exported row */
+        double lastExportTime = 0.0;
+        /** The first locomotive notch of the last row */
+        int lastNotch = 0;
+        /** The acceleration sign of the last row */
+        int lastAccelerationSign = 0;
+    };
+    /** The export state of each train */
+    std::vector<TrainExportState> trainsExportState;
+    /** The queued records */
+    std::vector<Record> records;
+    /** The number of records read by the background thread */
+    alignas(64) std::atomic<size_t> readCount{0};
+    /** The number of records queued by the simulator */
+    alignas(64) std::atomic<size_t> writeCount{0};
+    /** True while the background thread waits for records */
+    std::atomic<bool> consumerWaiting{false};
+    /** True while the simulator waits for a free slot */
+    std::atomic<bool> producerWaiting{false};
+    /** True when the background thread should stop after the queue drains */
+    std::atomic<bool> closing{false};
+    /** Guards the waits of both threads */
+    std::mutex waitMutex;
+    /** Wakes a waiting thread */
+    std::condition_variable waitCondition;
+    /** The background thread */
+    std::thread worker;
+
+    /** The trajectory file */
+    std::ofstream file;
+    /** The block compressed trajectory file */
+    CompressedOFStream compressedFile;
+    /** The stream the CSV rows are written to */
+    std::ostream* output = &file;
+    /** The write buffer of the trajectory file */
+    std::vector<char> fileBuffer;
+    /** The number of bytes written to the binary file */
+    uint64_t fileOffset = 0;
+    /** The rows of each train not written to a binary chunk yet */
+    std::vector<std::vector<Record>> pendingRows;
+    /** The index of the chunks written to the binary file */
+    std::vector<BinaryChunk> chunks;
+    /** The SQLite database, opened in the background thread */
+    std::unique_ptr<SQLiteResultsStore> database;
+    /** The path of the SQLite database */
+    std::string databaseFilename;
+    /** Reports to open if the background thread opened the database */
+    std::promise<bool> databaseOpened;
+
+    /** Maps the train user IDs to their indices, used by the simulator only */
+    std::unordered_map<std::string, int> trainIndexByUserID;
+    /** The registered train user IDs, shared with the background thread */
+    std::vector<std::string> trainUserIDs;
+    /** Guards the trainUserIDs */
+    std::mutex trainUserIDsMutex;
+
+    /**
+     * @brief The background thread loop. Formats the queued records until
+     *        the writer is closed and the queue is empty.
+     */
+    void run();
+
+    /**
+     * @brief Writes a record in the writer format.
+     * @param record The record.
+     * @param userIDs The user IDs of the registered trains.
+     */
+    void writeRecord(const Record& record,
+                     const std::vector<std::string>& userIDs);
+
+    /**
+     * @brief Checks if a record is exported by the export configuration
+     *        and updates the export state of its train.
+     * @param record The record.
+     * @return true if the record is exported.
+     */
+    bool isRecordExported(const Record& record);
+
+    /**
+     * @brief Writes a CSV row of a record.
+     * @param record The record.
+     * @param trainUserID The user ID of the record train.
+     */
+    void writeCSVRow(const Record& record, const std::string& trainUserID);
+
+    /**
+     * @brief Adds a record to its train rows and writes the rows as a chunk
+     *        once they fill one.
+     * @param record The record.
+     */
+    void addBinaryRow(const Record& record);
+
+    /**
+     * @brief Writes the rows of a train as one chunk of the binary file.
+     * @param trainIndex The index of the train.
+     */
+    void writeBinaryChunk(int trainIndex);
+
+    /**
+     * @brief Writes the binary file header and the columns description.
+     */
+    void writeBinaryHeader();
+
+    /**
+     * @brief Writes the remaining chunks and the chunks index, then points
+     *        the header to the index.
+     * @param userIDs The user IDs of the registered trains.
+     */
+    void writeBinaryIndex(const std::vector<std::string>& userIDs);
+
+    /**
+     * @brief Writes raw bytes to the binary file.
+     * @param data The bytes.
+     * @param size The number of bytes.
+     */
+    void writeBytes(const void* data, size_t size);
+
+    /**
+     * @brief Wakes the other thread if it is waiting.
+     * @param waiting The waiting flag of the other thread.
+     */
+    void wake(const std::atomic<bool>& waiting);
+};
+
+#endif // TRAJECTORYWRITER_H
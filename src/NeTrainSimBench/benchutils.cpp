@@ -0,0 +1,50 @@
+#include "benchutils.h"
+#include <QFile>
+#include <QJsonDocument>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+uint64_t BenchUtils::getPeakRSS() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                             sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#ifdef __APPLE__
+    // macOS reports bytes
+    return usage.ru_maxrss;
+#else
+    // Linux reports kilobytes
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+bool BenchUtils::writeJsonReport(const QString& filename,
+                                 const QJsonObject& report) {
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(QJsonDocument(report).toJson()) >= 0;
+}
+
+bool BenchUtils::readJsonReport(const QString& filename,
+                                QJsonObject& report) {
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) { return false; }
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    if (!document.isObject()) { return false; }
+    report = document.object();
+    return true;
+}
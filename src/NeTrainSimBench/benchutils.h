@@ -0,0 +1,39 @@
+/**
+ * @file BenchUtils.h
+ * @brief This file declares the helpers shared by the benchmarks: the
+ *        process memory and the machine readable reports.
+ */
+#ifndef BENCHUTILS_H
+#define BENCHUTILS_H
+
+#include <QJsonObject>
+#include <QString>
+#include <cstdint>
+
+namespace BenchUtils {
+
+/**
+ * @brief Gets the peak resident set size of the process.
+ * @return The peak memory in bytes, 0 if the platform does not report it.
+ */
+uint64_t getPeakRSS();
+
+/**
+ * @brief Writes a JSON report.
+ * @param filename The JSON file path.
+ * @param report The report.
+ * @return true if the file is written.
+ */
+bool writeJsonReport(const QString& filename, const QJsonObject& report);
+
+/**
+ * @brief Reads a JSON report.
+ * @param filename The JSON file path.
+ * @param report The read report.
+ * @return true if the file is read and holds a JSON object.
+ */
+bool readJsonReport(const QString& filename, QJsonObject& report);
+
+}
+
+#endif // BENCHUTILS_H
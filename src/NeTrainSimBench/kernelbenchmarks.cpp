@@ -0,0 +1,242 @@
+#include "kernelbenchmarks.h"
+#include "traindefinition/car.h"
+#include "traindefinition/energyconsumption.h"
+#include "traindefinition/locomotive.h"
+#include "traindefinition/train.h"
+#include "traindefinition/traintypes.h"
+#include <array>
+#include <memory>
+#include <tuple>
+
+namespace {
+
+/** The number of entries of an input table, a power of 2 */
+constexpr uint64_t InputsN = 64;
+/** Maps a call index to an input table entry */
+constexpr uint64_t InputsMask = InputsN - 1;
+
+using Inputs = std::array<double, InputsN>;
+
+/**
+ * @brief Gets a table of values spread evenly over a range.
+ */
+Inputs getRange(double from, double to) {
+    Inputs inputs;
+    for (uint64_t i = 0; i < InputsN; i++) {
+        inputs[i] = from + (to - from) * i / (InputsN - 1);
+    }
+    return inputs;
+}
+
+/** The locomotive power types and their names in the benchmark names */
+const std::pair<TrainTypes::PowerType, const char*> PowerTypes[] = {
+    {TrainTypes::PowerType::diesel, "diesel"},
+    {TrainTypes::PowerType::electric, "electric"},
+    {TrainTypes::PowerType::biodiesel, "biodiesel"},
+    {TrainTypes::PowerType::dieselElectric, "dieselElectric"},
+    {TrainTypes::PowerType::dieselHybrid, "dieselHybrid"},
+    {TrainTypes::PowerType::hydrogenHybrid, "hydrogenHybrid"},
+    {TrainTypes::PowerType::biodieselHybrid, "biodieselHybrid"}
+};
+
+/** The consists of the train benchmarks, locomotives and cars */
+const std::tuple<int, int, const char*> Consists[] = {
+    {1, 20, "1L20C"},
+    {4, 100, "4L100C"}
+};
+
+// the vehicles of the sample project
+std::shared_ptr<Locomotive> makeLocomotive(TrainTypes::PowerType powerType) {
+    return std::make_shared<Locomotive>(4287.774, 0.82, 23.0, 0.0024,
+                                        14.8645, 195.0, 6,
+                                        static_cast<int>(powerType));
+}
+
+std::shared_ptr<Car> makeCar() {
+    return std::make_shared<Car>(17.0, 0.0005, 11.1484, 25.0, 100.0, 4, 0);
+}
+
+std::shared_ptr<Train> makeTrain(int locomotivesCount, int carsCount,
+                                 TrainTypes::PowerType powerType,
+                                 bool optimize) {
+    Vector<std::shared_ptr<Locomotive>> locomotives;
+    for (int i = 0; i < locomotivesCount; i++) {
+        locomotives.push_back(makeLocomotive(powerType));
+    }
+    Vector<std::shared_ptr<Car>> cars;
+    for (int i = 0; i < carsCount; i++) { cars.push_back(makeCar()); }
+    return std::make_shared<Train>(0, "bench", Vector<int>({1, 2}), 0.0,
+                                   0.25, locomotives, cars, optimize);
+}
+
+void addTrainBenchmarks(MicroBenchmark::Suite& suite) {
+    const Inputs speeds = getRange(0.5, 35.0);
+    const Inputs gaps = getRange(100.0, 10000.0);
+    const Inputs leaderSpeeds = getRange(0.0, 20.0);
+    const double freeFlowSpeed = 25.0;
+    const double timeStep = 1.0;
+
+    for (const auto& [locomotivesCount, carsCount, consistName] : Consists) {
+        for (const auto& [powerType, powerTypeName] : PowerTypes) {
+            std::string variant = std::string(consistName) + "/" +
+                                  powerTypeName;
+            std::shared_ptr<Train> train =
+                makeTrain(locomotivesCount, carsCount, powerType, false);
+            std::shared_ptr<Train> optimizedTrain =
+                makeTrain(locomotivesCount, carsCount, powerType, true);
+
+            suite.add("train/getTotalResistance/" + variant,
+                      [train, speeds](uint64_t i) {
+                return train->getTotalResistance(speeds[i & InputsMask]);
+            });
+
+            suite.add("train/accelerate/" + variant,
+                      [train, speeds, gaps, leaderSpeeds, freeFlowSpeed,
+                       timeStep](uint64_t i) {
+                return train->accelerate(
+                    gaps[i & InputsMask], 0.0, speeds[i & InputsMask], 0.1,
+                    leaderSpeeds[i & InputsMask], freeFlowSpeed, timeStep,
+                    false);
+            });
+
+            // a signal, a leading train and a station ahead
+            Vector<double> criticalGaps({1500.0, 4000.0, 20000.0});
+            Vector<bool> criticalGapsTypes({false, true, false});
+            Vector<double> criticalLeaderSpeeds({0.0, 15.0, 0.0});
+            suite.add("train/getStepAcceleration/" + variant,
+                      [train, speeds, freeFlowSpeed, timeStep, criticalGaps,
+                       criticalGapsTypes, criticalLeaderSpeeds](
+                          uint64_t i) mutable {
+                train->currentSpeed = speeds[i & InputsMask];
+                train->currentAcceleration = 0.1;
+                train->previousAcceleration = 0.1;
+                return train->getStepAcceleration(
+                    timeStep, freeFlowSpeed, criticalGaps,
+                    criticalGapsTypes, criticalLeaderSpeeds);
+            });
+
+            // a mild grade under every vehicle
+            int vehiclesCount = locomotivesCount + carsCount;
+            Vector<double> grades(vehiclesCount, 0.005);
+            Vector<double> curvatures(vehiclesCount, 0.0);
+            suite.add("train/AStarOptimization/" + variant,
+                      [optimizedTrain, speeds, gaps, freeFlowSpeed, timeStep,
+                       grades, curvatures](uint64_t i) {
+                double speed = speeds[i & InputsMask];
+                auto [stepSpeed, stepAcceleration, throttle] =
+                    optimizedTrain->AStarOptimization(
+                        speed, speed, 0.1, 0.5, grades, curvatures,
+                        freeFlowSpeed, timeStep, Vector<double>({0.0}),
+                        Vector<double>({gaps[i & InputsMask]}));
+                return stepSpeed + stepAcceleration + throttle;
+            });
+        }
+    }
+}
+
+void addLocomotiveBenchmarks(MicroBenchmark::Suite& suite) {
+    const Inputs speeds = getRange(0.5, 35.0);
+    // braking, idle and traction powers in W
+    const Inputs powers = getRange(-3.0e6, 4.0e6);
+
+    for (const auto& [powerType, powerTypeName] : PowerTypes) {
+        std::shared_ptr<Locomotive> locomotive = makeLocomotive(powerType);
+
+        suite.add(std::string("locomotive/getTractiveForce/") + powerTypeName,
+                  [locomotive, speeds](uint64_t i) {
+            double frictionCoef = 0.25;
+            double speed = speeds[i & InputsMask];
+            bool optimize = false;
+            double throttleLevel = 1.0;
+            return locomotive->getTractiveForce(frictionCoef, speed,
+                                                optimize, throttleLevel);
+        });
+
+        suite.add(std::string("locomotive/getEnergyConsumption/") +
+                      powerTypeName,
+                  [locomotive, speeds, powers](uint64_t i) {
+            double power = powers[i & InputsMask];
+            double acceleration = power >= 0.0 ? 0.1 : -0.2;
+            double speed = speeds[(i * 7) & InputsMask];
+            double timeStep = 1.0;
+            return locomotive->getEnergyConsumption(power, acceleration,
+                                                    speed, timeStep);
+        });
+    }
+}
+
+void addECBenchmarks(MicroBenchmark::Suite& suite) {
+    const Inputs speeds = getRange(0.5, 35.0);
+    const Inputs proportions = getRange(0.0, 1.0);
+    const Inputs energies = getRange(0.0, 5.0);
+
+    for (const auto& [powerType, powerTypeName] : PowerTypes) {
+        TrainTypes::PowerType type = powerType;
+        TrainTypes::LocomotivePowerMethod method =
+            TrainTypes::locomotiveHybrid.exist(type) ?
+                TrainTypes::LocomotivePowerMethod::series :
+                TrainTypes::LocomotivePowerMethod::notApplicable;
+        std::string suffix = std::string("/") + powerTypeName;
+
+        suite.add("EC/getDriveLineEff" + suffix,
+                  [type, method, speeds, proportions](uint64_t i) {
+            double speed = speeds[i & InputsMask];
+            return EC::getDriveLineEff(speed, 8, proportions[i & InputsMask],
+                                       type, method);
+        });
+        suite.add("EC/getDCBusToTankEff" + suffix,
+                  [type, method, proportions](uint64_t i) {
+            return EC::getDCBusToTankEff(proportions[i & InputsMask], type,
+                                         method);
+        });
+        suite.add("EC/getGeneratorEff" + suffix,
+                  [type, proportions](uint64_t i) {
+            return EC::getGeneratorEff(type, proportions[i & InputsMask]);
+        });
+        suite.add("EC/getBatteryEff" + suffix, [type](uint64_t) {
+            return EC::getBatteryEff(type);
+        });
+        suite.add("EC/getMaxEffeciencyRange" + suffix, [type](uint64_t) {
+            std::pair<double, double> range = EC::getMaxEffeciencyRange(type);
+            return range.first + range.second;
+        });
+        suite.add("EC/getLocomotivePowerReductionFactor" + suffix,
+                  [type](uint64_t) {
+            return EC::getLocomotivePowerReductionFactor(type);
+        });
+        suite.add("EC/getFuelFromEC" + suffix,
+                  [type, energies](uint64_t i) {
+            double energy = energies[i & InputsMask];
+            return EC::getFuelFromEC(type, energy);
+        });
+    }
+
+    suite.add("EC/getWheelToDCBusEff", [speeds](uint64_t i) {
+        double speed = speeds[i & InputsMask];
+        return EC::getWheelToDCBusEff(speed);
+    });
+    suite.add("EC/getRequiredGeneratorPowerForRecharge",
+              [proportions](uint64_t i) {
+        return EC::getRequiredGeneratorPowerForRecharge(
+            proportions[i & InputsMask]);
+    });
+    suite.add("EC/getEmissions/diesel", [energies](uint64_t i) {
+        return EC::getEmissions(energies[i & InputsMask], "diesel");
+    });
+    suite.add("EC/getBrakeShoeFriction/castIron", [speeds](uint64_t i) {
+        return EC::getBrakeShoeFriction(speeds[i & InputsMask],
+                                        TrainTypes::BrakeShoeType::castIron);
+    });
+    suite.add("EC/getBrakeShoeFriction/composition", [speeds](uint64_t i) {
+        return EC::getBrakeShoeFriction(
+            speeds[i & InputsMask], TrainTypes::BrakeShoeType::composition);
+    });
+}
+
+}
+
+void KernelBenchmarks::addAll(MicroBenchmark::Suite& suite) {
+    addTrainBenchmarks(suite);
+    addLocomotiveBenchmarks(suite);
+    addECBenchmarks(suite);
+}
@@ -0,0 +1,28 @@
+/**
+ * @file KernelBenchmarks.h
+ * @brief This file declares the micro-benchmarks of the per vehicle
+ *        functions the simulator calls every step: the train dynamics, the
+ *        locomotive tractive force and energy consumption and the EC
+ *        efficiency functions.
+ *        The trains are built directly from locomotives and cars, every
+ *        locomotive power type is covered and the inputs cycle through
+ *        tables of realistic speeds, gaps, powers and grades.
+ */
+#ifndef KERNELBENCHMARKS_H
+#define KERNELBENCHMARKS_H
+
+#include "microbenchmark.h"
+
+namespace KernelBenchmarks {
+
+/**
+ * @brief Adds the kernel benchmarks to a suite. Their names are
+ *        'group/function/variant', e.g.
+ *        'train/getTotalResistance/4L100C/diesel'.
+ * @param suite The suite.
+ */
+void addAll(MicroBenchmark::Suite& suite);
+
+}
+
+#endif // KERNELBENCHMARKS_H
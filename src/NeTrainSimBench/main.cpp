@@ -0,0 +1,223 @@
+#include <QCoreApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include "network/network.h"
+#include "simulator.h"
+#include "traindefinition/trainslist.h"
+#include "benchutils.h"
+#include "scenariogenerator.h"
+#include "VersionConfig.h"
+
+/**
+ * @brief Reads a bool option value.
+ * @param value The option value.
+ * @return true if the value is 'true'.
+ */
+static bool toBool(const QString &value) {
+    bool result = false;
+    std::stringstream ss(value.trimmed().toLower().toStdString());
+    ss >> std::boolalpha >> result;
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("NeTrainSimBench");
+    QCoreApplication::setApplicationVersion(NeTrainSim_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Runs NeTrainSim on a generated network and reports its throughput.");
+    parser.addHelpOption();
+
+    const QCommandLineOption topologyOption(QStringList() << "t" << "topology",
+                                            "[Optional] the network shape, 'grid', 'corridor' or 'hub'. \nDefault is 'grid'.", "topology", "grid");
+    parser.addOption(topologyOption);
+
+    const QCommandLineOption sizeOption(QStringList() << "n" << "size",
+                                        "[Optional] the grid side, the corridor links or the hub spokes. \nDefault is '10'.", "size", "10");
+    parser.addOption(sizeOption);
+
+    const QCommandLineOption linkLengthOption(QStringList() << "l" << "linkLength",
+                                              "[Optional] the length of a link in meters. \nDefault is '1000'.", "linkLength", "1000");
+    parser.addOption(linkLengthOption);
+
+    const QCommandLineOption linkSpeedOption(QStringList() << "v" << "linkSpeed",
+                                             "[Optional] the free flow speed of the links in m/s. \nDefault is '25'.", "linkSpeed", "25");
+    parser.addOption(linkSpeedOption);
+
+    const QCommandLineOption sidingEveryOption(QStringList() << "w" << "sidingEvery",
+                                               "[Optional] the corridor links between two sidings. \nDefault is '5'.", "sidingEvery", "5");
+    parser.addOption(sidingEveryOption);
+
+    const QCommandLineOption spokeSegmentsOption(QStringList() << "k" << "spokeSegments",
+                                                 "[Optional] the links of a hub spoke. \nDefault is '5'.", "spokeSegments", "5");
+    parser.addOption(spokeSegmentsOption);
+
+    const QCommandLineOption signalsOption(QStringList() << "s" << "signals",
+                                           "[Optional] bool to add signals to the network. \nDefault is 'true'.", "signals", "true");
+    parser.addOption(signalsOption);
+
+    const QCommandLineOption trainsOption(QStringList() << "r" << "trains",
+                                          "[Optional] the number of trains. \nDefault is '10'.", "trains", "10");
+    parser.addOption(trainsOption);
+
+    const QCommandLineOption locomotivesOption(QStringList() << "m" << "locomotives",
+                                               "[Optional] the locomotives of a train. \nDefault is '2'.", "locomotives", "2");
+    parser.addOption(locomotivesOption);
+
+    const QCommandLineOption carsOption(QStringList() << "c" << "cars",
+                                        "[Optional] the cars of a train. \nDefault is '50'.", "cars", "50");
+    parser.addOption(carsOption);
+
+    const QCommandLineOption headwayOption(QStringList() << "y" << "headway",
+                                           "[Optional] the seconds between two train departures. \nDefault is '60'.", "headway", "60");
+    parser.addOption(headwayOption);
+
+    const QCommandLineOption seedOption(QStringList() << "d" << "seed",
+                                        "[Optional] the seed of the trains origins and destinations. \nDefault is '1'.", "seed", "1");
+    parser.addOption(seedOption);
+
+    const QCommandLineOption timeStepOption(QStringList() << "p" << "timeStep",
+                                            "[Optional] the simulator time step. \nDefault is '1.0'.", "timeStep", "1.0");
+    parser.addOption(timeStepOption);
+
+    const QCommandLineOption endTimeOption(QStringList() << "e" << "endTime",
+                                           "[Optional] the simulation end time in seconds, 0 runs until all the trains arrive. \nDefault is '0'.", "endTime", "0");
+    parser.addOption(endTimeOption);
+
+    const QCommandLineOption threadsOption(QStringList() << "j" << "threads",
+                                           "[Optional] the number of threads stepping the trains, 0 uses all cores. \nDefault is '1'.", "threads", "1");
+    parser.addOption(threadsOption);
+
+    const QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                          "[Optional] the JSON report file.", "output", "");
+    parser.addOption(outputOption);
+
+    parser.process(app);
+
+    ScenarioGenerator::ScenarioConfig config;
+    if (!ScenarioGenerator::parseTopology(
+            parser.value(topologyOption).trimmed().toLower().toStdString(),
+            config.topology)) {
+        std::cerr << "topology is not valid!\n";
+        return 1;
+    }
+    config.size = parser.value(sizeOption).toInt();
+    config.linkLength = parser.value(linkLengthOption).toDouble();
+    config.linkSpeed = parser.value(linkSpeedOption).toDouble();
+    config.sidingEvery = parser.value(sidingEveryOption).toInt();
+    config.spokeSegments = parser.value(spokeSegmentsOption).toInt();
+    config.withSignals = toBool(parser.value(signalsOption));
+    config.trains = parser.value(trainsOption).toInt();
+    config.locomotives = parser.value(locomotivesOption).toInt();
+    config.cars = parser.value(carsOption).toInt();
+    config.headway = parser.value(headwayOption).toDouble();
+    config.seed = parser.value(seedOption).toUInt();
+    double timeStep = parser.value(timeStepOption).toDouble();
+    double endTime = parser.value(endTimeOption).toDouble();
+    int threadsCount = parser.value(threadsOption).toInt();
+
+    try {
+        // ##################################################################
+        // #                 setup: network, trains, routes                 #
+        // ##################################################################
+        QElapsedTimer setupTimer;
+        setupTimer.start();
+
+        ScenarioGenerator::Scenario scenario =
+            ScenarioGenerator::generate(config);
+        Network *network = new Network(scenario.nodes, scenario.links,
+                                       "NeTrainSimBench");
+        Vector<std::shared_ptr<Train>> trains =
+            TrainsList::generateTrains(scenario.trainRecords, true);
+
+        // the summary file of the run is not kept
+        QTemporaryDir outputDir;
+        Simulator *sim = new Simulator(
+            network, QVector<std::shared_ptr<Train>>(trains.begin(), trains.end()),
+            timeStep);
+        sim->setOutputFolderLocation(outputDir.path().toStdString());
+        sim->setExportInstantaneousTrajectory(false);
+        sim->setThreadsCount(threadsCount);
+        if (endTime > 0.0) { sim->setEndTime(endTime); }
+
+        double setupTime = setupTimer.nsecsElapsed() / 1.0e9;
+
+        // ##################################################################
+        // #                         run: time steps                        #
+        // ##################################################################
+        QElapsedTimer runTimer;
+        runTimer.start();
+        sim->runSimulation(std::numeric_limits<double>::infinity(), true, false);
+        double runTime = runTimer.nsecsElapsed() / 1.0e9;
+
+        unsigned long long steps = sim->getStepsCount();
+        unsigned long long trainSteps = sim->getTrainStepsCount();
+        double stepsPerSecond = runTime > 0.0 ? steps / runTime : 0.0;
+        double trainStepsPerSecond = runTime > 0.0 ? trainSteps / runTime : 0.0;
+        uint64_t peakRSS = BenchUtils::getPeakRSS();
+
+        std::cout << "\n"
+                  << "Scenario            : " << ScenarioGenerator::getTopologyName(config.topology)
+                  << " size " << config.size << ", " << scenario.nodes.size() << " nodes, "
+                  << scenario.links.size() << " links\n"
+                  << "Trains              : " << config.trains << " x (" << config.locomotives
+                  << " locomotives, " << config.cars << " cars)\n"
+                  << "Threads             : " << sim->getThreadsCount() << "\n"
+                  << "Setup time (s)      : " << setupTime << "\n"
+                  << "Run wall time (s)   : " << runTime << "\n"
+                  << "Steps               : " << steps << "\n"
+                  << "Steps/s             : " << stepsPerSecond << "\n"
+                  << "Train-steps         : " << trainSteps << "\n"
+                  << "Train-steps/s       : " << trainStepsPerSecond << "\n"
+                  << "Peak RSS (MB)       : " << peakRSS / (1024.0 * 1024.0) << "\n";
+
+        QString reportFile = parser.value(outputOption);
+        if (!reportFile.isEmpty()) {
+            QJsonObject scenarioJson;
+            scenarioJson["topology"] = QString::fromStdString(
+                ScenarioGenerator::getTopologyName(config.topology));
+            scenarioJson["size"] = config.size;
+            scenarioJson["nodes"] = static_cast<int>(scenario.nodes.size());
+            scenarioJson["links"] = static_cast<int>(scenario.links.size());
+            scenarioJson["linkLength_m"] = config.linkLength;
+            scenarioJson["signals"] = config.withSignals;
+            scenarioJson["trains"] = config.trains;
+            scenarioJson["locomotives"] = config.locomotives;
+            scenarioJson["cars"] = config.cars;
+            scenarioJson["seed"] = static_cast<qint64>(config.seed);
+            scenarioJson["timeStep_s"] = timeStep;
+            scenarioJson["threads"] = sim->getThreadsCount();
+
+            QJsonObject report;
+            report["version"] = NeTrainSim_VERSION;
+            report["scenario"] = scenarioJson;
+            report["setupTime_s"] = setupTime;
+            report["runTime_s"] = runTime;
+            report["steps"] = static_cast<qint64>(steps);
+            report["stepsPerSecond"] = stepsPerSecond;
+            report["trainSteps"] = static_cast<qint64>(trainSteps);
+            report["trainStepsPerSecond"] = trainStepsPerSecond;
+            report["peakRSS_bytes"] = static_cast<qint64>(peakRSS);
+            if (!BenchUtils::writeJsonReport(reportFile, report)) {
+                std::cerr << "Could not write the report file!\n";
+                return 1;
+            }
+        }
+
+        delete sim;
+        delete network;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <QCoreApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QJsonObject>
+#include <iomanip>
+#include <iostream>
+#include "benchutils.h"
+#include "kernelbenchmarks.h"
+#include "microbenchmark.h"
+#include "VersionConfig.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("NeTrainSimMicroBench");
+    QCoreApplication::setApplicationVersion(NeTrainSim_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Times the train dynamics and energy functions in ns per call.");
+    parser.addHelpOption();
+
+    const QCommandLineOption filterOption(QStringList() << "f" << "filter",
+                                          "[Optional] runs only the benchmarks whose name contains the filter, e.g. 'train/' or '4L100C'.", "filter", "");
+    parser.addOption(filterOption);
+
+    const QCommandLineOption batchTimeOption(QStringList() << "t" << "batchTime",
+                                             "[Optional] the minimum time of a timed batch in ms. \nDefault is '20'.", "batchTime", "20");
+    parser.addOption(batchTimeOption);
+
+    const QCommandLineOption repetitionsOption(QStringList() << "r" << "repetitions",
+                                               "[Optional] the number of timed batches, the median is reported. \nDefault is '5'.", "repetitions", "5");
+    parser.addOption(repetitionsOption);
+
+    const QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                          "[Optional] the JSON report file.", "output", "");
+    parser.addOption(outputOption);
+
+    const QCommandLineOption baselineOption(QStringList() << "b" << "baseline",
+                                            "[Optional] a JSON report of another build to compare to.", "baseline", "");
+    parser.addOption(baselineOption);
+
+    parser.process(app);
+
+    MicroBenchmark::Settings settings;
+    settings.filter = parser.value(filterOption).toStdString();
+    settings.minBatchTime = parser.value(batchTimeOption).toDouble() / 1000.0;
+    settings.repetitions = parser.value(repetitionsOption).toInt();
+
+    QJsonObject baselineBenchmarks;
+    QString baselineFile = parser.value(baselineOption);
+    if (!baselineFile.isEmpty()) {
+        QJsonObject baseline;
+        if (!BenchUtils::readJsonReport(baselineFile, baseline)) {
+            std::cerr << "Could not read the baseline file!\n";
+            return 1;
+        }
+        baselineBenchmarks = baseline["benchmarks"].toObject();
+    }
+
+    MicroBenchmark::Suite suite;
+    Vector<MicroBenchmark::Result> results;
+    try {
+        KernelBenchmarks::addAll(suite);
+
+        std::cout << std::left << std::setw(56) << "Benchmark"
+                  << std::right << std::setw(14) << "ns/call"
+                  << std::setw(14) << "min ns/call";
+        if (!baselineBenchmarks.isEmpty()) {
+            std::cout << std::setw(14) << "baseline" << std::setw(10)
+                      << "speedup";
+        }
+        std::cout << "\n" << std::fixed << std::setprecision(2);
+
+        results = suite.run(settings, [&](const MicroBenchmark::Result& r) {
+            std::cout << std::left << std::setw(56) << r.name
+                      << std::right << std::setw(14) << r.nsPerCall
+                      << std::setw(14) << r.minNsPerCall;
+            QJsonObject baseline = baselineBenchmarks[
+                QString::fromStdString(r.name)].toObject();
+            if (baseline.contains("nsPerCall")) {
+                double baselineNs = baseline["nsPerCall"].toDouble();
+                std::cout << std::setw(14) << baselineNs << std::setw(9)
+                          << baselineNs / r.nsPerCall << "x";
+            }
+            std::cout << std::endl;
+        });
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    QString reportFile = parser.value(outputOption);
+    if (!reportFile.isEmpty()) {
+        // one object per benchmark keyed by name, so two reports diff
+        // line by line
+        QJsonObject benchmarks;
+        for (const MicroBenchmark::Result& r : results) {
+            QJsonObject benchmark;
+            benchmark["nsPerCall"] = r.nsPerCall;
+            benchmark["minNsPerCall"] = r.minNsPerCall;
+            benchmark["maxNsPerCall"] = r.maxNsPerCall;
+            benchmark["iterations"] = static_cast<qint64>(r.iterations);
+            benchmark["repetitions"] = r.repetitions;
+            benchmarks[QString::fromStdString(r.name)] = benchmark;
+        }
+        QJsonObject report;
+        report["version"] = NeTrainSim_VERSION;
+        report["batchTime_ms"] = settings.minBatchTime * 1000.0;
+        report["repetitions"] = settings.repetitions;
+        report["benchmarks"] = benchmarks;
+        if (!BenchUtils::writeJsonReport(reportFile, report)) {
+            std::cerr << "Could not write the report file!\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+/**
+ * @file MicroBenchmark.h
+ * @brief This file declares a small harness that times a function in
+ *        nanoseconds per call.
+ *        A benchmark is a function of the call index that returns a
+ *        double; the index lets the benchmark cycle through a table of
+ *        inputs and the returned values are summed so the compiler cannot
+ *        drop the calls. The number of calls of a batch is doubled until
+ *        the batch runs for the minimum batch time, then the batch is
+ *        repeated and the median and the minimum time per call are
+ *        reported.
+ */
+#ifndef MICROBENCHMARK_H
+#define MICROBENCHMARK_H
+
+#include "util/vector.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace MicroBenchmark {
+
+/** The timing settings of the benchmarks */
+struct Settings {
+    /** The minimum time of a batch of calls in seconds */
+    double minBatchTime = 0.02;
+    /** The number of timed batches */
+    int repetitions = 5;
+    /** Only the benchmarks whose name contains it run, empty runs all */
+    std::string filter;
+};
+
+/** The timing of a benchmark */
+struct Result {
+    std::string name;
+    /** The median time of a call over the batches in ns */
+    double nsPerCall = 0.0;
+    /** The minimum time of a call over the batches in ns */
+    double minNsPerCall = 0.0;
+    /** The maximum time of a call over the batches in ns */
+    double maxNsPerCall = 0.0;
+    /** The number of calls of a batch */
+    uint64_t iterations = 0;
+    /** The number of timed batches */
+    int repetitions = 0;
+};
+
+/**
+ * @brief Keeps a value the compiler would otherwise drop.
+ * @param value The value.
+ */
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * @brief Times a function in ns per call.
+ * @param name The benchmark name.
+ * @param func The function, called with the call index.
+ * @param settings The timing settings.
+ * @return The timing.
+ */
+template <typename Func>
+Result measure(const std::string& name, Func& func, const Settings& settings) {
+    using Clock = std::chrono::steady_clock;
+    auto runBatch = [&func](uint64_t iterations) {
+        double sum = 0.0;
+        Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            sum += func(i);
+        }
+        Clock::time_point end = Clock::now();
+        doNotOptimize(sum);
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    };
+
+    // warm up and find the number of calls of a batch
+    uint64_t iterations = 1;
+    double minBatchTime_ns = settings.minBatchTime * 1.0e9;
+    while (runBatch(iterations) < minBatchTime_ns &&
+           iterations < (uint64_t(1) << 40)) {
+        iterations *= 2;
+    }
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = std::max(settings.repetitions, 1);
+    Vector<double> times;
+    for (int r = 0; r < result.repetitions; r++) {
+        times.push_back(runBatch(iterations) / iterations);
+    }
+    std::sort(times.begin(), times.end());
+    result.nsPerCall = times[times.size() / 2];
+    result.minNsPerCall = times.front();
+    result.maxNsPerCall = times.back();
+    return result;
+}
+
+/**
+ * @class Suite
+ * @brief A named list of benchmarks.
+ */
+class Suite {
+public:
+    /**
+     * @brief Adds a benchmark.
+     * @param name The benchmark name, unique in the suite.
+     * @param func The function, called with the call index and returning a
+     *             double.
+     */
+    template <typename Func>
+    void add(const std::string& name, Func func) {
+        // the function is called through the template, not the
+        // std::function, so the timed loop has no indirect call
+        this->benchmarks.push_back(
+            {name, [name, func](const Settings& settings) mutable {
+                 return measure(name, func, settings);
+             }});
+    }
+
+    /**
+     * @brief Runs the benchmarks that pass the filter, in the order they
+     *        were added.
+     * @param settings The timing settings.
+     * @param onResult Called after every benchmark.
+     * @return The timings.
+     */
+    Vector<Result> run(const Settings& settings,
+                       const std::function<void(const Result&)>& onResult) {
+        Vector<Result> results;
+        for (auto& benchmark : this->benchmarks) {
+            if (!settings.filter.empty() &&
+                benchmark.first.find(settings.filter) == std::string::npos) {
+                continue;
+            }
+            results.push_back(benchmark.second(settings));
+            if (onResult) { onResult(results.back()); }
+        }
+        return results;
+    }
+
+private:
+    Vector<std::pair<std::string,
+                     std::function<Result(const Settings&)>>> benchmarks;
+};
+
+}
+
+#endif // MICROBENCHMARK_H
@@ -0,0 +1,434 @@
+#include <QCoreApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include "network/network.h"
+#include "simulator.h"
+#include "traindefinition/trainslist.h"
+#include "benchutils.h"
+#include "resultcomparator.h"
+#include "scenariogenerator.h"
+#include "VersionConfig.h"
+
+namespace {
+
+/** The output files of a case run */
+const QString TrajectoryFilename = "trajectory.csv";
+const QString SummaryFilename = "summary.txt";
+const QString MetricsFilename = "metrics.json";
+
+/** A simulation the harness runs and compares */
+struct RegressionCase {
+    std::string name;
+    /** True to run the sample project files instead of a generated one */
+    bool isSampleProject = false;
+    ScenarioGenerator::ScenarioConfig config;
+};
+
+Vector<RegressionCase> getCases() {
+    Vector<RegressionCase> cases;
+
+    RegressionCase sampleProject;
+    sampleProject.name = "sampleProject";
+    sampleProject.isSampleProject = true;
+    cases.push_back(sampleProject);
+
+    RegressionCase grid;
+    grid.name = "grid";
+    grid.config.topology = ScenarioGenerator::Topology::Grid;
+    grid.config.size = 6;
+    grid.config.trains = 8;
+    grid.config.headway = 120.0;
+    cases.push_back(grid);
+
+    RegressionCase corridor;
+    corridor.name = "corridor";
+    corridor.config.topology = ScenarioGenerator::Topology::Corridor;
+    corridor.config.size = 20;
+    corridor.config.sidingEvery = 5;
+    corridor.config.trains = 6;
+    corridor.config.locomotives = 3;
+    corridor.config.cars = 80;
+    corridor.config.headway = 300.0;
+    cases.push_back(corridor);
+
+    RegressionCase hub;
+    hub.name = "hub";
+    hub.config.topology = ScenarioGenerator::Topology::HubAndSpoke;
+    hub.config.size = 6;
+    hub.config.spokeSegments = 4;
+    hub.config.trains = 8;
+    hub.config.cars = 40;
+    hub.config.headway = 120.0;
+    cases.push_back(hub);
+
+    return cases;
+}
+
+/**
+ * @brief Runs a case and writes its trajectory, summary and metrics. It
+ *        runs in its own process so the peak memory is the case one.
+ * @return The process exit code.
+ */
+int runCase(const RegressionCase& regressionCase, const QString& outputDir,
+            const QString& sampleProjectDir, int threadsCount) {
+    try {
+        QElapsedTimer setupTimer;
+        setupTimer.start();
+
+        Network* network = nullptr;
+        Vector<std::shared_ptr<Train>> trains;
+        if (regressionCase.isSampleProject) {
+            QDir projectDir(sampleProjectDir);
+            network = new Network(
+                projectDir.filePath("nodesFile.dat").toStdString(),
+                projectDir.filePath("linksFile.dat").toStdString(),
+                regressionCase.name);
+            trains = TrainsList::ReadAndGenerateTrains(
+                projectDir.filePath("dieselTrain.dat").toStdString());
+        }
+        else {
+            ScenarioGenerator::Scenario scenario =
+                ScenarioGenerator::generate(regressionCase.config);
+            network = new Network(scenario.nodes, scenario.links,
+                                  regressionCase.name);
+            trains = TrainsList::generateTrains(scenario.trainRecords, true);
+        }
+
+        Simulator* sim = new Simulator(
+            network, QVector<std::shared_ptr<Train>>(trains.begin(), trains.end()));
+        sim->setOutputFolderLocation(outputDir.toStdString());
+        sim->setSummaryFilename(SummaryFilename.toStdString());
+        sim->setExportInstantaneousTrajectory(true,
+                                              TrajectoryFilename.toStdString());
+        sim->setThreadsCount(threadsCount);
+        double setupTime = setupTimer.nsecsElapsed() / 1.0e9;
+
+        QElapsedTimer runTimer;
+        runTimer.start();
+        sim->runSimulation(std::numeric_limits<double>::infinity(), true, false);
+        double runTime = runTimer.nsecsElapsed() / 1.0e9;
+
+        QJsonObject metrics;
+        metrics["setupTime_s"] = setupTime;
+        metrics["runTime_s"] = runTime;
+        metrics["steps"] = static_cast<qint64>(sim->getStepsCount());
+        metrics["trainSteps"] = static_cast<qint64>(sim->getTrainStepsCount());
+        metrics["stepsPerSecond"] = runTime > 0.0 ?
+            sim->getStepsCount() / runTime : 0.0;
+        metrics["trainStepsPerSecond"] = runTime > 0.0 ?
+            sim->getTrainStepsCount() / runTime : 0.0;
+        metrics["peakRSS_bytes"] =
+            static_cast<qint64>(BenchUtils::getPeakRSS());
+
+        delete sim;
+        delete network;
+
+        if (!BenchUtils::writeJsonReport(
+                QDir(outputDir).filePath(MetricsFilename), metrics)) {
+            std::cerr << "Could not write the metrics file!\n";
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Replaces a file by a copy of another.
+ * @return true if the file is copied.
+ */
+bool replaceFile(const QString& source, const QString& destination) {
+    if (QFile::exists(destination) && !QFile::remove(destination)) {
+        return false;
+    }
+    return QFile::copy(source, destination);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("NeTrainSimRegression");
+    QCoreApplication::setApplicationVersion(NeTrainSim_VERSION);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+        "Runs the sample project and generated scenarios, compares their "
+        "trajectories and summaries to a stored baseline and reports the "
+        "speedup and the largest deviation.");
+    parser.addHelpOption();
+
+    const QCommandLineOption baselineOption(QStringList() << "b" << "baseline",
+                                            "[Required] the baseline folder, one sub folder per case.", "baseline");
+    parser.addOption(baselineOption);
+
+    const QCommandLineOption updateOption(QStringList() << "u" << "update",
+                                          "[Optional] bool to record the current outputs as the baseline instead of comparing. \nDefault is 'false'.", "update", "false");
+    parser.addOption(updateOption);
+
+    const QCommandLineOption casesOption(QStringList() << "c" << "cases",
+                                         "[Optional] the comma separated cases to run: sampleProject, grid, corridor, hub. \nDefault is all.", "cases", "");
+    parser.addOption(casesOption);
+
+    const QCommandLineOption sampleProjectOption(QStringList() << "s" << "sampleProject",
+                                                 "[Optional] the sample project folder.", "sampleProject",
+                                                 NETRAINSIM_SAMPLE_PROJECT_DIR);
+    parser.addOption(sampleProjectOption);
+
+    const QCommandLineOption tolerancesOption(QStringList() << "t" << "tolerances",
+                                              "[Optional] a JSON file of the columns tolerances, "
+                                              "{\"default\": {\"abs\": 1e-6, \"rel\": 1e-6}, \"columns\": {\"Speed_mps\": {\"abs\": 1e-3}}}.", "tolerances", "");
+    parser.addOption(tolerancesOption);
+
+    const QCommandLineOption threadsOption(QStringList() << "j" << "threads",
+                                           "[Optional] the number of threads stepping the trains, 0 uses all cores. \nDefault is '1'.", "threads", "1");
+    parser.addOption(threadsOption);
+
+    const QCommandLineOption workDirOption(QStringList() << "w" << "workDir",
+                                           "[Optional] the folder of the current outputs. \nDefault is a temporary folder.", "workDir", "");
+    parser.addOption(workDirOption);
+
+    const QCommandLineOption outputOption(QStringList() << "o" << "output",
+                                          "[Optional] the JSON report file. \nDefault is 'regressionReport.json'.", "output", "regressionReport.json");
+    parser.addOption(outputOption);
+
+    const QCommandLineOption runCaseOption(QStringList() << "runCase",
+                                           "[Internal] runs one case in this process.", "runCase", "");
+    parser.addOption(runCaseOption);
+
+    const QCommandLineOption caseOutputOption(QStringList() << "caseOutput",
+                                              "[Internal] the output folder of --runCase.", "caseOutput", "");
+    parser.addOption(caseOutputOption);
+
+    parser.process(app);
+
+    Vector<RegressionCase> cases = getCases();
+    int threadsCount = parser.value(threadsOption).toInt();
+    QString sampleProjectDir = parser.value(sampleProjectOption);
+
+    // ######################################################################
+    // #                  child process: run a single case                  #
+    // ######################################################################
+    if (parser.isSet(runCaseOption)) {
+        std::string name = parser.value(runCaseOption).toStdString();
+        for (const RegressionCase& regressionCase : cases) {
+            if (regressionCase.name == name) {
+                return runCase(regressionCase, parser.value(caseOutputOption),
+                               sampleProjectDir, threadsCount);
+            }
+        }
+        std::cerr << "Unknown case " << name << "!\n";
+        return 1;
+    }
+
+    // ######################################################################
+    // #                 parent process: run and compare                    #
+    // ######################################################################
+    if (!parser.isSet(baselineOption)) {
+        std::cerr << "The baseline folder is required!\n";
+        parser.showHelp(1);
+    }
+    QDir baselineDir(parser.value(baselineOption));
+    bool update = parser.value(updateOption).trimmed().toLower() == "true";
+
+    QStringList selectedCases;
+    for (const QString& name : parser.value(casesOption).split(
+             ",", Qt::SkipEmptyParts)) {
+        selectedCases.append(name.trimmed());
+    }
+    for (const QString& name : selectedCases) {
+        bool isCase = false;
+        for (const RegressionCase& c : cases) {
+            isCase = isCase || QString::fromStdString(c.name) == name;
+        }
+        if (!isCase) {
+            std::cerr << "Unknown case " << name.toStdString() << "!\n";
+            return 1;
+        }
+    }
+
+    ResultComparator::Tolerances tolerances;
+    QString tolerancesFile = parser.value(tolerancesOption);
+    if (!tolerancesFile.isEmpty()) {
+        QJsonObject tolerancesJson;
+        if (!BenchUtils::readJsonReport(tolerancesFile, tolerancesJson)) {
+            std::cerr << "Could not read the tolerances file!\n";
+            return 1;
+        }
+        tolerances.read(tolerancesJson);
+    }
+
+    QTemporaryDir temporaryDir;
+    QDir workDir(parser.value(workDirOption).isEmpty() ?
+                     temporaryDir.path() : parser.value(workDirOption));
+
+    std::cout << std::left << std::setw(16) << "Case" << std::right
+              << std::setw(11) << "run (s)" << std::setw(11) << "base (s)"
+              << std::setw(10) << "speedup" << std::setw(15)
+              << "train-steps/s" << std::setw(11) << "peak (MB)"
+              << "  " << std::left << std::setw(40) << "max deviation"
+              << "result\n" << std::fixed;
+
+    QJsonObject casesJson;
+    bool allPassed = true;
+    double logSpeedupSum = 0.0;
+    int speedupsCount = 0;
+    std::string maxDeviationCase;
+    ResultComparator::ColumnDeviation maxDeviation;
+
+    for (const RegressionCase& regressionCase : cases) {
+        QString name = QString::fromStdString(regressionCase.name);
+        if (!selectedCases.isEmpty() && !selectedCases.contains(name)) {
+            continue;
+        }
+        QJsonObject caseJson;
+        std::string error;
+        QString caseDir = workDir.filePath(name);
+        QDir(caseDir).removeRecursively();
+        workDir.mkpath(name);
+
+        // run the case in a child process
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(QCoreApplication::applicationFilePath(),
+                      QStringList() << "--runCase" << name
+                                    << "--caseOutput" << caseDir
+                                    << "--sampleProject" << sampleProjectDir
+                                    << "--threads" << QString::number(threadsCount));
+        process.waitForFinished(-1);
+        QJsonObject metrics;
+        if (process.exitStatus() != QProcess::NormalExit ||
+            process.exitCode() != 0) {
+            error = "The case run failed!";
+        }
+        else if (!BenchUtils::readJsonReport(
+                     QDir(caseDir).filePath(MetricsFilename), metrics)) {
+            error = "The case metrics could not be read!";
+        }
+        caseJson["metrics"] = metrics;
+
+        QString caseBaselineDir = baselineDir.filePath(name);
+        double speedup = 0.0;
+        double baselineRunTime = 0.0;
+        bool passed = error.empty();
+        std::string deviationText;
+        if (passed && update) {
+            // record the outputs as the new baseline
+            baselineDir.mkpath(name);
+            for (const QString& file : {TrajectoryFilename, SummaryFilename,
+                                        MetricsFilename}) {
+                if (!replaceFile(QDir(caseDir).filePath(file),
+                                 QDir(caseBaselineDir).filePath(file))) {
+                    error = "The baseline could not be written!";
+                    passed = false;
+                }
+            }
+            deviationText = "recorded";
+        }
+        else if (passed) {
+            QJsonObject baselineMetrics;
+            if (BenchUtils::readJsonReport(
+                    QDir(caseBaselineDir).filePath(MetricsFilename),
+                    baselineMetrics)) {
+                baselineRunTime = baselineMetrics["runTime_s"].toDouble();
+                double runTime = metrics["runTime_s"].toDouble();
+                speedup = runTime > 0.0 ? baselineRunTime / runTime : 0.0;
+                caseJson["baselineMetrics"] = baselineMetrics;
+                caseJson["speedup"] = speedup;
+                if (speedup > 0.0) {
+                    logSpeedupSum += std::log(speedup);
+                    speedupsCount++;
+                }
+            }
+
+            ResultComparator::Comparison trajectory =
+                ResultComparator::compareTrajectories(
+                    QDir(caseBaselineDir).filePath(TrajectoryFilename),
+                    QDir(caseDir).filePath(TrajectoryFilename), tolerances);
+            ResultComparator::Comparison summary =
+                ResultComparator::compareSummaries(
+                    QDir(caseBaselineDir).filePath(SummaryFilename),
+                    QDir(caseDir).filePath(SummaryFilename), tolerances);
+            caseJson["trajectory"] = trajectory.toJson();
+            caseJson["summary"] = summary.toJson();
+            passed = trajectory.passed && summary.passed;
+            if (!trajectory.error.empty()) { error = trajectory.error; }
+            else if (!summary.error.empty()) { error = summary.error; }
+
+            ResultComparator::ColumnDeviation caseDeviation =
+                trajectory.getMaxDeviation();
+            std::stringstream ss;
+            ss << std::scientific << std::setprecision(2)
+               << caseDeviation.column << " " << caseDeviation.maxRel;
+            deviationText = ss.str();
+            if (caseDeviation.maxRel > maxDeviation.maxRel ||
+                maxDeviationCase.empty()) {
+                maxDeviation = caseDeviation;
+                maxDeviationCase = regressionCase.name;
+            }
+        }
+        caseJson["passed"] = passed;
+        caseJson["error"] = QString::fromStdString(error);
+        casesJson[name] = caseJson;
+        allPassed = allPassed && passed;
+
+        std::cout << std::left << std::setw(16) << regressionCase.name
+                  << std::right << std::setprecision(3)
+                  << std::setw(11) << metrics["runTime_s"].toDouble()
+                  << std::setw(11) << baselineRunTime
+                  << std::setw(9) << speedup << "x"
+                  << std::setw(15) << std::setprecision(0)
+                  << metrics["trainStepsPerSecond"].toDouble()
+                  << std::setw(11) << std::setprecision(1)
+                  << metrics["peakRSS_bytes"].toDouble() / (1024.0 * 1024.0)
+                  << "  " << std::left << std::setw(40) << deviationText
+                  << (passed ? "PASS" : "FAIL") << std::endl;
+        if (!error.empty()) { std::cout << "    " << error << std::endl; }
+    }
+
+    QJsonObject report;
+    report["version"] = NeTrainSim_VERSION;
+    report["baseline"] = baselineDir.absolutePath();
+    report["updated"] = update;
+    report["passed"] = allPassed;
+    report["cases"] = casesJson;
+    if (speedupsCount > 0) {
+        double geomeanSpeedup = std::exp(logSpeedupSum / speedupsCount);
+        report["geomeanSpeedup"] = geomeanSpeedup;
+        std::cout << "\nGeometric mean speedup: " << std::setprecision(3)
+                  << geomeanSpeedup << "x\n";
+    }
+    if (!maxDeviationCase.empty()) {
+        QJsonObject maxDeviationJson;
+        maxDeviationJson["case"] = QString::fromStdString(maxDeviationCase);
+        maxDeviationJson["column"] = QString::fromStdString(maxDeviation.column);
+        maxDeviationJson["maxAbs"] = maxDeviation.maxAbs;
+        maxDeviationJson["maxRel"] = maxDeviation.maxRel;
+        report["maxDeviation"] = maxDeviationJson;
+        std::cout << "Max trajectory deviation: " << maxDeviation.column
+                  << " in " << maxDeviationCase << ", abs "
+                  << std::scientific << maxDeviation.maxAbs << ", rel "
+                  << maxDeviation.maxRel << "\n";
+    }
+    std::cout << (allPassed ? "PASSED" : "FAILED") << std::endl;
+
+    if (!BenchUtils::writeJsonReport(parser.value(outputOption), report)) {
+        std::cerr << "Could not write the report file!\n";
+        return 1;
+    }
+    return allPassed ? 0 : 2;
+}
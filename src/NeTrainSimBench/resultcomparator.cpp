@@ -0,0 +1,309 @@
+#include "resultcomparator.h"
+#include <QJsonValue>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+
+namespace {
+
+/**
+ * @brief Splits a CSV line, the trajectory values hold no quotes.
+ */
+void splitLine(const std::string& line, Vector<std::string>& fields) {
+    fields.clear();
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find(',', start);
+        if (end == std::string::npos) {
+            std::string last = line.substr(start);
+            if (!last.empty() && last.back() == '\r') { last.pop_back(); }
+            fields.push_back(last);
+            return;
+        }
+        fields.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) { return ""; }
+    size_t last = text.find_last_not_of(" \t\r\n");
+    return text.substr(first, last - first + 1);
+}
+
+/**
+ * @brief Parses a number, the thousands separators are dropped.
+ * @return true if the whole text is a number.
+ */
+bool parseNumber(const std::string& text, double& value) {
+    std::string digits;
+    for (char c : text) { if (c != ',') { digits.push_back(c); } }
+    if (digits.empty()) { return false; }
+    char* end = nullptr;
+    value = std::strtod(digits.c_str(), &end);
+    return end != nullptr && *end == '\0';
+}
+
+/**
+ * @brief Adds a value pair to the deviation of its column.
+ * @return true if the value is within the tolerance.
+ */
+bool compareValue(double baseline, double current,
+                  const ResultComparator::Tolerance& tolerance,
+                  ResultComparator::ColumnDeviation& deviation) {
+    if (std::isnan(baseline) && std::isnan(current)) { return true; }
+    double difference = std::abs(current - baseline);
+    double allowed = tolerance.abs + tolerance.rel * std::abs(baseline);
+    // the relative deviation is only defined for a non zero baseline
+    double relative = baseline != 0.0 ? difference / std::abs(baseline) : 0.0;
+    deviation.maxAbs = std::max(deviation.maxAbs, difference);
+    deviation.maxRel = std::max(deviation.maxRel, relative);
+    bool passed = difference <= allowed;
+    if (!passed) { deviation.failures++; }
+    return passed;
+}
+
+/** A JSON number that is always finite */
+QJsonValue toJsonNumber(double value) {
+    return std::isfinite(value) ? QJsonValue(value) : QJsonValue(-1.0);
+}
+
+}
+
+// ---------------------------------------------------------------------------
+// Tolerances
+// ---------------------------------------------------------------------------
+
+ResultComparator::Tolerances::Tolerances() {
+    // the time steps and the counters do not drift, they are exact
+    this->columns["TStep_s"] = Tolerance{1.0e-9, 0.0};
+    this->columns["Stoppings"] = Tolerance{0.0, 0.0};
+    this->columns["FirstLocoNotchPosition"] = Tolerance{0.0, 0.0};
+    this->columns["optimizationEnabled"] = Tolerance{0.0, 0.0};
+}
+
+void ResultComparator::Tolerances::read(const QJsonObject& json) {
+    auto readTolerance = [](const QJsonObject& object, Tolerance fallback) {
+        Tolerance tolerance = fallback;
+        tolerance.abs = object["abs"].toDouble(fallback.abs);
+        tolerance.rel = object["rel"].toDouble(fallback.rel);
+        return tolerance;
+    };
+    if (json.contains("default")) {
+        this->defaultTolerance = readTolerance(json["default"].toObject(),
+                                               this->defaultTolerance);
+    }
+    QJsonObject columnsJson = json["columns"].toObject();
+    for (auto it = columnsJson.begin(); it != columnsJson.end(); ++it) {
+        this->columns[it.key().toStdString()] =
+            readTolerance(it.value().toObject(), this->defaultTolerance);
+    }
+}
+
+ResultComparator::Tolerance ResultComparator::Tolerances::get(
+    const std::string& column) const {
+    auto it = this->columns.find(column);
+    return it != this->columns.end() ? it->second : this->defaultTolerance;
+}
+
+// ---------------------------------------------------------------------------
+// Comparison
+// ---------------------------------------------------------------------------
+
+ResultComparator::ColumnDeviation
+ResultComparator::Comparison::getMaxDeviation() const {
+    ColumnDeviation maxDeviation;
+    for (const ColumnDeviation& deviation : this->columns) {
+        if (deviation.failures > maxDeviation.failures ||
+            (deviation.failures == maxDeviation.failures &&
+             deviation.maxRel > maxDeviation.maxRel) ||
+            maxDeviation.column.empty()) {
+            maxDeviation = deviation;
+        }
+    }
+    return maxDeviation;
+}
+
+QJsonObject ResultComparator::Comparison::toJson() const {
+    QJsonObject columnsJson;
+    for (const ColumnDeviation& deviation : this->columns) {
+        QJsonObject columnJson;
+        columnJson["maxAbs"] = toJsonNumber(deviation.maxAbs);
+        columnJson["maxRel"] = toJsonNumber(deviation.maxRel);
+        columnJson["failures"] = deviation.failures;
+        columnsJson[QString::fromStdString(deviation.column)] = columnJson;
+    }
+    QJsonObject json;
+    json["passed"] = this->passed;
+    json["error"] = QString::fromStdString(this->error);
+    json["compared"] = this->compared;
+    json["columns"] = columnsJson;
+    return json;
+}
+
+// ---------------------------------------------------------------------------
+// comparisons
+// ---------------------------------------------------------------------------
+
+ResultComparator::Comparison ResultComparator::compareTrajectories(
+    const QString& baselineFile, const QString& currentFile,
+    const Tolerances& tolerances) {
+    Comparison comparison;
+    std::ifstream baseline(baselineFile.toStdString());
+    std::ifstream current(currentFile.toStdString());
+    if (!baseline.is_open() || !current.is_open()) {
+        comparison.passed = false;
+        comparison.error = "The trajectory files could not be opened!";
+        return comparison;
+    }
+
+    // match the baseline columns to the current ones by name
+    std::string baselineLine, currentLine;
+    Vector<std::string> baselineFields, currentFields;
+    std::getline(baseline, baselineLine);
+    std::getline(current, currentLine);
+    splitLine(baselineLine, baselineFields);
+    splitLine(currentLine, currentFields);
+    Vector<std::pair<int, int>> columnPairs;
+    Vector<Tolerance> columnTolerances;
+    int trainColumn = -1, timeColumn = -1;
+    for (int b = 0; b < baselineFields.size(); b++) {
+        int c = currentFields.index(baselineFields[b]);
+        if (c < 0) {
+            comparison.passed = false;
+            comparison.error = "The column " + baselineFields[b] +
+                               " is not in the current trajectory!";
+            return comparison;
+        }
+        if (baselineFields[b] == "TrainNo") { trainColumn = columnPairs.size(); }
+        else if (baselineFields[b] == "TStep_s") { timeColumn = columnPairs.size(); }
+        columnPairs.push_back({b, c});
+        columnTolerances.push_back(tolerances.get(baselineFields[b]));
+        ColumnDeviation deviation;
+        deviation.column = baselineFields[b];
+        comparison.columns.push_back(deviation);
+    }
+
+    long long row = 0;
+    while (true) {
+        bool hasBaseline = static_cast<bool>(std::getline(baseline, baselineLine));
+        bool hasCurrent = static_cast<bool>(std::getline(current, currentLine));
+        if (!hasBaseline || !hasCurrent) {
+            if (hasBaseline != hasCurrent) {
+                long long baselineRows = row + (hasBaseline ? 1 : 0);
+                long long currentRows = row + (hasCurrent ? 1 : 0);
+                std::string line;
+                while (std::getline(hasBaseline ? baseline : current, line)) {
+                    (hasBaseline ? baselineRows : currentRows)++;
+                }
+                comparison.passed = false;
+                comparison.error = "The trajectories have " +
+                                   std::to_string(baselineRows) + " and " +
+                                   std::to_string(currentRows) + " rows!";
+            }
+            break;
+        }
+        if (baselineLine.empty() && currentLine.empty()) { continue; }
+        row++;
+        splitLine(baselineLine, baselineFields);
+        splitLine(currentLine, currentFields);
+
+        // the rows must be of the same train at the same time, otherwise
+        // the following rows cannot be compared
+        bool sameRow = true;
+        for (int p = 0; p < columnPairs.size(); p++) {
+            auto [b, c] = columnPairs[p];
+            if (b >= baselineFields.size() || c >= currentFields.size()) {
+                sameRow = false;
+                break;
+            }
+            double baselineValue = 0.0, currentValue = 0.0;
+            if (!parseNumber(baselineFields[b], baselineValue) ||
+                !parseNumber(currentFields[c], currentValue)) {
+                if (baselineFields[b] != currentFields[c]) {
+                    comparison.columns[p].failures++;
+                    comparison.passed = false;
+                    if (p == trainColumn) { sameRow = false; }
+                }
+                continue;
+            }
+            if (!compareValue(baselineValue, currentValue,
+                              columnTolerances[p], comparison.columns[p])) {
+                comparison.passed = false;
+                if (p == trainColumn || p == timeColumn) { sameRow = false; }
+            }
+        }
+        if (!sameRow) {
+            comparison.passed = false;
+            comparison.error = "The trajectories are out of step at row " +
+                               std::to_string(row) + "!";
+            break;
+        }
+    }
+    comparison.compared = row;
+    return comparison;
+}
+
+ResultComparator::Comparison ResultComparator::compareSummaries(
+    const QString& baselineFile, const QString& currentFile,
+    const Tolerances& tolerances) {
+    // reads the 'label : value' lines, a repeated label gets a '#n' suffix
+    auto readValues = [](const QString& filename, bool& isRead) {
+        Vector<std::pair<std::string, std::string>> values;
+        std::map<std::string, int> labelsCount;
+        std::ifstream file(filename.toStdString());
+        isRead = file.is_open();
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t separator = line.find(" : ");
+            if (separator == std::string::npos) { continue; }
+            std::string label = trim(line.substr(0, separator));
+            if (label.rfind("|_", 0) == 0) { label = trim(label.substr(2)); }
+            int count = ++labelsCount[label];
+            if (count > 1) { label += " #" + std::to_string(count); }
+            values.push_back({label, trim(line.substr(separator + 3))});
+        }
+        return values;
+    };
+
+    Comparison comparison;
+    bool isBaselineRead = false, isCurrentRead = false;
+    Vector<std::pair<std::string, std::string>> baselineValues =
+        readValues(baselineFile, isBaselineRead);
+    Vector<std::pair<std::string, std::string>> currentValues =
+        readValues(currentFile, isCurrentRead);
+    if (!isBaselineRead || !isCurrentRead) {
+        comparison.passed = false;
+        comparison.error = "The summary files could not be opened!";
+        return comparison;
+    }
+
+    std::map<std::string, std::string> currentByLabel(currentValues.begin(),
+                                                      currentValues.end());
+    for (const auto& [label, baselineText] : baselineValues) {
+        ColumnDeviation deviation;
+        deviation.column = label;
+        auto it = currentByLabel.find(label);
+        if (it == currentByLabel.end()) {
+            deviation.failures++;
+            comparison.error = "The summary value '" + label +
+                               "' is not in the current summary!";
+        }
+        else {
+            double baselineValue = 0.0, currentValue = 0.0;
+            if (parseNumber(baselineText, baselineValue) &&
+                parseNumber(it->second, currentValue)) {
+                compareValue(baselineValue, currentValue,
+                             tolerances.get(label), deviation);
+            }
+            else if (baselineText != it->second) {
+                deviation.failures++;
+            }
+        }
+        if (deviation.failures > 0) { comparison.passed = false; }
+        comparison.compared++;
+        comparison.columns.push_back(deviation);
+    }
+    return comparison;
+}
@@ -0,0 +1,124 @@
+/**
+ * @file ResultComparator.h
+ * @brief This file declares the comparison of the outputs of two
+ *        simulation runs, used to check that a faster build still gives
+ *        the same results.
+ *        The trajectory CSV files are compared row by row; the rows must
+ *        be of the same train and time step and every common numeric
+ *        column must agree within its tolerance. The summary files are
+ *        compared value by value, the values are keyed by their label.
+ *        A value passes if |current - baseline| <= abs + rel * |baseline|.
+ */
+#ifndef RESULTCOMPARATOR_H
+#define RESULTCOMPARATOR_H
+
+#include "util/vector.h"
+#include <QJsonObject>
+#include <QString>
+#include <map>
+#include <string>
+
+namespace ResultComparator {
+
+/** The allowed deviation of a value */
+struct Tolerance {
+    double abs = 1.0e-6;
+    double rel = 1.0e-6;
+};
+
+/**
+ * @class Tolerances
+ * @brief The tolerance of every column, the default one if a column has
+ *        none.
+ */
+class Tolerances {
+public:
+    /**
+     * @brief Creates the tolerances of the trajectory columns: the time
+     *        and the counters are exact, the others use the default.
+     */
+    Tolerances();
+
+    /**
+     * @brief Reads tolerances from a JSON object of the form
+     *        {"default": {"abs": 1e-6, "rel": 1e-6},
+     *         "columns": {"Speed_mps": {"abs": 1e-3, "rel": 0}}}.
+     *        The read tolerances replace the current ones.
+     * @param json The JSON object.
+     */
+    void read(const QJsonObject& json);
+
+    /**
+     * @brief Gets the tolerance of a column.
+     * @param column The column name or the summary label.
+     * @return The tolerance.
+     */
+    Tolerance get(const std::string& column) const;
+
+private:
+    Tolerance defaultTolerance;
+    std::map<std::string, Tolerance> columns;
+};
+
+/** The largest deviation of a column */
+struct ColumnDeviation {
+    std::string column;
+    /** The largest absolute deviation */
+    double maxAbs = 0.0;
+    /** The largest relative deviation */
+    double maxRel = 0.0;
+    /** The number of values out of the tolerance */
+    long long failures = 0;
+};
+
+/** The outcome of comparing two outputs */
+struct Comparison {
+    /** True if every value is within its tolerance */
+    bool passed = true;
+    /** The reason the outputs could not be compared, or differ in shape */
+    std::string error;
+    /** The number of rows or values compared */
+    long long compared = 0;
+    /** The deviations of the compared columns */
+    Vector<ColumnDeviation> columns;
+
+    /**
+     * @brief Gets the column with the largest relative deviation.
+     * @return The deviation, an empty one if no column is compared.
+     */
+    ColumnDeviation getMaxDeviation() const;
+
+    /**
+     * @brief Converts the comparison to JSON.
+     * @return The JSON object.
+     */
+    QJsonObject toJson() const;
+};
+
+/**
+ * @brief Compares two trajectory CSV files.
+ * @param baselineFile The baseline trajectory.
+ * @param currentFile The current trajectory.
+ * @param tolerances The tolerances of the columns.
+ * @return The comparison.
+ */
+Comparison compareTrajectories(const QString& baselineFile,
+                               const QString& currentFile,
+                               const Tolerances& tolerances);
+
+/**
+ * @brief Compares two summary files. The lines holding 'label : value' are
+ *        compared, the numbers may have thousands separators and the
+ *        other values must be equal.
+ * @param baselineFile The baseline summary.
+ * @param currentFile The current summary.
+ * @param tolerances The tolerances of the labels.
+ * @return The comparison.
+ */
+Comparison compareSummaries(const QString& baselineFile,
+                            const QString& currentFile,
+                            const Tolerances& tolerances);
+
+}
+
+#endif // RESULTCOMPARATOR_H
@@ -0,0 +1,232 @@
+#include "scenariogenerator.h"
+#include <cmath>
+#include <numbers>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+/**
+ * @brief Builds the nodes and the links of a generated network.
+ */
+class NetworkBuilder {
+public:
+    NetworkBuilder(const ScenarioGenerator::ScenarioConfig& config,
+                   ScenarioGenerator::Scenario& scenario)
+        : config(config), scenario(scenario) {}
+
+    /**
+     * @brief Adds a node.
+     * @return The user ID of the node.
+     */
+    int addNode(double x, double y) {
+        int simulatorID = this->scenario.nodes.size();
+        this->scenario.nodes.push_back(std::make_shared<NetNode>(
+            simulatorID, simulatorID + 1, x, y, "ND", 1.0, 1.0));
+        return simulatorID + 1;
+    }
+
+    /**
+     * @brief Adds a two directions link, its length is set by the network
+     *        from the nodes coordinates.
+     * @param withSignals True to add a signal at both ends of the link.
+     */
+    void addLink(int fromNodeID, int toNodeID, bool withSignals) {
+        std::shared_ptr<NetNode> fromNode =
+            this->scenario.nodes.at(fromNodeID - 1);
+        std::shared_ptr<NetNode> toNode =
+            this->scenario.nodes.at(toNodeID - 1);
+        int simulatorID = this->scenario.links.size();
+        this->scenario.links.push_back(std::make_shared<NetLink>(
+            simulatorID, simulatorID + 1, fromNode, toNode,
+            this->config.linkLength, this->config.linkSpeed,
+            withSignals && this->config.withSignals ? 1 : 0, "",
+            0.0, 0.0, 2, 0.2, false, "ND", 1.0, 1.0));
+    }
+
+private:
+    const ScenarioGenerator::ScenarioConfig& config;
+    ScenarioGenerator::Scenario& scenario;
+};
+
+Map<std::string, std::any> getTrainRecord(
+    const ScenarioGenerator::ScenarioConfig& config, int index,
+    int originNodeID, int destinationNodeID) {
+    // the consist of the sample project, diesel locomotives and cargo cars
+    Map<std::string, std::string> locomotives;
+    locomotives["Count"] = std::to_string(config.locomotives);
+    locomotives["Power"] = "4287.774";
+    locomotives["TransmissionEff"] = "0.82";
+    locomotives["NoOfAxles"] = "6";
+    locomotives["AirDragCoeff"] = "0.0024";
+    locomotives["FrontalArea"] = "14.8645";
+    locomotives["Length"] = "23";
+    locomotives["GrossWeight"] = "195";
+    locomotives["Type"] = "0";
+
+    Map<std::string, std::string> cars;
+    cars["Count"] = std::to_string(config.cars);
+    cars["NoOfAxles"] = "4";
+    cars["AirDragCoeff"] = "0.0005";
+    cars["FrontalArea"] = "11.1484";
+    cars["Length"] = "17";
+    cars["GrossWeight"] = "100";
+    cars["TareWeight"] = "25";
+    cars["Type"] = "0";
+
+    Map<std::string, std::any> record;
+    record["UserID"] = std::string("T") + std::to_string(index + 1);
+    // the simulator finds the shortest path between the two nodes
+    record["TrainPathOnNodeIDs"] =
+        Vector<int>({originNodeID, destinationNodeID});
+    record["LoadTime"] = index * config.headway;
+    record["FrictionCoef"] = 0.25;
+    record["Locomotives"] =
+        Vector<Map<std::string, std::string>>({locomotives});
+    record["Cars"] = config.cars > 0 ?
+        Vector<Map<std::string, std::string>>({cars}) :
+        Vector<Map<std::string, std::string>>();
+    record["Optimize"] = false;
+    return record;
+}
+
+void generateGrid(const ScenarioGenerator::ScenarioConfig& config,
+                  ScenarioGenerator::Scenario& scenario) {
+    NetworkBuilder builder(config, scenario);
+    int n = config.size;
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            builder.addNode(c * config.linkLength, r * config.linkLength);
+        }
+    }
+    auto nodeID = [n](int r, int c) { return r * n + c + 1; };
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            if (c + 1 < n) { builder.addLink(nodeID(r, c), nodeID(r, c + 1), true); }
+            if (r + 1 < n) { builder.addLink(nodeID(r, c), nodeID(r + 1, c), true); }
+        }
+    }
+
+    // the trains run between two random nodes of the grid boundary
+    Vector<int> boundary;
+    for (int r = 0; r < n; r++) {
+        for (int c = 0; c < n; c++) {
+            if (r == 0 || c == 0 || r == n - 1 || c == n - 1) {
+                boundary.push_back(nodeID(r, c));
+            }
+        }
+    }
+    std::mt19937 random(config.seed);
+    std::uniform_int_distribution<int> pick(0, boundary.size() - 1);
+    for (int t = 0; t < config.trains; t++) {
+        int origin = boundary[pick(random)];
+        int destination = origin;
+        while (destination == origin) { destination = boundary[pick(random)]; }
+        scenario.trainRecords.push_back(
+            getTrainRecord(config, t, origin, destination));
+    }
+}
+
+void generateCorridor(const ScenarioGenerator::ScenarioConfig& config,
+                      ScenarioGenerator::Scenario& scenario) {
+    NetworkBuilder builder(config, scenario);
+    int n = config.size;
+    for (int i = 0; i <= n; i++) {
+        builder.addNode(i * config.linkLength, 0.0);
+    }
+    for (int i = 0; i < n; i++) {
+        bool hasSiding = config.sidingEvery > 0 &&
+                         (i + 1) % config.sidingEvery == 0;
+        builder.addLink(i + 1, i + 2, hasSiding);
+        if (hasSiding) {
+            // the siding leaves and joins the main track at the link ends
+            int sidingNode = builder.addNode(
+                (i + 0.5) * config.linkLength, 0.1 * config.linkLength);
+            builder.addLink(i + 1, sidingNode, true);
+            builder.addLink(sidingNode, i + 2, true);
+        }
+    }
+
+    // the trains alternate between the two directions
+    for (int t = 0; t < config.trains; t++) {
+        bool isEastbound = t % 2 == 0;
+        scenario.trainRecords.push_back(
+            getTrainRecord(config, t, isEastbound ? 1 : n + 1,
+                           isEastbound ? n + 1 : 1));
+    }
+}
+
+void generateHubAndSpoke(const ScenarioGenerator::ScenarioConfig& config,
+                         ScenarioGenerator::Scenario& scenario) {
+    NetworkBuilder builder(config, scenario);
+    int hub = builder.addNode(0.0, 0.0);
+    Vector<int> spokeEnds;
+    for (int s = 0; s < config.size; s++) {
+        double angle = 2.0 * std::numbers::pi * s / config.size;
+        int previous = hub;
+        for (int j = 1; j <= config.spokeSegments; j++) {
+            int node = builder.addNode(
+                std::cos(angle) * j * config.linkLength,
+                std::sin(angle) * j * config.linkLength);
+            builder.addLink(previous, node, previous == hub);
+            previous = node;
+        }
+        spokeEnds.push_back(previous);
+    }
+
+    // the trains leave every spoke in turn to another random spoke
+    std::mt19937 random(config.seed);
+    std::uniform_int_distribution<int> pick(0, config.size - 1);
+    for (int t = 0; t < config.trains; t++) {
+        int origin = t % config.size;
+        int destination = origin;
+        while (destination == origin) { destination = pick(random); }
+        scenario.trainRecords.push_back(
+            getTrainRecord(config, t, spokeEnds[origin],
+                           spokeEnds[destination]));
+    }
+}
+
+}
+
+bool ScenarioGenerator::parseTopology(const std::string& name,
+                                      Topology& topology) {
+    if (name == "grid") { topology = Topology::Grid; }
+    else if (name == "corridor") { topology = Topology::Corridor; }
+    else if (name == "hub") { topology = Topology::HubAndSpoke; }
+    else { return false; }
+    return true;
+}
+
+std::string ScenarioGenerator::getTopologyName(Topology topology) {
+    switch (topology) {
+    case Topology::Grid: return "grid";
+    case Topology::Corridor: return "corridor";
+    case Topology::HubAndSpoke: return "hub";
+    }
+    return "unknown";
+}
+
+ScenarioGenerator::Scenario ScenarioGenerator::generate(
+    const ScenarioConfig& config) {
+    if (config.size < 2 || config.linkLength <= 0.0 ||
+        config.linkSpeed <= 0.0 || config.spokeSegments < 1 ||
+        config.trains < 1 || config.locomotives < 1 || config.cars < 0) {
+        throw std::runtime_error("The scenario parameters cannot build a "
+                                 "network with trains!");
+    }
+
+    Scenario scenario;
+    switch (config.topology) {
+    case Topology::Grid:
+        generateGrid(config, scenario);
+        break;
+    case Topology::Corridor:
+        generateCorridor(config, scenario);
+        break;
+    case Topology::HubAndSpoke:
+        generateHubAndSpoke(config, scenario);
+        break;
+    }
+    return scenario;
+}
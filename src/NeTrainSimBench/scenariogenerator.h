@@ -0,0 +1,92 @@
+/**
+ * @file ScenarioGenerator.h
+ * @brief This file declares the synthetic scenarios the benchmarks run.
+ *        A scenario is a generated network (a grid, a single track
+ *        corridor with sidings or a hub and spokes) and the records of N
+ *        trains with a configurable consist, built in memory and passed
+ *        to the Network and TrainsList::generateTrains directly.
+ */
+#ifndef SCENARIOGENERATOR_H
+#define SCENARIOGENERATOR_H
+
+#include "network/netlink.h"
+#include "network/netnode.h"
+#include "util/map.h"
+#include "util/vector.h"
+#include <any>
+#include <memory>
+#include <string>
+
+namespace ScenarioGenerator {
+
+/** The shapes of the generated networks */
+enum class Topology {
+    /** size x size nodes, every node linked to its 4 neighbours */
+    Grid,
+    /** size single track links with a siding every sidingEvery links */
+    Corridor,
+    /** size spokes of spokeSegments links around a hub node */
+    HubAndSpoke
+};
+
+/** The parameters of a generated scenario */
+struct ScenarioConfig {
+    Topology topology = Topology::Grid;
+    /** The grid side, the corridor links or the number of spokes */
+    int size = 10;
+    /** The length of a link in meters */
+    double linkLength = 1000.0;
+    /** The free flow speed of the links in m/s */
+    double linkSpeed = 25.0;
+    /** The number of corridor links between two sidings */
+    int sidingEvery = 5;
+    /** The number of links of a spoke */
+    int spokeSegments = 5;
+    /** True to add signals to the links */
+    bool withSignals = true;
+    /** The number of trains */
+    int trains = 10;
+    /** The number of locomotives of a train */
+    int locomotives = 2;
+    /** The number of cars of a train */
+    int cars = 50;
+    /** The time in seconds between two train departures */
+    double headway = 60.0;
+    /** The seed of the trains origins and destinations */
+    unsigned int seed = 1;
+};
+
+/** A generated network and its trains records */
+struct Scenario {
+    Vector<std::shared_ptr<NetNode>> nodes;
+    Vector<std::shared_ptr<NetLink>> links;
+    /** The records passed to TrainsList::generateTrains */
+    Vector<Map<std::string, std::any>> trainRecords;
+};
+
+/**
+ * @brief Parses a topology name.
+ * @param name 'grid', 'corridor' or 'hub'.
+ * @param topology The parsed topology.
+ * @return true if the name is a topology.
+ */
+bool parseTopology(const std::string& name, Topology& topology);
+
+/**
+ * @brief Gets the name of a topology.
+ * @param topology The topology.
+ * @return The topology name.
+ */
+std::string getTopologyName(Topology topology);
+
+/**
+ * @brief Generates a scenario.
+ * @param config The scenario parameters.
+ * @return The network nodes and links and the trains records.
+ * @throws std::runtime_error if the parameters cannot build a network.
+ */
+Scenario generate(const ScenarioConfig& config);
+
+}
+
+#endif // SCENARIOGENERATOR_H
@@ -8,6 +8,7 @@
 #include "network/network.h"
 #include "simulator.h"
 #include "util/vector.h"
+#include "util/tracerecorder.h"
 #include <iostream>
 #include <sstream>
 #include <QCoreApplication>
@@ -133,6 +134,42 @@ int main(int argc, char *argv[])
                                                              QCoreApplication::translate("main", "[Optional] the speed priority factor in case of optimization. \n Default is '0.0'."), "OptimizationSpeedFactor", "0.0");
     parser.addOption(optimizationSpeedPriorityFactor);
 
+    const QCommandLineOption threadsOption(QStringList() << "j" << "threads",
+                                           QCoreApplication::translate("main", "[Optional] the number of threads stepping the trains, 0 uses all cores. \nDefault is '1'."), "threads", "1");
+    parser.addOption(threadsOption);
+
+    const QCommandLineOption trajectoryBufferOption(QStringList() << "b" << "trajectoryBuffer",
+                                                    QCoreApplication::translate("main", "[Optional] the number of trajectory records queued for the background writer. \nDefault is '8192'."), "trajectoryBuffer", "8192");
+    parser.addOption(trajectoryBufferOption);
+
+    const QCommandLineOption trajectoryFormatOption(QStringList() << "f" << "trajectoryFormat",
+                                                    QCoreApplication::translate("main", "[Optional] the instantaneous trajectory file format, 'csv', 'binary' or 'sqlite'. \nDefault is 'csv'."), "trajectoryFormat", "csv");
+    parser.addOption(trajectoryFormatOption);
+
+    const QCommandLineOption trajectoryColumnsOption(QStringList() << "c" << "trajectoryColumns",
+                                                     QCoreApplication::translate("main", "[Optional] comma separated names of the exported trajectory columns, e.g. 'TStep_s,TravelledDistance_m,Speed_mps,EnergyConsumption_KWH'. \nDefault is all the columns."), "trajectoryColumns", "");
+    parser.addOption(trajectoryColumnsOption);
+
+    const QCommandLineOption trajectoryIntervalOption(QStringList() << "r" << "trajectoryInterval",
+                                                      QCoreApplication::translate("main", "[Optional] the simulation time in seconds between two exported trajectory rows of a train, 0 exports every time step. \nDefault is '0'."), "trajectoryInterval", "0");
+    parser.addOption(trajectoryIntervalOption);
+
+    const QCommandLineOption trajectoryOnChangeOption(QStringList() << "g" << "trajectoryOnChange",
+                                                      QCoreApplication::translate("main", "[Optional] bool to export a trajectory row only when the notch or the acceleration sign of a train changes. \nDefault is 'false'."), "trajectoryOnChange", "false");
+    parser.addOption(trajectoryOnChangeOption);
+
+    const QCommandLineOption compressOutputOption(QStringList() << "x" << "compress",
+                                                  QCoreApplication::translate("main", "[Optional] bool to write the CSV trajectory and the summary files block compressed (.ntz). \nDefault is 'false'."), "compress", "false");
+    parser.addOption(compressOutputOption);
+
+    const QCommandLineOption profileStepsOption(QStringList() << "q" << "profile",
+                                                QCoreApplication::translate("main", "[Optional] bool to time the phases of every simulation step and write them to 'stepProfile_timeStamp.json' in the output folder. \nDefault is 'false'."), "profile", "false");
+    parser.addOption(profileStepsOption);
+
+    const QCommandLineOption traceOption(QStringList() << "w" << "trace",
+                                         QCoreApplication::translate("main", "[Optional] bool to record a Chrome trace-event timeline of the run to 'simulationTrace_timeStamp.json' in the output folder. \nDefault is 'false'."), "trace", "false");
+    parser.addOption(traceOption);
+
     // process all the arguments
     parser.process(app);
 
@@ -158,6 +195,13 @@ int main(int argc, char *argv[])
     double optimize_speedfactor = 0.0;
     int optimizerFrequency = 0;
     int lookahead = 0;
+    int threadsCount = 1;
+    int trajectoryBufferSize = TrajectoryWriter::DefaultBufferSize;
+    TrajectoryWriter::Format trajectoryFormat = TrajectoryWriter::Format::CSV;
+    TrajectoryWriter::ExportConfig trajectoryExportConfig;
+    bool compressOutput = false;
+    bool profileSteps = false;
+    bool recordTrace = false;
 
     // read values from the cmd
     // read required values
@@ -210,6 +254,58 @@ int main(int argc, char *argv[])
     if (checkParserValue(parser, optimizationSpeedPriorityFactor, "", 0.0)) {optimize_speedfactor = parser.value(optimizationSpeedPriorityFactor).toDouble(); }
     else { optimize_speedfactor = 0.0;}
 
+    if (checkParserValue(parser, threadsOption, "", false)) { threadsCount = parser.value(threadsOption).toInt(); }
+    else { threadsCount = 1; }
+
+    if (checkParserValue(parser, trajectoryBufferOption, "", false)) { trajectoryBufferSize = parser.value(trajectoryBufferOption).toInt(); }
+    else { trajectoryBufferSize = TrajectoryWriter::DefaultBufferSize; }
+
+    if (checkParserValue(parser, trajectoryFormatOption, "", false)) {
+        QString format = parser.value(trajectoryFormatOption).trimmed().toLower();
+        if (format == "binary") { trajectoryFormat = TrajectoryWriter::Format::Binary; }
+        else if (format == "csv") { trajectoryFormat = TrajectoryWriter::Format::CSV; }
+        else if (format == "sqlite") { trajectoryFormat = TrajectoryWriter::Format::SQLite; }
+        else {
+            fputs(qPrintable("trajectory format is not valid!"), stdout);
+            return 1;
+        }
+    }
+    else { trajectoryFormat = TrajectoryWriter::Format::CSV; }
+
+    if (checkParserValue(parser, trajectoryColumnsOption, "", false)) {
+        for (const QString &column : parser.value(trajectoryColumnsOption).split(",", Qt::SkipEmptyParts)) {
+            trajectoryExportConfig.columns.push_back(column.trimmed().toStdString());
+        }
+    }
+
+    if (checkParserValue(parser, trajectoryIntervalOption, "", false)) { trajectoryExportConfig.decimationInterval = parser.value(trajectoryIntervalOption).toDouble(); }
+    else { trajectoryExportConfig.decimationInterval = 0.0; }
+
+    if (checkParserValue(parser, trajectoryOnChangeOption, "", false)){
+        stringstream ss(parser.value(trajectoryOnChangeOption).toStdString());
+        ss >> std::boolalpha >> trajectoryExportConfig.onChangeOnly;
+    }
+    else { trajectoryExportConfig.onChangeOnly = false; }
+
+    if (checkParserValue(parser, compressOutputOption, "", false)){
+        stringstream ss(parser.value(compressOutputOption).toStdString());
+        ss >> std::boolalpha >> compressOutput;
+    }
+    else { compressOutput = false; }
+
+    if (checkParserValue(parser, profileStepsOption, "", false)){
+        stringstream ss(parser.value(profileStepsOption).toStdString());
+        ss >> std::boolalpha >> profileSteps;
+    }
+    else { profileSteps = false; }
+
+    if (checkParserValue(parser, traceOption, "", false)){
+        stringstream ss(parser.value(traceOption).toStdString());
+        ss >> std::boolalpha >> recordTrace;
+    }
+    else { recordTrace = false; }
+    TraceRecorder::instance().setEnabled(recordTrace);
+
     try {
         std::cout << "Reading Trains!                 \r";
 
@@ -240,7 +336,14 @@ int main(int argc, char *argv[])
         if (summaryFilename != "" ) { sim->setSummaryFilename(summaryFilename); }
 
         sim->setExportInstantaneousTrajectory(exportInstaTraj,
-                                              instaTrajFilename);
+                                              instaTrajFilename,
+                                              trajectoryExportConfig);
+
+        sim->setThreadsCount(threadsCount);
+        sim->setTrajectoryBufferSize(trajectoryBufferSize);
+        sim->setTrajectoryFormat(trajectoryFormat);
+        sim->setCompressOutput(compressOutput);
+        sim->setProfileSteps(profileSteps);
 
         // run the actual simulation
         std::cout <<"Starting the Simulator!                                "
@@ -248,6 +351,16 @@ int main(int argc, char *argv[])
         sim->runSimulation();
         std::cout << "Output folder: " << sim->getOutputFolder() << std::endl;
 
+        if (recordTrace) {
+            auto now = std::chrono::system_clock::now();
+            auto serial_number = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+            QString traceFile = QDir(QString::fromStdString(sim->getOutputFolder())).filePath(
+                "simulationTrace_" + QString::number(serial_number) + ".json");
+            if (!TraceRecorder::instance().writeJson(traceFile)) {
+                ErrorHandler::showWarning("Could not write the trace file!");
+            }
+        }
+
         // qDebug() << "\nType name for 65537:" << QMetaType::typeName(65537);
     } catch (const std::exception& e) {
         ErrorHandler::showError(e.what());
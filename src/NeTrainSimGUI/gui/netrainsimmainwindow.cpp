@@ -11,6 +11,7 @@
 #include "gui/ui_netrainsimmainwindow.h"
 #include "nonemptydelegate.h"
 #include "../NeTrainSim/util/csvmanager.h"
+#include "../NeTrainSim/util/trajectoryreader.h"
 // #include "ui_netrainsimmainwindow.h"
 #include <iostream>
 #include <QtAlgorithms>
@@ -2628,90 +2629,135 @@ void NeTrainSim::showDetailedReport(QString trajectoryFilename) {
         return;
     }
     std::shared_ptr<CSVManager> CSV = std::make_shared<CSVManager>();
-    auto df = CSV->readCSV(trajectoryFilename, "," , true);
-    auto ids = CSV->getDistinctColumnValues(0);   // get all file train ID's
+    // the binary trajectory files are read one train column at a time
+    std::shared_ptr<TrajectoryReader> reader =
+        std::make_shared<TrajectoryReader>();
+    QVector<QVector<QString>> df;
+    QStringList ids;
+    if (TrajectoryReader::isBinaryTrajectoryFile(trajectoryFilename)) {
+        if (!reader->open(trajectoryFilename)) {
+            ui->tabWidget_results->setTabVisible(1, false);
+            return;
+        }
+        for (const std::string &id : reader->getTrainIDs()) {
+            ids.append(QString::fromStdString(id));
+        }
+        ids.sort();
+    }
+    else {
+        df = CSV->readCSV(trajectoryFilename, "," , true);
+        ids = CSV->getDistinctColumnValues(0);   // get all file train ID's
+    }
 
     this->ui->comboBox_trainsResults->clear();
     this->ui->comboBox_trainsResults->addItem(QString("--"));
     this->ui->comboBox_trainsResults->addItems(ids);
 
-    auto updateResultsCurves = [&CSV, df, this]() {
+    auto updateResultsCurves = [CSV, reader, df, this]() {
         if (ui->comboBox_trainsResults->currentText() == "--") {
             return;
         }
-        auto selectedTrain =
-            CSV->filterByColumn(df, 0,
-                                ui->comboBox_trainsResults->currentText());
-        int columnNumber =
-            ui->comboBox_resultsXAxis->currentText() == "Distance" ? 2 : 1;
-        QString xAxisLabel = ui->comboBox_resultsXAxis->currentText() ==
-                                     "Distance" ? "Distance (km)" :
-                                 "Time (hr)";
-        double xDataFactor = ui->comboBox_resultsXAxis->currentText() ==
-                                     "Distance" ? 1.0/1000 : 1.0 / 3600.0;
+        QString trainID = ui->comboBox_trainsResults->currentText();
+        QVector<QVector<QString>> selectedTrain;
+        if (!reader->isOpen()) {
+            selectedTrain = CSV->filterByColumn(df, 0, trainID);
+        }
+        // the columns are looked up by name, the file may hold a subset of
+        // them
+        auto getColumnIndex = [&](const std::string &name) {
+            if (reader->isOpen()) {
+                return reader->getColumnIndex(name);
+            }
+            return CSV->getColumnIndex(QString::fromStdString(name));
+        };
+        auto hasColumn = [&](const std::string &name) {
+            return getColumnIndex(name) >= 0;
+        };
+        auto getColumn = [&](const std::string &name) {
+            if (reader->isOpen()) {
+                std::vector<double> values = reader->readColumn(
+                    trainID.toStdString(), getColumnIndex(name));
+                return QVector<double>(values.begin(), values.end());
+            }
+            return Utils::convertQStringVectorToDouble(
+                CSV->getColumnValues(selectedTrain, getColumnIndex(name)));
+        };
+        bool isDistance =
+            ui->comboBox_resultsXAxis->currentText() == "Distance";
+        std::string xColumnName =
+            isDistance ? "TravelledDistance_m" : "TStep_s";
+        if (!hasColumn(xColumnName)) {
+            return;
+        }
+        QString xAxisLabel = isDistance ? "Distance (km)" : "Time (hr)";
+        double xDataFactor = isDistance ? 1.0/1000 : 1.0 / 3600.0;
         auto xData = Utils::factorQVector(
-            Utils::convertQStringVectorToDouble(
-                CSV->getColumnValues(selectedTrain, columnNumber)),
-            xDataFactor);
-        auto grades =
-            Utils::convertQStringVectorToDouble(
-                CSV->getColumnValues(selectedTrain, 13));
-        auto curvatures =
-            Utils::convertQStringVectorToDouble(
-                CSV->getColumnValues(selectedTrain, 14));
-        auto speeds =
-            Utils::factorQVector(
-                Utils::convertQStringVectorToDouble(
-                    CSV->getColumnValues(selectedTrain, 4)), 3.6);
-        auto accelerations =
-            Utils::convertQStringVectorToDouble(
-                CSV->getColumnValues(selectedTrain, 3));
-        auto EC =
-            Utils::convertQStringVectorToDouble(
-                CSV->getColumnValues(selectedTrain, 6));
-        auto tractiveForces =
-            Utils::factorQVector(
-                Utils::convertQStringVectorToDouble(
-                    CSV->getColumnValues(selectedTrain, 10)), 1.0/1000.0);
-        auto resistance =
-            Utils::factorQVector(
-                Utils::convertQStringVectorToDouble(
-                    CSV->getColumnValues(selectedTrain, 11)), 1.0/1000.0);
-        auto totalForces =
-            Utils::subtractQVector(tractiveForces, resistance);
-
-        this->drawLineGraph(
-            *ui->plot_trajectory_grades, xData, grades,
-            xAxisLabel, "Percentage", "Grades", 0);
-        this->drawLineGraph(
-            *ui->plot_trajectory_grades, xData, curvatures,
-            xAxisLabel, "Percentage", "Curvatures", 1);
-        this->drawLineGraph(
-            *ui->plot_trajectory_speed, xData, speeds,
-            xAxisLabel, "Speed (km/h)", "Speed", 0);
-        this->drawLineGraph(
-            *ui->plot_trajectory_acceleration, xData,
-            accelerations, xAxisLabel, "Accelerations (m/s^2)",
-            "Acceleration", 0);
-        this->drawLineGraph(
-            *ui->plot_trajectory_EC, xData, EC, xAxisLabel,
-            "Energy Consumption (kWh)", "Energy", 0);
-
-        this->drawLineGraph(
-            *ui->plot_forces_grades, xData, grades, xAxisLabel,
-            "Percentage", "Grades", 0);
-        this->drawLineGraph(
-            *ui->plot_forces_grades, xData, curvatures, xAxisLabel,
-            "Percentage", "Curvatures", 1);
-        this->drawLineGraph(
-            *ui->plot_forces_tractiveForces, xData, tractiveForces,
-            xAxisLabel, "Forces", "Tractive Forces (kN)", 0);
-        this->drawLineGraph(
-            *ui->plot_forces_resistance, xData, resistance, xAxisLabel,
-            "Forces", "Resistance (kN)", 0);
-        this->drawLineGraph(
-            *ui->plot_forces_totalForces, xData, totalForces, xAxisLabel,
-            "Forces", "Net Forces (kN)", 0);
+            getColumn(xColumnName), xDataFactor);
+
+        if (hasColumn("GradeAtTip_Perc")) {
+            auto grades = getColumn("GradeAtTip_Perc");
+            this->drawLineGraph(
+                *ui->plot_trajectory_grades, xData, grades,
+                xAxisLabel, "Percentage", "Grades", 0);
+            this->drawLineGraph(
+                *ui->plot_forces_grades, xData, grades, xAxisLabel,
+                "Percentage", "Grades", 0);
+        }
+        if (hasColumn("CurvatureAtTip_Perc")) {
+            auto curvatures = getColumn("CurvatureAtTip_Perc");
+            this->drawLineGraph(
+                *ui->plot_trajectory_grades, xData, curvatures,
+                xAxisLabel, "Percentage", "Curvatures", 1);
+            this->drawLineGraph(
+                *ui->plot_forces_grades, xData, curvatures, xAxisLabel,
+                "Percentage", "Curvatures", 1);
+        }
+        if (hasColumn("Speed_mps")) {
+            auto speeds =
+                Utils::factorQVector(getColumn("Speed_mps"), 3.6);
+            this->drawLineGraph(
+                *ui->plot_trajectory_speed, xData, speeds,
+                xAxisLabel, "Speed (km/h)", "Speed", 0);
+        }
+        if (hasColumn("Acceleration_mps2")) {
+            auto accelerations = getColumn("Acceleration_mps2");
+            this->drawLineGraph(
+                *ui->plot_trajectory_acceleration, xData,
+                accelerations, xAxisLabel, "Accelerations (m/s^2)",
+                "Acceleration", 0);
+        }
+        if (hasColumn("EnergyConsumption_KWH")) {
+            auto EC = getColumn("EnergyConsumption_KWH");
+            this->drawLineGraph(
+                *ui->plot_trajectory_EC, xData, EC, xAxisLabel,
+                "Energy Consumption (kWh)", "Energy", 0);
+        }
+
+        bool hasTractiveForces = hasColumn("tractiveForce_N");
+        bool hasResistance = hasColumn("ResistanceForces_N");
+        QVector<double> tractiveForces;
+        QVector<double> resistance;
+        if (hasTractiveForces) {
+            tractiveForces = Utils::factorQVector(
+                getColumn("tractiveForce_N"), 1.0/1000.0);
+            this->drawLineGraph(
+                *ui->plot_forces_tractiveForces, xData, tractiveForces,
+                xAxisLabel, "Forces", "Tractive Forces (kN)", 0);
+        }
+        if (hasResistance) {
+            resistance = Utils::factorQVector(
+                getColumn("ResistanceForces_N"), 1.0/1000.0);
+            this->drawLineGraph(
+                *ui->plot_forces_resistance, xData, resistance, xAxisLabel,
+                "Forces", "Resistance (kN)", 0);
+        }
+        if (hasTractiveForces && hasResistance) {
+            auto totalForces =
+                Utils::subtractQVector(tractiveForces, resistance);
+            this->drawLineGraph(
+                *ui->plot_forces_totalForces, xData, totalForces, xAxisLabel,
+                "Forces", "Net Forces (kN)", 0);
+        }
     };
 
     connect(ui->comboBox_trainsResults,
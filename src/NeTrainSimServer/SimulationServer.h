@@ -55,6 +55,11 @@ public:
     void
     stopRabbitMQServer(); // stop RabbitMQ server cleanly
 
+    // Enables the trace recorder and sets the Chrome trace
+    // file written after each endSimulator command and when
+    // the server is destroyed
+    void setTraceFilename(const QString &filename);
+
 signals:
     void dataReceived(QJsonObject message);
     void trainReachedDestination(const QString &trainID);
@@ -118,6 +123,9 @@ private:
     QMetaObject::Connection m_progressConnection;
 
     QString commandID;
+    QString mTraceFilename;
+
+    void writeTrace();
 
     void loadRabbitMQConfig();
     void processCommand(const QJsonObject &jsonMessage);
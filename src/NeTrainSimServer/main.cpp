@@ -59,6 +59,14 @@ int main(int argc, char *argv[]) {
         "5672");
     parser.addOption(portOption);
 
+    // Add trace option
+    QCommandLineOption traceOption(
+        QStringList() << "t" << "trace",
+        "Chrome trace-event JSON file of the server and "
+        "simulator spans (default: disabled).",
+        "trace");
+    parser.addOption(traceOption);
+
     // Process the command-line arguments
     parser.process(app);
 
@@ -66,6 +74,11 @@ int main(int argc, char *argv[]) {
     // Server loads config from NeTrainSim_rabbitmq.xml in constructor
     SimulationServer server;
 
+    if (parser.isSet(traceOption))
+    {
+        server.setTraceFilename(parser.value(traceOption));
+    }
+
     // CLI arguments override config file values only if explicitly set
     std::string hostname = "localhost";
     int         port     = 5672;
@@ -4,6 +4,7 @@
 #include "qobjectdefs.h"
 #include "simulatorapi.h"
 #include "traindefinition/trainslist.h"
+#include "util/tracerecorder.h"
 #include "utils/serverutils.h"
 #include <QCoreApplication>
 #include <QDataStream>
@@ -14,6 +15,7 @@
 #include <QMap>
 #include <QNetworkInterface>
 #include <QStandardPaths>
+#include <QThread>
 #include <QTimer>
 #include <thread>
 #ifdef HAVE_QTKEYCHAIN
@@ -213,6 +215,26 @@ SimulationServer::~SimulationServer()
         mRabbitMQThread->quit();
         mRabbitMQThread->wait();
     }
+    writeTrace();
+}
+
+void SimulationServer::setTraceFilename(const QString &filename)
+{
+    mTraceFilename = filename;
+    TraceRecorder::instance().setEnabled(!filename.isEmpty());
+}
+
+void SimulationServer::writeTrace()
+{
+    if (mTraceFilename.isEmpty())
+    {
+        return;
+    }
+    if (!TraceRecorder::instance().writeJson(mTraceFilename))
+    {
+        qWarning() << "Could not write the trace file"
+                   << mTraceFilename;
+    }
 }
 
 void SimulationServer::startRabbitMQServer(
@@ -810,6 +832,10 @@ void SimulationServer::processCommand(
     }
     QString command = jsonMessage["command"].toString();
 
+    // the span covers the waits on the simulator thread
+    TraceRecorder::Span span(
+        "processCommand:" + command.toStdString(), "server");
+
     // Extract commandId if present
     if (jsonMessage.contains("commandId"))
     {
@@ -949,6 +975,77 @@ void SimulationServer::processCommand(
             onErrorOccurred(error);
             return;
         }
+
+        // Configure the trajectory export if requested, e.g.
+        // "trajectory": {"export": true, "filename": "",
+        // "columns": ["TStep_s", "Speed_mps"],
+        // "decimationInterval": 10, "onChangeOnly": false}
+        QJsonValue trajectoryValue =
+            getJsonValue(jsonMessage, "trajectory");
+        if (trajectoryValue.isObject())
+        {
+            QJsonObject trajectory = trajectoryValue.toObject();
+            TrajectoryWriter::ExportConfig exportConfig;
+            for (const QJsonValue &column :
+                 trajectory.value("columns").toArray())
+            {
+                exportConfig.columns.push_back(
+                    column.toString().toStdString());
+            }
+            exportConfig.decimationInterval =
+                trajectory.value("decimationInterval")
+                    .toDouble(0.0);
+            exportConfig.onChangeOnly =
+                trajectory.value("onChangeOnly").toBool(false);
+            bool exportTrajectory =
+                trajectory.value("export").toBool(true);
+            std::string trajectoryFilename =
+                trajectory.value("filename")
+                    .toString()
+                    .toStdString();
+
+            Simulator *simulator =
+                SimulatorAPI::InteractiveMode::getSimulator(
+                    netName);
+            if (!simulator)
+            {
+                onErrorOccurred(
+                    "Simulator not found for network: "
+                    + netName);
+                return;
+            }
+
+            // The simulator is configured in its own thread
+            QString error;
+            QMetaObject::invokeMethod(
+                simulator,
+                [&]() {
+                    try
+                    {
+                        simulator
+                            ->setExportInstantaneousTrajectory(
+                                exportTrajectory,
+                                trajectoryFilename,
+                                exportConfig);
+                    }
+                    catch (const std::exception &e)
+                    {
+                        error = QString(e.what());
+                    }
+                },
+                simulator->thread() == QThread::currentThread()
+                    ? Qt::DirectConnection
+                    : Qt::BlockingQueuedConnection);
+            if (!error.isEmpty())
+            {
+                error = "Error while configuring the "
+                        "trajectory export: "
+                        + error;
+                qWarning() << error;
+                onErrorOccurred(error);
+                return;
+            }
+        }
     }
     else if (command == "runSimulator")
     {
@@ -1095,6 +1192,7 @@ void SimulationServer::processCommand(
                             + QString(e.what()));
             return;
         }
+        writeTrace();
     }
     else if (command == "addTrainsToSimulator")
     {